@@ -12,1585 +12,10465 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
 #include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <signal.h>
+
+// horizontal number of columns in the gameboard as a compile time constant so
+// it can be used to size the static tables below
+#define BOARD_COLUMNS 7
+// vertical number of rows in the gameboard as a compile time constant
+#define BOARD_ROWS 6
+// the number of pieces a player needs to connect to win
+#define CONNECT_LENGTH 4
+// the number of cells in the gameboard
+#define NUM_CELLS (BOARD_COLUMNS * BOARD_ROWS)
+// the number of winning lines of each kind that fit on the gameboard
+#define NUM_HORIZONTAL_LINES ((BOARD_COLUMNS - CONNECT_LENGTH + 1) * BOARD_ROWS)
+#define NUM_VERTICAL_LINES (BOARD_COLUMNS * (BOARD_ROWS - CONNECT_LENGTH + 1))
+#define NUM_DIAGONAL_LINES ((BOARD_COLUMNS - CONNECT_LENGTH + 1) * (BOARD_ROWS - CONNECT_LENGTH + 1))
+// the total number of winning lines (both diagonal directions are counted)
+#define NUM_LINES (NUM_HORIZONTAL_LINES + NUM_VERTICAL_LINES + 2 * NUM_DIAGONAL_LINES)
+// the most lines that can pass through one cell (4 directions, CONNECT_LENGTH offsets each)
+#define MAX_LINES_PER_CELL (4 * CONNECT_LENGTH)
+// the number of bits used for each column of a bitboard. Every column has one
+// spare bit on top so shifting a column upward never spills into the next column.
+#define BITBOARD_HEIGHT (BOARD_ROWS + 1)
+
+#if BITBOARD_HEIGHT * BOARD_COLUMNS > 64
+#error "the board does not fit in a 64 bit bitboard"
+#endif
+#if CONNECT_LENGTH != 4
+#error "the bitboard threat detection only supports connecting four"
+#endif
 
 // horizontal number of columns in the gameboard
-const int numColumns = 7;
+const int numColumns = BOARD_COLUMNS;
 // vertical number of rows in the gameboard
-const int numRows = 6;
+const int numRows = BOARD_ROWS;
+
+// every winning line on the board stored as the flattened cell indexes
+// (column * numRows + row) of the pieces that make up the line
+unsigned char lineCells[NUM_LINES][CONNECT_LENGTH];
+// for every cell, the indexes of the winning lines that pass through it
+unsigned char cellLines[NUM_CELLS][MAX_LINES_PER_CELL];
+// for every cell, the number of winning lines stored in cellLines
+unsigned char cellLineCount[NUM_CELLS];
+// a bitboard with the bottom cell of every column set
+uint64_t bottomMask = 0;
+// a bitboard with every cell of the gameboard set (the spare bits are not set)
+uint64_t boardMask = 0;
 
 /*
  * Purpose:
- *    To set every value of the game board array to O's to represent spaces on the board.
+ *      To fill the winning line tables once at start up so win checks and
+ *      evaluators can loop over precomputed cell indexes instead of recomputing
+ *      neighbours and bounds on every scan. The sizes of the tables are fixed at
+ *      compile time from the board size constants.
  * Parameters:
- *     gameBoard - the 2D array that stores every value in the game board
+ *      NONE
  * Returns:
  *      NONE
- * Side-Effects: The game board array is modified to set every index to a default value
+ * Side-Effects:
+ *      lineCells, cellLines and cellLineCount are filled in
  */
-void setGameBoard(char gameBoard[numColumns][numRows]) {
-    // counter for the index of the rows
-    int i = 0;
-    // counter for the index of the columns
-    int j = 0;
-    
-    // loop through the rows starting at row 0
-    while (i < numRows) {
-        // loop through each column and set the default value to 'O'
-        for (j = 0; j < numColumns; j++) {
-            gameBoard[j][i] = 'O';
+void initLineTables() {
+    // the column and row steps for horizontal, vertical, diagonal up-right
+    // and diagonal up-left lines
+    const int columnSteps[4] = {1, 0, 1, -1};
+    const int rowSteps[4] = {0, 1, 1, 1};
+    // the index of the next line to be added to the table
+    int line = 0;
+    // counters for the direction, the starting column/row and the piece in the line
+    int direction = 0;
+    int column = 0;
+    int row = 0;
+    int k = 0;
+    // the cell index of a piece in the line being added
+    int cell = 0;
+
+    for (cell = 0; cell < NUM_CELLS; cell++) {
+        cellLineCount[cell] = 0;
+    }
+
+    for (direction = 0; direction < 4; direction++) {
+        for (column = 0; column < BOARD_COLUMNS; column++) {
+            for (row = 0; row < BOARD_ROWS; row++) {
+                // the last piece of the line must still be on the board, otherwise
+                // no line of this direction starts at this cell
+                int endColumn = column + columnSteps[direction] * (CONNECT_LENGTH - 1);
+                int endRow = row + rowSteps[direction] * (CONNECT_LENGTH - 1);
+                if ((endColumn < 0) || (endColumn >= BOARD_COLUMNS) || (endRow >= BOARD_ROWS)) {
+                    continue;
+                }
+                // store each piece of the line and record the line against each cell
+                for (k = 0; k < CONNECT_LENGTH; k++) {
+                    cell = (column + columnSteps[direction] * k) * BOARD_ROWS + row + rowSteps[direction] * k;
+                    lineCells[line][k] = (unsigned char)cell;
+                    cellLines[cell][cellLineCount[cell]++] = (unsigned char)line;
+                }
+                line++;
+            }
         }
-        // increment the row counter by 1 to go up a row and continue setting
-        // default values to each index.
-        i++;
-    // end of loop setting default values
+    }
+
+    // build the bitboard masks one column at a time
+    bottomMask = 0;
+    boardMask = 0;
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        bottomMask |= (uint64_t)1 << (column * BITBOARD_HEIGHT);
+        boardMask |= (((uint64_t)1 << BOARD_ROWS) - 1) << (column * BITBOARD_HEIGHT);
     }
 }
 
 /*
  * Purpose:
- *    To print the game instructions
+ *      To find every empty cell that would complete four in a row for a player.
+ *      Each direction is handled with a few shifts of the whole bitboard so no
+ *      cells are looped over.
  * Parameters:
- *      NONE
+ *      pieces - the bitboard of the players pieces
+ *      occupied - the bitboard of every piece on the board
  * Returns:
- *      NONE
- * Side-Effects: 
+ *      A bitboard of the empty cells that win the game for the player if a piece
+ *      is played there. The cells do not have to be playable yet.
+ * Side-Effects:
  *      NONE
  */
-void printInstructions() {
-    // print the game rules and instructions
-    printf("Welcome to Connect Four!\n");
-    printf("The rules are simple. Drop your pieces into columns trying to get 4\n");
-    printf("in a row either vertically, horizontally, or diagonally, but be careful,\n");
-    printf("your goal is to connect four before your opponent does so your defense\n");
-    printf("must also be considered. Each player will alternate dropping pieces and\n");
-    printf("the game board will be printed after every move until the game ends.\n");
-    printf("The game ends when one player gets four in a row or the board\n");
-    printf("is full in which the game ends in a tie. Don't forget to have fun!\n");
-    printf("\n");
+uint64_t winningCells(const uint64_t pieces, const uint64_t occupied) {
+    // the cells that complete a line
+    uint64_t cells = 0;
+    // a pair of pieces next to each other in the direction being checked
+    uint64_t pair = 0;
+    // the shift for one step in each direction: up-left diagonal, horizontal, up-right diagonal
+    const int steps[3] = {BITBOARD_HEIGHT - 1, BITBOARD_HEIGHT, BITBOARD_HEIGHT + 1};
+    // the counter for the direction
+    int i = 0;
+
+    // vertical, the only open cell is directly above three pieces
+    cells = (pieces << 1) & (pieces << 2) & (pieces << 3);
+
+    for (i = 0; i < 3; i++) {
+        int step = steps[i];
+        // two pieces below/left of the cell, then the third piece is either
+        // further away or on the other side of the cell
+        pair = (pieces << step) & (pieces << (2 * step));
+        cells |= pair & (pieces << (3 * step));
+        cells |= pair & (pieces >> step);
+        // two pieces above/right of the cell
+        pair = (pieces >> step) & (pieces >> (2 * step));
+        cells |= pair & (pieces << step);
+        cells |= pair & (pieces >> (3 * step));
+    }
+
+    return cells & (boardMask ^ occupied);
 }
 
 /*
  * Purpose:
- *      To validate the users inputted game mode
+ *      To find the cells a piece can be dropped into, one per column that is not full
  * Parameters:
- *      gameMode - the variable that stores the users input on what gameMode they want to
- *      play as a character
+ *      occupied - the bitboard of every piece on the board
  * Returns:
- *      gameMode - the validated gameMode character
- * Side-Effects: 
+ *      A bitboard of the lowest empty cell of every column
+ * Side-Effects:
  *      NONE
  */
-char validateGamemode(char gameMode) {
-    // loop asking for the user to enter a new game mode until their input is a valid game mode
-    // u - for user, c - for computer, q - for quit
-    while ((gameMode != 'u') && (gameMode != 'c') && (gameMode != 'q')) {
-        printf("Your choice of '%c' is invalid.\n", gameMode);
-        printf("Would you like to play against another user or the computer?\n");
-        printf("Please enter u for user, c for computer, or q to quit: ");
-        scanf("%c", &gameMode);
-        fgetc(stdin);
-    }
-
-    return gameMode;
+uint64_t playableCells(const uint64_t occupied) {
+    // adding a bit to the bottom of each column carries up to the first empty cell
+    return (occupied + bottomMask) & boardMask;
 }
 
 /*
  * Purpose:
- *      To get the user to enter the game mode they would like to play
+ *      To get the column index of a cell in a bitboard
  * Parameters:
- *      NONE
+ *      cells - a bitboard with at least one cell set. The lowest cell is used.
  * Returns:
- *      gameMode - the game mode the user wants to play
+ *      The column index (0 - 6) of the cell
  * Side-Effects:
+ *      NONE
  */
-char selectGamemode() {
-    // variable to store the default value for the gameMode
-    char gameMode = 'x';
-    
-    // ask the user to enter the gamemode they would like to play
-    printf("Would you like to play against another user or the computer?\n");
-    printf("Please enter u for user, c for computer or q to quit: ");
-    scanf("%c", &gameMode);
-    fgetc(stdin);
-    // validate the gamemode
-    gameMode = validateGamemode(gameMode);
-
-    return gameMode;
+int bitboardColumn(const uint64_t cells) {
+    return __builtin_ctzll(cells) / BITBOARD_HEIGHT;
 }
 
 /*
  * Purpose:
- *      To validate the character the user wants to use to represent their pieces
+ *      To get the bitboard of every cell in a column
  * Parameters:
- *      playerChar - the character to represent the player on the game board
+ *      column - the column index (0 - 6)
  * Returns:
- *      playerChar - the validated character to represent the player on the game board
+ *      A bitboard with every cell of the column set
  * Side-Effects:
  *      NONE
- */     
-char validateChar(char playerChar, int player, const char gameMode, const char* playerPronoun) {
-   
-    // while the user enters a character that is not uppercase from A - Z, 
-    // and is not the default value of 'O', prompt the user to re enter the character
-    while ((playerChar < 'A') || (playerChar > 'Z') || (playerChar == 'O')) {
-        printf("Your input of '%c' is invalid.\n", playerChar);
-        printf("\n");
-        printf("Player %d: Please enter an uppercase character you\n", player);
-        printf("would like to use to represent %s pieces [A-Z]: ", playerPronoun);
-        scanf( "%c", &playerChar);
-        fgetc(stdin);
-    }
-    
-    return playerChar;
+ */
+uint64_t columnMask(const int column) {
+    return (((uint64_t)1 << BOARD_ROWS) - 1) << (column * BITBOARD_HEIGHT);
 }
 
 /*
  * Purpose:
- *      To get the user to input a character the user would like to represent their pieces
+ *      To build the bitboard of every cell in the gameboard array holding a character
  * Parameters:
- *      player - the number value given to each player
- *      gameMode - the gameMode the user is playing to determine the pronoun to address the player as
+ *      gameBoard - the game board array
+ *      pieceChar - the character to find, or 0 to find every piece that is not the default 'O'
  * Returns:
- *      userChar - the character the user will use to represent their pieces on the board
+ *      The bitboard of the matching cells
  * Side-Effects:
  *      NONE
  */
-char getPlayerChar(int player, const char gameMode) {
-    // set default value for the players character
-    char playerChar = 'c';
-    // default player pronoun for a real user
-    char* playerPronoun = "your";
-    
-    // if the user is playing against the computer (which is player 2), set the 
-    // player pronoun to "the computers" to output an appropriate prompt.
-    if ((gameMode == 'c') && (player == 2)) {
-        playerPronoun = "the computer's";
-        player = 1;
+uint64_t boardToBitboard(const char gameBoard[BOARD_COLUMNS][BOARD_ROWS], const char pieceChar) {
+    // the bitboard being built
+    uint64_t cells = 0;
+    // the counters for the column and row
+    int column = 0;
+    int row = 0;
+
+    // the comparison is turned into the bit itself so the loop has no
+    // branches on the contents of the board
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        for (row = 0; row < BOARD_ROWS; row++) {
+            if (pieceChar == 0) {
+                cells |= (uint64_t)(gameBoard[column][row] != 'O') << (column * BITBOARD_HEIGHT + row);
+            } else {
+                cells |= (uint64_t)(gameBoard[column][row] == pieceChar) << (column * BITBOARD_HEIGHT + row);
+            }
+        }
     }
-    // ask player to enter
-    printf("Player %d: Please enter an uppercase character you\n", player);
-    printf("would like to use to represent %s pieces [A-Z]: ", playerPronoun);
-    scanf( "%c", &playerChar);
-    fgetc(stdin);
-    // validate the users character
-    playerChar = validateChar(playerChar, player, gameMode, playerPronoun);
-    
-    // return the validated userChar
-    return playerChar;
+
+    return cells;
 }
 
 /*
  * Purpose:
- *      To validate the column the user plays their piece in is from 1-7 (inclusive)
- *      because those are the possible columns in the game board
+ *      To fill the gameboard array from the bitboards of a board
  * Parameters:
- *      columnSlot - the column the user would like to put their piece in
- *      gameBoard - the 2D array of the game board to validate that the
- *      row the user is putting their piece in is not full
+ *      gameBoard - the game board array to fill
+ *      first - the bitboard of the pieces of the player who moved first
+ *      occupied - the bitboard of every piece
+ *      firstChar - the character of the player who moved first
+ *      secondChar - the character of the player who moved second
  * Returns:
- *      columnSlot - the validated column the user places their pieces in
+ *      NONE
  * Side-Effects:
- *      NONE - gameboard is const so it is not modified
+ *      gameBoard is overwritten
  */
-int validateUserPlacement(int columnSlot, const char gameBoard[][numRows]) {
-    // while the users input is not in between 1-7 (the valid columns) prompt 
-    // the user to reenter the column they would like to place their pieces.
-    while ((columnSlot > 7) || (columnSlot < 1)) {
-        printf("Your entry of column %d is inavlid.\n", columnSlot);
-        printf("Please enter a new column you would like to drop your piece in [1-7]: ");
-        scanf("%d", &columnSlot);
-        fgetc(stdin);
-    }
-    // while they have entered a column that is full (the value is not the default
-    // at that index), ask them to choose a new column
-    while (gameBoard[columnSlot - 1][5] != 'O') {
-        printf("Column %d is full.\n", columnSlot);
-        printf("Please enter a new column you would like to drop your piece in [1-7]: ");
-        scanf("%d", &columnSlot);
-        fgetc(stdin);
-    }
+void bitboardToBoard(char gameBoard[BOARD_COLUMNS][BOARD_ROWS], const uint64_t first, const uint64_t occupied, const char firstChar, const char secondChar) {
+    // the counters for the column and row
+    int column = 0;
+    int row = 0;
 
-    return columnSlot;
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        for (row = 0; row < BOARD_ROWS; row++) {
+            // the bit of the cell
+            uint64_t cell = (uint64_t)1 << (column * BITBOARD_HEIGHT + row);
+            gameBoard[column][row] = (occupied & cell) ? ((first & cell) ? firstChar : secondChar) : 'O';
+        }
+    }
 }
 
+// the value of a winning line for the player that owns it, indexed by the number
+// of pieces the player has in the line. A line that holds pieces of both players
+// can never be completed so it is worth nothing to either of them.
+const int lineWeights[CONNECT_LENGTH + 1] = {0, 1, 5, 25, 1000};
+// the score given to a won position. The number of moves played is subtracted
+// so the search prefers faster wins and slower losses.
+#define WIN_SCORE 1000000
+// the order columns are tried in by the search, centre first as the centre
+// columns take part in the most winning lines
+const int columnOrder[BOARD_COLUMNS] = {3, 2, 4, 1, 5, 0, 6};
+
+// the evaluation of one line for the first player indexed by the number of
+// first player pieces and second player pieces in the line
+int lineValues[CONNECT_LENGTH + 1][CONNECT_LENGTH + 1];
+
+// the most tuples an n-tuple network can have
+#define MAX_TUPLES 128
+// the most cells in one tuple, 3^8 weights each
+#define MAX_TUPLE_CELLS 8
+// the most tuples one cell can belong to
+#define MAX_CELL_TUPLES 64
+// the weights are stored as fixed point numbers with this many steps per unit
+// so the evaluation is an integer sum
+#define NETWORK_SCALE 16
+// the largest weight a network file may hold, so the fixed point sum of a weight
+// from every tuple cannot overflow
+#define NETWORK_MAX_WEIGHT ((float)(INT32_MAX / MAX_TUPLES / NETWORK_SCALE))
+
+/*
+ * An n-tuple network evaluator. Each tuple is a small set of cells and has one
+ * weight for every way the cells can be filled (empty, first player or second
+ * player). The evaluation is the sum of the weights picked by the current board.
+ */
+typedef struct {
+    // the number of tuples
+    int tupleCount;
+    // the cells of each tuple and how many there are
+    unsigned char tupleCells[MAX_TUPLES][MAX_TUPLE_CELLS];
+    int tupleSizes[MAX_TUPLES];
+    // the index of the first weight of each tuple in the weights array
+    int32_t tupleOffsets[MAX_TUPLES];
+    // every weight of every tuple in fixed point, for the first player
+    int32_t* weights;
+    // for every cell, the tuples it belongs to and the place value of the cell
+    // in each of those tuples (a power of 3)
+    int cellTupleCount[NUM_CELLS];
+    unsigned char cellTuples[NUM_CELLS][MAX_CELL_TUPLES];
+    int32_t cellPowers[NUM_CELLS][MAX_CELL_TUPLES];
+} NTupleNetwork;
+
+// the n-tuple network used by the search instead of the line evaluation, NULL if none is loaded
+NTupleNetwork* activeNetwork = NULL;
+
+/*
+ * The weight index of every tuple of the active n-tuple network for one board.
+ * Each thread keeps one, which makeMove and unmakeMove move along while it is for
+ * the board they change, and which is made again from the bitboards when a
+ * different board is evaluated. Positions do not carry the indexes, so they stay
+ * small when no network is loaded.
+ */
+typedef struct {
+    // set once the indexes have been made for a board
+    int valid;
+    // the bitboards of each players pieces the indexes are for
+    uint64_t pieces[2];
+    // the index into the weights of the active network for each of its tuples
+    int32_t tupleIndexes[MAX_TUPLES];
+} NetworkIndexes;
+
+// the network indexes of this thread
+_Thread_local NetworkIndexes networkIndexes;
+
+/*
+ * A position used by the computer search. The pieces are stored as the number of
+ * pieces each player has in every winning line so that the evaluation can be kept
+ * up to date as moves are made and unmade instead of rescanning the board.
+ * Player 0 is the player that moved first.
+ */
+typedef struct {
+    // the number of pieces in each column
+    unsigned char heights[BOARD_COLUMNS];
+    // the number of moves that have been played
+    int moveCount;
+    // the number of pieces each player has in each winning line
+    unsigned char lineCounts[2][NUM_LINES];
+    // the sum of the line values for the first player
+    int evaluation;
+    // the bitboards of each players pieces
+    uint64_t pieces[2];
+    // the bitboard of every piece on the board
+    uint64_t occupied;
+} Position;
+
 /*
  * Purpose:
- *      To place the users piece in the column they have selected at the "lowest" available row
+ *      To fill the table of line values used by the incremental evaluation
  * Parameters:
- *      gameBoard - the 2D array to be modified when the users piece is placed
- *      userChar - the character the user chose to represent their pieces to 
- *      be "dropped" into the gameboard
- *      columnSlot - the column the user wants to play their piece in
+ *      NONE
  * Returns:
  *      NONE
  * Side-Effects:
- *      The gameboard is modified with the users piece placement
+ *      lineValues is filled in
  */
-void placepiece( char gameBoard[numColumns][numRows], const char userChar, const int columnSlot) {
-    // variable to store the row the users piece will be placed into
-    int rowSlot = 0;
-    
-    // starting from the bottom row (index 0), while the value is not the default
-    // and the upper bound has not been reached, the loop will increment up row by row,
-    // until it finds an index pair (column and row) in the gameboard that is the default
-    // value of 'O'. The column slot is subtracted by 1 because the user is presented
-    // with choices from 1-7 while the computers indexes for the columns are 0-6
-    while ((gameBoard[columnSlot - 1][rowSlot] != 'O') && (rowSlot < 6)) {
-        rowSlot++;
+void initLineValues() {
+    // counters for the pieces of the first and second player in a line
+    int first = 0;
+    int second = 0;
+
+    for (first = 0; first <= CONNECT_LENGTH; first++) {
+        for (second = 0; second <= CONNECT_LENGTH; second++) {
+            if (second == 0) {
+                lineValues[first][second] = lineWeights[first];
+            } else if (first == 0) {
+                lineValues[first][second] = -lineWeights[second];
+            } else {
+                lineValues[first][second] = 0;
+            }
+        }
     }
-    // set the value at the users column slot and the lowest empty row slot to
-    // the character the user chose to represent their pieces.
-    gameBoard[columnSlot - 1][rowSlot] = userChar;
 }
 
 /*
  * Purpose:
- *      To check if a player has won the game
+ *      To set a position to the empty board
  * Parameters:
- *      gameBoard - the gameboard array to be checked to see if either player has 4 in a row
- *      userChar - the character of the user to check if that user has 4 in a row
+ *      position - the position to be reset
  * Returns:
- *      winGame - the variable storing if a player has won or not
+ *      NONE
  * Side-Effects:
- *      NONE - the gameboard array is not modified because it is a const
- */         
-int checkWinGame(const char gameBoard[numColumns][numRows], const char userChar) {
-    // the variable to store if a player has won or not
+ *      Every field of the position is cleared
+ */
+void initPosition(Position* position) {
+    memset(position, 0, sizeof(*position));
+}
+
+/*
+ * Purpose:
+ *      To check if a piece can be played in a column of a position
+ * Parameters:
+ *      position - the position to check
+ *      column - the column index (0 - 6)
+ * Returns:
+ *      1 if the column is not full, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int canPlay(const Position* position, const int column) {
+    return position->heights[column] < BOARD_ROWS;
+}
+
+/*
+ * Purpose:
+ *      To play a piece for the player to move and update the line counts and
+ *      evaluation using only the lines through the cell the piece lands in
+ * Parameters:
+ *      position - the position the move is played in
+ *      column - the column index (0 - 6) the piece is dropped in. It must not be full.
+ * Returns:
+ *      1 if the move completes a winning line, otherwise 0
+ * Side-Effects:
+ *      The position is modified to include the move, and so are the threads
+ *      network indexes if they are for the position
+ */
+int makeMove(Position* position, const int column) {
+    // the player making the move
+    int player = position->moveCount & 1;
+    // the cell the piece lands in
+    int cell = column * BOARD_ROWS + position->heights[column];
+    // the bit of the cell the piece lands in
+    uint64_t move = (uint64_t)1 << (column * BITBOARD_HEIGHT + position->heights[column]);
+    // set if the move completes a line
     int winGame = 0;
-    // the counter for the index of the row
+    // the counter for the lines through the cell
     int i = 0;
-    // the counter for the index of the column
-    int j = 0;
-    
-    // loop through every index of the game board to check if the player got 4 in a row
-    while (i < numRows) {
-        // iterate across each column to find the player pieces
-        for (j = 0; j < numColumns; j++) {
-            if (gameBoard[j][i] == userChar) {
-                // if the 3 pieces above a players piece are also its piece, or if
-                // the 3 pieces to the right of the players piece (no need to check left because
-                // the furthest left game piece will be the fist to be checked by the loop)
-                // are also its piece, or if the 3 pieces diagonally right of
-                // the players piece are also its piece, or if the 3 pieces 
-                // diagonally left of the players piece are also its piece. All these
-                // checks also include checks of the constraints to make sure only
-                // values within the gameboard are checked. For example it is impossible
-                // to win with 4 in a row vertically if the bottom piece is not below
-                // the 3rd row from the top.
-                if (((gameBoard[j][i + 1] == userChar) && (gameBoard[j][i + 2] == userChar) && (gameBoard[j][i + 3] == userChar) && (i < 3)) || ((gameBoard[j + 1][i] == userChar) && (gameBoard[j + 2][i] == userChar) && (gameBoard[j + 3][i] == userChar) && (j < 4)) || ((gameBoard[j + 1][i + 1] == userChar) && (gameBoard[j + 2][i + 2] == userChar) && (gameBoard[j + 3][i + 3] == userChar) && (j < 4) && (i < 3)) || ((gameBoard[j - 1][i + 1] == userChar) && (gameBoard[j - 2][i + 2] == userChar) && (gameBoard[j - 3][i + 3] == userChar) && (j > 2) && (i < 3))) {
-                    // a player has won
-                    winGame = 1;
-                    break;
-                }
-            }
+
+    for (i = 0; i < cellLineCount[cell]; i++) {
+        int line = cellLines[cell][i];
+        // swap the old value of the line for the new one in the running evaluation
+        position->evaluation -= lineValues[position->lineCounts[0][line]][position->lineCounts[1][line]];
+        position->lineCounts[player][line]++;
+        position->evaluation += lineValues[position->lineCounts[0][line]][position->lineCounts[1][line]];
+        if (position->lineCounts[player][line] == CONNECT_LENGTH) {
+            winGame = 1;
         }
-        // if the game has been won, break the loop as there is no need to continue
-        // checking the array
-        if (winGame) {
-            break;
-        // the game has not been won so continue iterating through the array checking
-        // if a player has won
-        } else {
-            i++;
+    }
+    // the cell changes from empty (0) to the players state (1 or 2) in every tuple it is in
+    if ((activeNetwork != NULL) && (networkIndexes.valid) && (networkIndexes.pieces[0] == position->pieces[0]) && (networkIndexes.pieces[1] == position->pieces[1])) {
+        for (i = 0; i < activeNetwork->cellTupleCount[cell]; i++) {
+            networkIndexes.tupleIndexes[activeNetwork->cellTuples[cell][i]] += activeNetwork->cellPowers[cell][i] * (player + 1);
         }
-    // end of while loop. A player did not win
+        networkIndexes.pieces[player] |= move;
     }
+    position->pieces[player] |= move;
+    position->occupied |= move;
+    position->heights[column]++;
+    position->moveCount++;
 
     return winGame;
 }
 
 /*
  * Purpose:
- *      For the player to pick a place to play their piece and then place it by changing 
- *      the default value in the game board array to the players chosen character
+ *      To take back the last piece played in a column
  * Parameters:
- *      userChar - the character representing the users piece
- *      gameBoard - the game board array
+ *      position - the position the move is taken back in
+ *      column - the column index (0 - 6) of the last move played
  * Returns:
  *      NONE
  * Side-Effects:
- *      NONE - the gameboard array is modified in the place piece function when it is called
+ *      The position is modified to remove the move, and so are the threads
+ *      network indexes if they are for the position
  */
-void playerTurn(const char userChar, char gameBoard[numColumns][numRows], const int player) {
-    int columnSlot = 0;
-    // ask user what column they would like to play their piece into
-    printf("\nPlayer %d: Which column would you like to drop your piece into? [1-7]: ", player);
-    scanf("%d", &columnSlot);
-    fgetc(stdin);
-    // validate the users column is within the game board and is not full
-    columnSlot = validateUserPlacement(columnSlot, gameBoard);
-    // place the users piece at the lowest available slot in their selected column
-    placepiece(gameBoard, userChar, columnSlot);
+void unmakeMove(Position* position, const int column) {
+    // the player that made the move being taken back
+    int player = (position->moveCount - 1) & 1;
+    // the cell the piece is removed from
+    int cell = 0;
+    // the bit of the cell the piece is removed from
+    uint64_t move = 0;
+    // the counter for the lines through the cell
+    int i = 0;
+
+    position->heights[column]--;
+    position->moveCount--;
+    cell = column * BOARD_ROWS + position->heights[column];
+    // the bit of the cell the piece is removed from
+    move = (uint64_t)1 << (column * BITBOARD_HEIGHT + position->heights[column]);
+    if ((activeNetwork != NULL) && (networkIndexes.valid) && (networkIndexes.pieces[0] == position->pieces[0]) && (networkIndexes.pieces[1] == position->pieces[1])) {
+        for (i = 0; i < activeNetwork->cellTupleCount[cell]; i++) {
+            networkIndexes.tupleIndexes[activeNetwork->cellTuples[cell][i]] -= activeNetwork->cellPowers[cell][i] * (player + 1);
+        }
+        networkIndexes.pieces[player] &= ~move;
+    }
+    position->pieces[player] &= ~move;
+    position->occupied &= ~move;
+    for (i = 0; i < cellLineCount[cell]; i++) {
+        int line = cellLines[cell][i];
+        position->evaluation -= lineValues[position->lineCounts[0][line]][position->lineCounts[1][line]];
+        position->lineCounts[player][line]--;
+        position->evaluation += lineValues[position->lineCounts[0][line]][position->lineCounts[1][line]];
+    }
 }
 
 /*
  * Purpose:
- *      To check if the computer or player has three in a row and if the computer
- *      can either win or prevent the player from winning
+ *      To get the static evaluation of a position for the player to move
  * Parameters:
- *      gameBoard - the game board array
- *      computerChar - the character representing the computers pieces
- *      checkChar - the character for the player that the programming is checking
- *      if they have 3 in a row
+ *      position - the position to evaluate
+ * Returns:
+ *      The evaluation, positive when the player to move is better
+ * Side-Effects:
+ *      NONE
+ */
+int evaluatePosition(const Position* position) {
+    return (position->moveCount & 1) ? -position->evaluation : position->evaluation;
+}
+
+/*
+ * Purpose:
+ *      To read a little endian 32 bit number from a file
+ * Parameters:
+ *      file - the file to read from
+ *      value - set to the number read
+ * Returns:
+ *      1 if 4 bytes were read, otherwise 0
+ * Side-Effects:
+ *      The file position is advanced
+ */
+int readUint32(FILE* file, uint32_t* value) {
+    // the bytes read
+    unsigned char bytes[4];
+
+    if (fread(bytes, 1, 4, file) != 4) {
+        return 0;
+    }
+    *value = bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To write a little endian 32 bit number to a file
+ * Parameters:
+ *      file - the file to write to
+ *      value - the number to write
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      4 bytes are written to the file
+ */
+void writeUint32(FILE* file, const uint32_t value) {
+    // the bytes to write
+    unsigned char bytes[4] = {(unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24)};
+
+    fwrite(bytes, 1, 4, file);
+}
+
+/*
+ * Purpose:
+ *      To free an n-tuple network
+ * Parameters:
+ *      network - the network to free, may be NULL
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The network and its weights are freed
+ */
+void freeNetwork(NTupleNetwork* network) {
+    if (network != NULL) {
+        free(network->weights);
+        free(network);
+    }
+}
+
+/*
+ * Purpose:
+ *      To read one tuple of an n-tuple network weight file
+ * Parameters:
+ *      file - the weight file, positioned at the start of the tuple
+ *      network - the network being loaded
+ *      t - the index of the tuple
+ *      totalWeights - the number of weights loaded so far, increased by the tuples weights
+ * Returns:
+ *      1 if the tuple was read, 0 if the file is not valid, a weight is not a number
+ *      or larger than NETWORK_MAX_WEIGHT, or memory ran out
+ * Side-Effects:
+ *      The tuple, its weights and the cell lookup tables of the network are filled in
+ */
+int readNetworkTuple(FILE* file, NTupleNetwork* network, const int t, int32_t* totalWeights) {
+    // the number of cells in the tuple
+    uint32_t size = 0;
+    // the number of weights in the tuple
+    int32_t tupleWeights = 1;
+    // the place value of the cell being read
+    int32_t power = 1;
+    // the weights array grown to fit the tuple
+    int32_t* weights = NULL;
+    // the raw bits of a weight and the weight itself
+    uint32_t bits = 0;
+    float weight = 0;
+    // counters for the cells and weights
+    int k = 0;
+    int w = 0;
+
+    if ((!readUint32(file, &size)) || (size < 1) || (size > MAX_TUPLE_CELLS) || (fread(network->tupleCells[t], 1, size, file) != size)) {
+        return 0;
+    }
+    network->tupleSizes[t] = size;
+    for (k = 0; k < (int)size; k++) {
+        int cell = network->tupleCells[t][k];
+        if ((cell >= NUM_CELLS) || (network->cellTupleCount[cell] == MAX_CELL_TUPLES)) {
+            return 0;
+        }
+        network->cellTuples[cell][network->cellTupleCount[cell]] = (unsigned char)t;
+        network->cellPowers[cell][network->cellTupleCount[cell]] = power;
+        network->cellTupleCount[cell]++;
+        power *= 3;
+        tupleWeights *= 3;
+    }
+    weights = realloc(network->weights, (*totalWeights + tupleWeights) * sizeof(int32_t));
+    if (weights == NULL) {
+        return 0;
+    }
+    network->weights = weights;
+    network->tupleOffsets[t] = *totalWeights;
+    for (w = 0; w < tupleWeights; w++) {
+        if (!readUint32(file, &bits)) {
+            return 0;
+        }
+        memcpy(&weight, &bits, sizeof(weight));
+        // a weight that is not a number or too large cannot be made fixed point,
+        // and the comparison is false for a NaN
+        if (!(fabsf(weight) <= NETWORK_MAX_WEIGHT)) {
+            return 0;
+        }
+        // round to the nearest fixed point step
+        weights[*totalWeights + w] = (int32_t)(weight * NETWORK_SCALE + ((weight < 0) ? -0.5f : 0.5f));
+    }
+    *totalWeights += tupleWeights;
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To load an n-tuple network from a weight file. The file starts with the
+ *      bytes "C4NT" and the number of tuples, then for each tuple the number of
+ *      cells, the cell indexes (column * 6 + row) as single bytes and 3^cells
+ *      weights as 32 bit floats. A weight is indexed by the sum of the cell
+ *      states (0 empty, 1 first player, 2 second player) times 3 to the power
+ *      of the cells place in the tuple. Numbers are little endian.
+ * Parameters:
+ *      fileName - the name of the weight file
+ * Returns:
+ *      The loaded network, or NULL if the file is missing or not a valid weight file
+ * Side-Effects:
+ *      The network is allocated
+ */
+NTupleNetwork* loadNetwork(const char* fileName) {
+    // the weight file
+    FILE* file = fopen(fileName, "rb");
+    // the network being loaded
+    NTupleNetwork* network = calloc(1, sizeof(NTupleNetwork));
+    // the magic bytes at the start of the file
+    char magic[4];
+    // the number of tuples in the file
+    uint32_t tupleCount = 0;
+    // the number of weights loaded so far
+    int32_t totalWeights = 0;
+    // set while the file is valid
+    int valid = 0;
+    // the counter for the tuples
+    int t = 0;
+
+    if ((file != NULL) && (network != NULL)) {
+        valid = (fread(magic, 1, 4, file) == 4) && (memcmp(magic, "C4NT", 4) == 0) && (readUint32(file, &tupleCount)) && (tupleCount <= MAX_TUPLES);
+        network->tupleCount = valid ? (int)tupleCount : 0;
+        for (t = 0; (t < network->tupleCount) && (valid); t++) {
+            valid = readNetworkTuple(file, network, t, &totalWeights);
+        }
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    if (!valid) {
+        freeNetwork(network);
+        network = NULL;
+    }
+
+    return network;
+}
+
+/*
+ * Purpose:
+ *      To write a weight file with one 4 cell tuple for every winning line whose
+ *      weights match the line evaluation. It gives the same scores as the built in
+ *      evaluation and is a starting point for training.
+ * Parameters:
+ *      fileName - the name of the weight file to write
+ * Returns:
+ *      1 if the file was written, otherwise 0
+ * Side-Effects:
+ *      The file is written
+ */
+int writeLineNetwork(const char* fileName) {
+    // the weight file
+    FILE* file = fopen(fileName, "wb");
+    // counters for the lines, cells and weights
+    int line = 0;
+    int k = 0;
+    int w = 0;
+
+    if (file == NULL) {
+        return 0;
+    }
+    fwrite("C4NT", 1, 4, file);
+    writeUint32(file, NUM_LINES);
+    for (line = 0; line < NUM_LINES; line++) {
+        writeUint32(file, CONNECT_LENGTH);
+        fwrite(lineCells[line], 1, CONNECT_LENGTH, file);
+        // count the pieces of each player in every way of filling the line
+        for (w = 0; w < 81; w++) {
+            int counts[3] = {0, 0, 0};
+            int rest = w;
+            float weight = 0;
+            uint32_t bits = 0;
+            for (k = 0; k < CONNECT_LENGTH; k++) {
+                counts[rest % 3]++;
+                rest /= 3;
+            }
+            weight = (float)lineValues[counts[1]][counts[2]];
+            memcpy(&bits, &weight, sizeof(bits));
+            writeUint32(file, bits);
+        }
+    }
+    fclose(file);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To make the threads network indexes for a position from its pieces
+ * Parameters:
+ *      position - the position the indexes are made for
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The threads network indexes are overwritten
+ */
+void loadNetworkIndexes(const Position* position) {
+    // counters for the tuples, columns, rows and the tuples of a cell
+    int t = 0;
+    int column = 0;
+    int row = 0;
+    int i = 0;
+
+    // on an empty board every tuple picks its first weight
+    for (t = 0; t < activeNetwork->tupleCount; t++) {
+        networkIndexes.tupleIndexes[t] = activeNetwork->tupleOffsets[t];
+    }
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        for (row = 0; row < position->heights[column]; row++) {
+            int cell = column * BOARD_ROWS + row;
+            // the state of the cell, 1 for the first player and 2 for the second
+            int state = ((position->pieces[1] >> (column * BITBOARD_HEIGHT + row)) & 1) + 1;
+            for (i = 0; i < activeNetwork->cellTupleCount[cell]; i++) {
+                networkIndexes.tupleIndexes[activeNetwork->cellTuples[cell][i]] += activeNetwork->cellPowers[cell][i] * state;
+            }
+        }
+    }
+    networkIndexes.pieces[0] = position->pieces[0];
+    networkIndexes.pieces[1] = position->pieces[1];
+    networkIndexes.valid = 1;
+}
+
+/*
+ * Purpose:
+ *      To get the n-tuple network evaluation of a position for the player to move.
+ *      The threads network indexes follow the moves made and unmade, so this is
+ *      one load and add per tuple unless they are for another board and have to
+ *      be made again.
+ * Parameters:
+ *      position - the position to evaluate
+ * Returns:
+ *      The evaluation, positive when the player to move is better
+ * Side-Effects:
+ *      The threads network indexes are made for the position if they were not
+ */
+int evaluateNetwork(const Position* position) {
+    // the weights of the network being used
+    const int32_t* weights = activeNetwork->weights;
+    // the weight index of every tuple
+    const int32_t* indexes = networkIndexes.tupleIndexes;
+    // the number of tuples
+    int tupleCount = activeNetwork->tupleCount;
+    // four separate sums so the loads do not wait on each other
+    int32_t sums[4] = {0, 0, 0, 0};
+    int32_t sum = 0;
+    // the counter for the tuples
+    int t = 0;
+
+    if ((!networkIndexes.valid) || (networkIndexes.pieces[0] != position->pieces[0]) || (networkIndexes.pieces[1] != position->pieces[1])) {
+        loadNetworkIndexes(position);
+    }
+    for (t = 0; t + 4 <= tupleCount; t += 4) {
+        sums[0] += weights[indexes[t]];
+        sums[1] += weights[indexes[t + 1]];
+        sums[2] += weights[indexes[t + 2]];
+        sums[3] += weights[indexes[t + 3]];
+    }
+    for (; t < tupleCount; t++) {
+        sums[0] += weights[indexes[t]];
+    }
+    sum = (sums[0] + sums[1] + sums[2] + sums[3]) / NETWORK_SCALE;
+
+    return (position->moveCount & 1) ? -sum : sum;
+}
+
+/*
+ * Purpose:
+ *      To get the static evaluation the search uses, from the n-tuple network if
+ *      one is loaded and from the line counts otherwise
+ * Parameters:
+ *      position - the position to evaluate
+ * Returns:
+ *      The evaluation, positive when the player to move is better
+ * Side-Effects:
+ *      NONE
+ */
+int staticEvaluation(const Position* position) {
+    return (activeNetwork != NULL) ? evaluateNetwork(position) : evaluatePosition(position);
+}
+
+/*
+ * Purpose:
+ *      To check if the last move played in a position won the game
+ * Parameters:
+ *      position - the position to check
+ * Returns:
+ *      1 if the player that moved last has four in a row, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int checkPositionWon(const Position* position) {
+    // the counter for the winning lines
+    int line = 0;
+
+    if (position->moveCount == 0) {
+        return 0;
+    }
+    for (line = 0; line < NUM_LINES; line++) {
+        if (position->lineCounts[(position->moveCount - 1) & 1][line] == CONNECT_LENGTH) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To find the moves that win the game straight away for a player
+ * Parameters:
+ *      position - the position to check
+ *      player - the player (0 or 1) to find winning moves for
+ * Returns:
+ *      A bitboard of the playable cells that complete four in a row for the player
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t winningMoves(const Position* position, const int player) {
+    return winningCells(position->pieces[player], position->occupied) & playableCells(position->occupied);
+}
+
+/*
+ * Purpose:
+ *      To find the moves for the player to move that do not let the opponent
+ *      win by playing on top of them
+ * Parameters:
+ *      position - the position to check
+ * Returns:
+ *      A bitboard of the playable cells that are not directly below a cell
+ *      that wins the game for the opponent
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t safeMoves(const Position* position) {
+    // the cells that win the game for the opponent of the player to move
+    uint64_t opponentWins = winningCells(position->pieces[(position->moveCount + 1) & 1], position->occupied);
+
+    return playableCells(position->occupied) & ~(opponentWins >> 1);
+}
+
+/*
+ * Purpose:
+ *      To play a sequence of moves given as a string of columns from 1-7, the same
+ *      numbering the players see, e.g. "4453"
+ * Parameters:
+ *      position - the position the moves are played in
+ *      moves - the string of columns
+ * Returns:
+ *      The number of moves played, or -1 if a column is invalid, full, or is
+ *      played after the game has been won
+ * Side-Effects:
+ *      The position is modified to include the moves
+ */
+int playMoveString(Position* position, const char* moves) {
+    // the counter for the character in the string
+    int i = 0;
+    // set when a move has won the game so no more moves can be played
+    int winGame = 0;
+
+    for (i = 0; moves[i] != '\0'; i++) {
+        // the column index of the move
+        int column = moves[i] - '1';
+        if ((column < 0) || (column >= BOARD_COLUMNS) || (!canPlay(position, column)) || (winGame)) {
+            return -1;
+        }
+        winGame = makeMove(position, column);
+    }
+
+    return i;
+}
+
+/*
+ * Purpose:
+ *      To read a monotonic clock for timing searches
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      The time in seconds from an arbitrary starting point
+ * Side-Effects:
+ *      NONE
+ */
+double monotonicSeconds() {
+    // the time read from the clock
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// the tables the memory of the process is accounted to
+#define MEMORY_TRANSPOSITION 0
+#define MEMORY_PROOF_TREE 1
+#define MEMORY_ENUMERATION 2
+#define MEMORY_BOOK 3
+#define MEMORY_DATABASE 4
+#define MEMORY_OPENINGS 5
+#define MEMORY_GAMES 6
+#define MEMORY_TABLES 7
+// the smallest a table that can be shrunk to fit the budget is shrunk to
+#define MEMORY_MIN_TABLE ((size_t)1 << 20)
+
+// the names of the tables in the memory statistics
+const char* memoryTableNames[MEMORY_TABLES] = {"transposition", "proof-tree", "enumeration", "book", "database", "openings", "games"};
+
+/*
+ * The memory held by the caches and tables of the process, checked against a
+ * budget so many engine processes can share a machine without one of them
+ * being killed when the load peaks. Small and short lived allocations are not
+ * counted.
+ */
+typedef struct {
+    // the most bytes the tables may hold together, 0 for no limit
+    size_t budget;
+    // the bytes held now and the most held at once, in total and by each table
+    size_t used;
+    size_t peak;
+    size_t tableUsed[MEMORY_TABLES];
+    size_t tablePeak[MEMORY_TABLES];
+    // the number of tables shrunk to fit the budget and refused by it
+    long long shrunk;
+    long long refused;
+    // held while the counts change, as the tables are allocated by many threads
+    pthread_mutex_t lock;
+} MemoryBudget;
+
+// the memory budget of the process, set with --memory
+MemoryBudget memoryBudget = {0, 0, 0, {0}, {0}, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+/*
+ * Purpose:
+ *      To take memory for a table from the budget before it is allocated. A
+ *      request that does not fit is halved until it does, down to the minimum,
+ *      so a power of two sized table stays a power of two.
+ * Parameters:
+ *      table - the table the memory is for (MEMORY_TRANSPOSITION ...)
+ *      bytes - the bytes wanted
+ *      minimum - the fewest bytes the table can work with, the request is
+ *                refused rather than shrunk below it. Pass bytes to refuse
+ *                instead of shrinking.
+ * Returns:
+ *      The bytes reserved, which must be given back with releaseMemory, or 0
+ *      if the request was refused
+ * Side-Effects:
+ *      The memory counts are updated
+ */
+size_t reserveMemory(const int table, size_t bytes, size_t minimum) {
+    // the bytes asked for before shrinking
+    size_t requested = bytes;
+
+    if (minimum > bytes) {
+        minimum = bytes;
+    }
+    pthread_mutex_lock(&memoryBudget.lock);
+    if (memoryBudget.budget > 0) {
+        while ((bytes >= minimum) && (bytes > 0) && (memoryBudget.used + bytes > memoryBudget.budget)) {
+            bytes /= 2;
+        }
+        if ((bytes < minimum) || (bytes == 0)) {
+            bytes = 0;
+            memoryBudget.refused++;
+        } else if (bytes < requested) {
+            memoryBudget.shrunk++;
+        }
+    }
+    memoryBudget.used += bytes;
+    memoryBudget.tableUsed[table] += bytes;
+    if (memoryBudget.used > memoryBudget.peak) {
+        memoryBudget.peak = memoryBudget.used;
+    }
+    if (memoryBudget.tableUsed[table] > memoryBudget.tablePeak[table]) {
+        memoryBudget.tablePeak[table] = memoryBudget.tableUsed[table];
+    }
+    pthread_mutex_unlock(&memoryBudget.lock);
+
+    return bytes;
+}
+
+/*
+ * Purpose:
+ *      To give the memory of a table back to the budget once it is freed
+ * Parameters:
+ *      table - the table the memory was reserved for
+ *      bytes - the bytes reserveMemory returned
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The memory counts are updated
+ */
+void releaseMemory(const int table, const size_t bytes) {
+    pthread_mutex_lock(&memoryBudget.lock);
+    memoryBudget.used -= bytes;
+    memoryBudget.tableUsed[table] -= bytes;
+    pthread_mutex_unlock(&memoryBudget.lock);
+}
+
+/*
+ * Purpose:
+ *      To allocate a cleared table of a fixed size inside the memory budget
+ * Parameters:
+ *      table - the table the memory is for
+ *      bytes - the size of the table
+ * Returns:
+ *      The table, or NULL if the budget refused it or it could not be allocated
+ * Side-Effects:
+ *      The memory is taken from the budget until freeTable is called
+ */
+void* allocateTable(const int table, const size_t bytes) {
+    // the allocated table
+    void* memory = NULL;
+
+    if (reserveMemory(table, bytes, bytes) < bytes) {
+        return NULL;
+    }
+    memory = calloc(1, (bytes > 0) ? bytes : 1);
+    if (memory == NULL) {
+        releaseMemory(table, bytes);
+    }
+
+    return memory;
+}
+
+/*
+ * Purpose:
+ *      To free a table allocated with allocateTable
+ * Parameters:
+ *      table - the table the memory is for
+ *      memory - the table, may be NULL
+ *      bytes - the size the table was allocated with
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The memory is given back to the budget
+ */
+void freeTable(const int table, void* memory, const size_t bytes) {
+    if (memory != NULL) {
+        free(memory);
+        releaseMemory(table, bytes);
+    }
+}
+
+/*
+ * Purpose:
+ *      To print the memory budget, the memory held now and at its peak by all
+ *      the tables and by each of them, and the peak resident size of the process
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printMemoryStatistics() {
+    // the resource usage of the process
+    struct rusage usage;
+    // the counter for the tables
+    int i = 0;
+
+    pthread_mutex_lock(&memoryBudget.lock);
+    printf("memory budget %.1f MB used %.1f MB peak %.1f MB shrunk %lld refused %lld\n", memoryBudget.budget / 1048576.0, memoryBudget.used / 1048576.0, memoryBudget.peak / 1048576.0, memoryBudget.shrunk, memoryBudget.refused);
+    for (i = 0; i < MEMORY_TABLES; i++) {
+        if (memoryBudget.tablePeak[i] > 0) {
+            printf("memory %s used %.1f MB peak %.1f MB\n", memoryTableNames[i], memoryBudget.tableUsed[i] / 1048576.0, memoryBudget.tablePeak[i] / 1048576.0);
+        }
+    }
+    pthread_mutex_unlock(&memoryBudget.lock);
+    // the resident size is in kilobytes on Linux
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        printf("memory process peak resident %.1f MB\n", usage.ru_maxrss / 1024.0);
+    }
+}
+
+// set to stop the running search at once. A depth that is stopped part of the
+// way through is thrown away.
+atomic_int searchStop;
+// the time the running search is stopped at, 0 for no limit. It is set by the
+// thread that starts a search and read by the search itself.
+_Atomic double searchDeadline = 0;
+
+/*
+ * Purpose:
+ *      To search a position to a fixed depth with negamax alpha-beta pruning
+ *      using the incremental evaluation at the leaves
+ * Parameters:
+ *      position - the position to search. It is restored before returning.
+ *      depth - the number of moves left to search
+ *      alpha - the score the player to move is already guaranteed
+ *      beta - the score the opponent is already guaranteed
+ *      nodes - the counter incremented for every position searched
+ * Returns:
+ *      The score of the position for the player to move
+ * Side-Effects:
+ *      NONE - every move made is unmade
+ */
+int searchPosition(Position* position, const int depth, int alpha, int beta, long long* nodes) {
+    // the counter for the column order
+    int i = 0;
+
+    (*nodes)++;
+    // reading the clock is slow so the deadline is only checked now and then
+    if (((*nodes & 1023) == 0) && (atomic_load_explicit(&searchDeadline, memory_order_relaxed) > 0) && (monotonicSeconds() > atomic_load_explicit(&searchDeadline, memory_order_relaxed))) {
+        atomic_store(&searchStop, 1);
+    }
+    if (atomic_load_explicit(&searchStop, memory_order_relaxed)) {
+        return alpha;
+    }
+    // the board is full so the game is a tie
+    if (position->moveCount == NUM_CELLS) {
+        return 0;
+    }
+    if (depth == 0) {
+        return staticEvaluation(position);
+    }
+    for (i = 0; i < BOARD_COLUMNS; i++) {
+        int column = columnOrder[i];
+        int score = 0;
+        if (!canPlay(position, column)) {
+            continue;
+        }
+        if (makeMove(position, column)) {
+            // the move wins, the score is reduced the later the win comes
+            score = WIN_SCORE - position->moveCount;
+        } else {
+            score = -searchPosition(position, depth - 1, -beta, -alpha, nodes);
+        }
+        unmakeMove(position, column);
+        if (score > alpha) {
+            alpha = score;
+            if (alpha >= beta) {
+                break;
+            }
+        }
+    }
+
+    return alpha;
+}
+
+/*
+ * Purpose:
+ *      To find the best column for the player to move with a fixed depth search
+ * Parameters:
+ *      position - the position to search
+ *      depth - the number of moves to search
+ *      bestScore - set to the score of the best move
+ *      nodes - the counter incremented for every position searched
+ * Returns:
+ *      The best column index (0 - 6), or -1 if every column is full
+ * Side-Effects:
+ *      NONE - the position is restored before returning
+ */
+int searchBestMove(Position* position, const int depth, int* bestScore, long long* nodes) {
+    // the best column found so far
+    int bestColumn = -1;
+    // the counter for the column order
+    int i = 0;
+
+    *bestScore = -WIN_SCORE - 1;
+    for (i = 0; i < BOARD_COLUMNS; i++) {
+        int column = columnOrder[i];
+        int score = 0;
+        if (!canPlay(position, column)) {
+            continue;
+        }
+        if (makeMove(position, column)) {
+            score = WIN_SCORE - position->moveCount;
+        } else if (depth <= 1) {
+            score = -staticEvaluation(position);
+        } else {
+            score = -searchPosition(position, depth - 1, -WIN_SCORE - 1, -*bestScore, nodes);
+        }
+        unmakeMove(position, column);
+        if (score > *bestScore) {
+            *bestScore = score;
+            bestColumn = column;
+        }
+    }
+
+    return bestColumn;
+}
+
+// the number of messages a ring buffer holds, a power of two
+#define RING_SIZE 256
+// the most frontends that can attach to one engine
+#define MAX_FRONTENDS 4
+// the kinds of message the engine sends its frontends: the progress of a search
+// after each depth, and the move chosen with the board after it
+#define MESSAGE_PROGRESS 0
+#define MESSAGE_MOVE 1
+
+/*
+ * A message from the engine to a frontend
+ */
+typedef struct {
+    // the kind of message
+    int type;
+    // the depth finished, its score and best column
+    int depth;
+    int score;
+    int column;
+    // the number of positions searched and the time taken so far
+    long long nodes;
+    double seconds;
+    // the pieces of the first and second player, of the position searched in
+    // a progress message and of the position after the move in a move message
+    uint64_t pieces[2];
+} EngineMessage;
+
+/*
+ * A single producer, single consumer queue of engine messages that needs no
+ * locks. The producer only writes head and the consumer only writes tail, and
+ * each is on its own cache line so the two sides do not slow each other down.
+ * It is placed in shared memory so a frontend in a forked process can read it.
+ */
+typedef struct {
+    // the number of messages ever pushed
+    _Alignas(64) atomic_size_t head;
+    // the number of messages ever popped
+    _Alignas(64) atomic_size_t tail;
+    // the message slots, a message is at its count modulo RING_SIZE
+    _Alignas(64) EngineMessage messages[RING_SIZE];
+} RingBuffer;
+
+/*
+ * The frontends attached to an engine, each with its own ring buffer so every
+ * ring keeps a single consumer
+ */
+typedef struct {
+    // the ring buffer of each frontend
+    RingBuffer* frontends[MAX_FRONTENDS];
+    // the number of frontends attached
+    int frontendCount;
+} EngineChannel;
+
+/*
+ * Purpose:
+ *      To create an empty ring buffer in memory that is shared with child processes
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      The ring buffer, or NULL if the memory could not be mapped
+ * Side-Effects:
+ *      The memory is mapped
+ */
+RingBuffer* createRingBuffer() {
+    // the mapped memory, zero filled so both counts start at 0
+    void* memory = mmap(NULL, sizeof(RingBuffer), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    return (memory == MAP_FAILED) ? NULL : memory;
+}
+
+/*
+ * Purpose:
+ *      To free a ring buffer
+ * Parameters:
+ *      ring - the ring buffer, may be NULL
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The memory is unmapped
+ */
+void freeRingBuffer(RingBuffer* ring) {
+    if (ring != NULL) {
+        munmap(ring, sizeof(RingBuffer));
+    }
+}
+
+/*
+ * Purpose:
+ *      To add a message to a ring buffer, called by its producer only
+ * Parameters:
+ *      ring - the ring buffer
+ *      message - the message to add
+ * Returns:
+ *      1 if the message was added, or 0 if the ring is full
+ * Side-Effects:
+ *      The message is copied into the ring and made visible to the consumer
+ */
+int pushRingBuffer(RingBuffer* ring, const EngineMessage* message) {
+    // the producers own count can be read relaxed, the consumers must be
+    // acquired so its slot is known to have been read before it is reused
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail == RING_SIZE) {
+        return 0;
+    }
+    ring->messages[head & (RING_SIZE - 1)] = *message;
+    // release so the message is written before the consumer sees the new head
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To take the oldest message from a ring buffer, called by its consumer only
+ * Parameters:
+ *      ring - the ring buffer
+ *      message - set to the message taken
+ * Returns:
+ *      1 if a message was taken, or 0 if the ring is empty
+ * Side-Effects:
+ *      The slot of the message is handed back to the producer
+ */
+int popRingBuffer(RingBuffer* ring, EngineMessage* message) {
+    // the consumers own count can be read relaxed, the producers must be
+    // acquired so the message it published is visible
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail == head) {
+        return 0;
+    }
+    *message = ring->messages[tail & (RING_SIZE - 1)];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To attach a frontend to an engine channel
+ * Parameters:
+ *      channel - the engine channel
+ *      ring - the ring buffer the frontend reads
+ * Returns:
+ *      1 if the frontend was attached, or 0 if the channel is full
+ * Side-Effects:
+ *      The engine sends every later message to the frontend as well
+ */
+int attachFrontend(EngineChannel* channel, RingBuffer* ring) {
+    if (channel->frontendCount == MAX_FRONTENDS) {
+        return 0;
+    }
+    channel->frontends[channel->frontendCount++] = ring;
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To send a message to every frontend attached to an engine channel. The
+ *      engine never waits for a slow frontend to make room for a progress
+ *      message, those are dropped, but a move is always delivered.
+ * Parameters:
+ *      channel - the engine channel, may be NULL
+ *      message - the message to send
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The message is added to each frontends ring buffer
+ */
+void publishMessage(EngineChannel* channel, const EngineMessage* message) {
+    // the counter for the frontends
+    int i = 0;
+
+    if (channel == NULL) {
+        return;
+    }
+    for (i = 0; i < channel->frontendCount; i++) {
+        while ((!pushRingBuffer(channel->frontends[i], message)) && (message->type == MESSAGE_MOVE)) {
+            sched_yield();
+        }
+    }
+}
+
+/*
+ * Purpose:
+ *      To search a position with iterative deepening until the time allowed is
+ *      used up. A deeper search is only started if the time the last one took,
+ *      grown by the rate the searches have been growing, still fits in the time
+ *      wanted. A search still running at the time limit, or when searchStop is
+ *      set, is stopped and the result of the last finished depth is kept.
+ * Parameters:
+ *      position - the position to search
+ *      seconds - the time wanted for the search, 0 for no limit
+ *      maxSeconds - the time the search is stopped at, 0 for no limit
+ *      maxDepth - the deepest search to run, 0 for no limit
+ *      info - the file a line is printed to after each depth, may be NULL
+ *      progress - the channel a progress message is sent on after each depth, may be NULL
+ *      bestScore - set to the score of the best move
+ *      depthReached - set to the depth of the last finished search
+ *      nodes - the number of positions searched is added to this
+ * Returns:
+ *      The best column index found, or -1 if the board is full. If the search was
+ *      stopped before the first depth finished the first legal column is returned.
+ * Side-Effects:
+ *      NONE - the position is restored after the search, searchStop is cleared
+ */
+int searchTimed(Position* position, const double seconds, const double maxSeconds, const int maxDepth, FILE* info, EngineChannel* progress, int* bestScore, int* depthReached, long long* nodes) {
+    // the time the search started and the time the last depth took
+    double start = monotonicSeconds();
+    double lastTime = 0;
+    // how much longer each depth takes than the one before
+    double growth = 4;
+    // the best column and score of the last finished depth and of the depth running
+    int bestColumn = -1;
+    int column = -1;
+    int score = 0;
+    // the depth being searched
+    int depth = 1;
+    // the counter for the column order
+    int i = 0;
+
+    *depthReached = 0;
+    *bestScore = 0;
+    atomic_store(&searchDeadline, (maxSeconds > 0) ? start + maxSeconds : 0);
+    for (depth = 1; depth <= NUM_CELLS - position->moveCount; depth++) {
+        double depthStart = monotonicSeconds();
+        double elapsed = depthStart - start;
+        if (((maxDepth > 0) && (depth > maxDepth)) || ((depth > 1) && (seconds > 0) && (elapsed + lastTime * growth > seconds))) {
+            break;
+        }
+        column = searchBestMove(position, depth, &score, nodes);
+        if (atomic_load(&searchStop)) {
+            break;
+        }
+        bestColumn = column;
+        *bestScore = score;
+        *depthReached = depth;
+        // keep a rough average of how fast the search grows, ignoring depths too
+        // quick to time
+        if ((lastTime > 1e-4) && (monotonicSeconds() - depthStart > 1e-4)) {
+            growth = (growth + (monotonicSeconds() - depthStart) / lastTime) / 2;
+        }
+        lastTime = monotonicSeconds() - depthStart;
+        if (info != NULL) {
+            double time = monotonicSeconds() - start;
+            fprintf(info, "info depth %d score %d nodes %lld time %.0f nps %.0f bestmove %d\n", depth, score, *nodes, time * 1000, *nodes / ((time > 0) ? time : 1e-9), column + 1);
+            fflush(info);
+        }
+        if (progress != NULL) {
+            // the progress of the search for the frontends
+            EngineMessage message;
+            message.type = MESSAGE_PROGRESS;
+            message.depth = depth;
+            message.score = score;
+            message.column = column;
+            message.nodes = *nodes;
+            message.seconds = monotonicSeconds() - start;
+            message.pieces[0] = position->pieces[0];
+            message.pieces[1] = position->pieces[1];
+            publishMessage(progress, &message);
+        }
+        // a win or loss has been found so searching deeper will not change the move
+        if ((score > WIN_SCORE - NUM_CELLS) || (score < -WIN_SCORE + NUM_CELLS)) {
+            break;
+        }
+    }
+    atomic_store(&searchDeadline, 0);
+    atomic_store(&searchStop, 0);
+    for (i = 0; (i < BOARD_COLUMNS) && (bestColumn < 0) && (position->moveCount < NUM_CELLS); i++) {
+        if (canPlay(position, columnOrder[i])) {
+            bestColumn = columnOrder[i];
+        }
+    }
+
+    return bestColumn;
+}
+
+// the least time a move on a clock is given. A search given no time at all
+// would run with no limit.
+#define MIN_MOVE_SECONDS 0.001
+
+/*
+ * Purpose:
+ *      To decide how long the computer should think about its next move from the
+ *      time left on its clock. The time is shared over the moves the computer
+ *      probably has left, with more given when the opponent has threats or there
+ *      are few safe moves and the least time when only one move does not lose at once.
+ * Parameters:
+ *      position - the position the computer is to move in
+ *      remaining - the seconds left on the computers clock
+ *      increment - the seconds added to the clock after each move
+ * Returns:
+ *      The number of seconds to think for, at least MIN_MOVE_SECONDS
+ * Side-Effects:
+ *      NONE
+ */
+double allocateMoveTime(const Position* position, const double remaining, const double increment) {
+    // the moves that do not let the opponent win at once
+    int safeCount = __builtin_popcountll(safeMoves(position));
+    // the cells the opponent could win with later, however far up the column
+    uint64_t opponentThreats = winningCells(position->pieces[(position->moveCount + 1) & 1], position->occupied) & boardMask;
+    // the number of moves the computer probably still has to make
+    int movesLeft = (NUM_CELLS - position->moveCount) / 2;
+    // the time to think for
+    double seconds = 0;
+
+    if (safeCount <= 1) {
+        return MIN_MOVE_SECONDS;
+    }
+    // keep a few moves in hand since most games end before the board is full
+    if (movesLeft > 16) {
+        movesLeft = 16;
+    }
+    seconds = remaining / (movesLeft + 2) + increment * 0.8;
+    if ((opponentThreats != 0) || (safeCount <= 3)) {
+        seconds *= 1.5;
+    }
+    // never risk a large part of the clock on one move since a search can overrun
+    if (seconds > remaining / 4) {
+        seconds = remaining / 4;
+    }
+    if (seconds < MIN_MOVE_SECONDS) {
+        seconds = MIN_MOVE_SECONDS;
+    }
+
+    return seconds;
+}
+
+// the proof or disproof number of a node that can never be proven or disproven
+#define PROOF_INFINITY 0xFFFFFFFFu
+
+/*
+ * A node of the proof-number search tree. The children of a node are stored next
+ * to each other in the node pool so only the first one needs to be stored.
+ */
+typedef struct {
+    // the number of leaf nodes that must be proven to prove this node
+    uint32_t proof;
+    // the number of leaf nodes that must be disproven to disprove this node
+    uint32_t disproof;
+    // the index of the parent node, or -1 for the root
+    int32_t parent;
+    // the index of the first child, or -1 if the node has not been expanded
+    int32_t firstChild;
+    // the number of children
+    unsigned char childCount;
+    // the column index of the move that leads to this node from its parent
+    unsigned char column;
+} ProofNode;
+
+/*
+ * The state of one proof-number search
+ */
+typedef struct {
+    // the pool every node is allocated from
+    ProofNode* nodes;
+    // the number of nodes in the pool
+    int32_t capacity;
+    // the number of nodes used so far
+    int32_t used;
+    // the player (0 or 1) trying to prove a win
+    int attacker;
+    // the position of the node currently being worked on
+    Position position;
+} ProofSearch;
+
+/*
+ * Purpose:
+ *      To add two proof numbers without overflowing past infinity
+ * Parameters:
+ *      a, b - the proof numbers to add
+ * Returns:
+ *      The sum, or PROOF_INFINITY if either number is infinite or the sum overflows
+ * Side-Effects:
+ *      NONE
+ */
+uint32_t addProofNumbers(const uint32_t a, const uint32_t b) {
+    return ((a == PROOF_INFINITY) || (b == PROOF_INFINITY) || (a + b < a)) ? PROOF_INFINITY : a + b;
+}
+
+/*
+ * Purpose:
+ *      To find the moves worth searching for the player to move and settle the
+ *      node straight away if the game is already decided. A player that can win
+ *      at once wins, a player facing two immediate threats or with only moves
+ *      that let the opponent win on top loses, and a player facing one threat
+ *      must block it.
+ * Parameters:
+ *      position - the position of the node
+ *      moves - set to the bitboard of the moves to search
+ * Returns:
+ *      1 if the player to move wins, -1 if they lose, 2 if the game is a tie,
+ *      0 if the node needs to be searched
+ * Side-Effects:
+ *      NONE
+ */
+int classifyProofNode(const Position* position, uint64_t* moves) {
+    // the player to move
+    int player = position->moveCount & 1;
+    // the cells the opponent wins in by playing there next
+    uint64_t threats = winningMoves(position, player ^ 1);
+
+    *moves = 0;
+    if (winningMoves(position, player)) {
+        return 1;
+    }
+    if (position->moveCount == NUM_CELLS) {
+        return 2;
+    }
+    // two threats cannot both be blocked
+    if (threats & (threats - 1)) {
+        return -1;
+    }
+    *moves = safeMoves(position);
+    // a single threat must be blocked
+    if (threats) {
+        *moves &= threats;
+    }
+    if (*moves == 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To set the proof and disproof numbers of a new leaf node
+ * Parameters:
+ *      search - the proof-number search
+ *      node - the node to set up. The search position must be the node's position.
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The node's proof and disproof numbers are set
+ */
+void initProofNode(ProofSearch* search, ProofNode* node) {
+    // the moves that would be searched from the node
+    uint64_t moves = 0;
+    // the result of the node if the game is already decided
+    int result = classifyProofNode(&search->position, &moves);
+    // set if the attacker is the player to move at this node
+    int attackerToMove = (search->position.moveCount & 1) == search->attacker;
+
+    node->firstChild = -1;
+    node->childCount = 0;
+    if ((result == 2) || ((result != 0) && ((result == 1) != attackerToMove))) {
+        // a tie or a win for the defender disproves the node
+        node->proof = PROOF_INFINITY;
+        node->disproof = 0;
+    } else if (result != 0) {
+        node->proof = 0;
+        node->disproof = PROOF_INFINITY;
+    } else if (attackerToMove) {
+        // the attacker needs only one good move, so more moves make it harder to disprove
+        node->proof = 1;
+        node->disproof = __builtin_popcountll(moves);
+    } else {
+        node->proof = __builtin_popcountll(moves);
+        node->disproof = 1;
+    }
+}
+
+/*
+ * Purpose:
+ *      To recompute the proof and disproof numbers of an expanded node from its children
+ * Parameters:
+ *      search - the proof-number search
+ *      node - the node to update
+ *      attackerToMove - set if the attacker is the player to move at the node
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The node's proof and disproof numbers are updated
+ */
+void updateProofNode(ProofSearch* search, ProofNode* node, const int attackerToMove) {
+    // the counter for the children
+    int i = 0;
+    // the smallest and summed numbers over the children
+    uint32_t smallest = PROOF_INFINITY;
+    uint32_t sum = 0;
+
+    for (i = 0; i < node->childCount; i++) {
+        const ProofNode* child = &search->nodes[node->firstChild + i];
+        if (attackerToMove) {
+            smallest = (child->proof < smallest) ? child->proof : smallest;
+            sum = addProofNumbers(sum, child->disproof);
+        } else {
+            smallest = (child->disproof < smallest) ? child->disproof : smallest;
+            sum = addProofNumbers(sum, child->proof);
+        }
+    }
+    if (attackerToMove) {
+        node->proof = smallest;
+        node->disproof = sum;
+    } else {
+        node->proof = sum;
+        node->disproof = smallest;
+    }
+}
+
+/*
+ * Purpose:
+ *      To create the children of a leaf node
+ * Parameters:
+ *      search - the proof-number search
+ *      index - the index of the node to expand. The search position must be the node's position.
+ * Returns:
+ *      1 if the children were created, 0 if the node pool is full
+ * Side-Effects:
+ *      Nodes are allocated from the pool and the search position is restored
+ */
+int expandProofNode(ProofSearch* search, const int32_t index) {
+    // the moves to create children for
+    uint64_t moves = 0;
+    // the counter for the column order
+    int i = 0;
+
+    classifyProofNode(&search->position, &moves);
+    if (search->used + __builtin_popcountll(moves) > search->capacity) {
+        return 0;
+    }
+    search->nodes[index].firstChild = search->used;
+    for (i = 0; i < BOARD_COLUMNS; i++) {
+        int column = columnOrder[i];
+        ProofNode* child = NULL;
+        // only columns with a move in the mask get a child
+        if (!(moves & columnMask(column))) {
+            continue;
+        }
+        child = &search->nodes[search->used++];
+        child->parent = index;
+        child->column = (unsigned char)column;
+        makeMove(&search->position, column);
+        initProofNode(search, child);
+        unmakeMove(&search->position, column);
+        search->nodes[index].childCount++;
+    }
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To prove or disprove that the player to move can force a win with a
+ *      proof-number search. The most-proving leaf is expanded each step and the
+ *      numbers are passed back up only as far as they change.
+ * Parameters:
+ *      root - the position to search
+ *      memoryBytes - the most memory the search tree may use
+ *      bestColumn - set to the column index that proves the win, or -1
+ *      nodeCount - set to the number of nodes created
+ * Returns:
+ *      1 if the player to move can force a win, 0 if they cannot, -1 if the
+ *      memory limit was reached before the question was answered
+ * Side-Effects:
+ *      NONE - the tree is freed before returning
+ */
+int proveWin(const Position* root, const size_t memoryBytes, int* bestColumn, long long* nodeCount) {
+    // the search state
+    ProofSearch search;
+    // the node currently being worked on
+    int32_t current = 0;
+    // the result of the search
+    int result = -1;
+    // the bytes the memory budget allows for the tree
+    size_t bytes = 0;
+    // the counter for the root children
+    int i = 0;
+
+    search.capacity = (int32_t)((memoryBytes / sizeof(ProofNode) > 0x7FFFFFFF) ? 0x7FFFFFFF : memoryBytes / sizeof(ProofNode));
+    bytes = reserveMemory(MEMORY_PROOF_TREE, (size_t)search.capacity * sizeof(ProofNode), MEMORY_MIN_TABLE);
+    search.capacity = (int32_t)(bytes / sizeof(ProofNode));
+    search.nodes = (search.capacity > 0) ? malloc((size_t)search.capacity * sizeof(ProofNode)) : NULL;
+    *bestColumn = -1;
+    *nodeCount = 0;
+    if ((search.nodes == NULL) || (search.capacity < 1)) {
+        free(search.nodes);
+        releaseMemory(MEMORY_PROOF_TREE, bytes);
+        return -1;
+    }
+    search.position = *root;
+    search.attacker = root->moveCount & 1;
+    search.used = 1;
+    search.nodes[0].parent = -1;
+    search.nodes[0].column = 0;
+    initProofNode(&search, &search.nodes[0]);
+
+    while ((search.nodes[0].proof != 0) && (search.nodes[0].disproof != 0)) {
+        // walk down to the most-proving leaf
+        while (search.nodes[current].firstChild >= 0) {
+            ProofNode* node = &search.nodes[current];
+            int attackerToMove = (search.position.moveCount & 1) == search.attacker;
+            int32_t best = node->firstChild;
+            for (i = 1; i < node->childCount; i++) {
+                ProofNode* child = &search.nodes[node->firstChild + i];
+                if ((attackerToMove) ? (child->proof < search.nodes[best].proof) : (child->disproof < search.nodes[best].disproof)) {
+                    best = node->firstChild + i;
+                }
+            }
+            current = best;
+            makeMove(&search.position, search.nodes[current].column);
+        }
+        if (!expandProofNode(&search, current)) {
+            break;
+        }
+        // pass the new numbers back up until a node does not change
+        while (1) {
+            ProofNode* node = &search.nodes[current];
+            uint32_t oldProof = node->proof;
+            uint32_t oldDisproof = node->disproof;
+            updateProofNode(&search, node, (search.position.moveCount & 1) == search.attacker);
+            if (((node->proof == oldProof) && (node->disproof == oldDisproof)) || (node->parent < 0)) {
+                break;
+            }
+            unmakeMove(&search.position, node->column);
+            current = node->parent;
+        }
+    }
+
+    if (search.nodes[0].proof == 0) {
+        result = 1;
+        // the root child with a proof number of 0 is the winning move
+        for (i = 0; i < search.nodes[0].childCount; i++) {
+            if (search.nodes[search.nodes[0].firstChild + i].proof == 0) {
+                *bestColumn = search.nodes[search.nodes[0].firstChild + i].column;
+            }
+        }
+        // the root was proven without being expanded because a move wins at once
+        if (*bestColumn < 0) {
+            *bestColumn = bitboardColumn(winningMoves(root, search.attacker));
+        }
+    } else if (search.nodes[0].disproof == 0) {
+        result = 0;
+    }
+    *nodeCount = search.used;
+    free(search.nodes);
+    releaseMemory(MEMORY_PROOF_TREE, bytes);
+
+    return result;
+}
+
+// the lowest and highest exact scores a position can have. A score is positive
+// when the player to move wins and is larger the sooner they win.
+#define MIN_SCORE (-(NUM_CELLS) / 2 + 3)
+#define MAX_SCORE ((NUM_CELLS + 1) / 2 - 3)
+// the number of moves played below which the solver stores mirrored positions together
+#define SYMMETRY_MOVES 16
+
+/*
+ * The board used by the exact solver, kept as small as possible so it can be
+ * copied for every node. Only the pieces of the player to move are stored, the
+ * opponents pieces are current ^ mask.
+ */
+typedef struct {
+    // the bitboard of the pieces of the player to move
+    uint64_t current;
+    // the bitboard of every piece on the board
+    uint64_t mask;
+    // the number of moves that have been played
+    int moveCount;
+} SolverBoard;
+
+// the number of positions stored in each compressed block of an opening book
+#define BOOK_BLOCK_ENTRIES 256
+// the score stored for a book position that has not been solved yet
+#define BOOK_UNSOLVED 127
+// returned by solveBookPositions when a signal stopped the build, and when it
+// finished with positions left unsolved
+#define BOOK_BUILD_STOPPED -1
+#define BOOK_BUILD_FAILED -2
+
+/*
+ * A database of exact scores for every position from minPly to maxPly moves.
+ * Mirrored positions are stored once under the smaller of their two keys. While
+ * a book is being built the sorted keys and scores are held in memory, after
+ * that it is read from a file of compressed blocks. Each block holds the scores
+ * of BOOK_BLOCK_ENTRIES positions followed by the gaps between their keys as
+ * variable length numbers, and an index of the first key and file offset of
+ * every block is kept in memory so a lookup reads and decodes one block.
+ */
+typedef struct OpeningBook {
+    // the range of plies the book covers
+    int minPly;
+    int maxPly;
+    // the number of positions in the book
+    size_t count;
+    // the sorted keys and scores of a book held in memory, NULL for a book file
+    uint64_t* keys;
+    signed char* scores;
+    // the open book file, or -1 for a book held in memory
+    int file;
+    // the number of blocks, the first key of each block and the file offset of
+    // each block (with one extra offset for the end of the last block)
+    size_t blockCount;
+    uint64_t* blockKeys;
+    uint64_t* blockOffsets;
+    // the bytes of the keys and scores held in memory taken from the memory budget
+    size_t memoryBytes;
+} OpeningBook;
+
+// the opening book the solver looks positions up in, NULL if none is loaded
+OpeningBook* activeBook = NULL;
+
+// the kinds of job a checkpoint can be saved for
+#define CHECKPOINT_SOLVE 1
+#define CHECKPOINT_BOOK 2
+
+// the file long solves and book builds save their progress to, NULL to save none
+const char* checkpointName = NULL;
+// the seconds between checkpoints
+double checkpointInterval = 300;
+// set by SIGTERM or SIGINT to save a checkpoint and stop
+volatile sig_atomic_t checkpointRequested = 0;
+
+/*
+ * The state of the exact solver. The transposition table stores a bound on the
+ * score of each position it has searched so the repeated null-window searches
+ * do not repeat work.
+ */
+typedef struct {
+    // the transposition table entries. Each holds the position key in the low
+    // 56 bits and the encoded bound in the high 8 bits, 0 is an empty entry
+    uint64_t* table;
+    // the number of bits used to index the table
+    int tableBits;
+    // the number of positions searched
+    long long nodes;
+    // the number of positions after which the solve is given up, 0 for no limit
+    long long nodeLimit;
+    // set once the node limit is reached. The scores returned after that are
+    // meaningless and nothing more is stored in the table.
+    int aborted;
+    // the opening book to take the scores of early positions from, may be NULL
+    const OpeningBook* book;
+    // set to save the table to the checkpoint file while solving, the key of
+    // the position being solved, the range its score is known to be in and the
+    // time the next checkpoint is due
+    int checkpointing;
+    uint64_t rootKey;
+    int rootLowest;
+    int rootHighest;
+    double nextCheckpoint;
+} Solver;
+
+/*
+ * Purpose:
+ *      To set up a solver board from a search position
+ * Parameters:
+ *      board - the solver board to set up
+ *      position - the position to copy
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The solver board is overwritten
+ */
+void loadSolverBoard(SolverBoard* board, const Position* position) {
+    board->current = position->pieces[position->moveCount & 1];
+    board->mask = position->occupied;
+    board->moveCount = position->moveCount;
+}
+
+/*
+ * Purpose:
+ *      To get a key that is different for every position. In each column the
+ *      pieces of the player to move plus one bit above the top piece is unique.
+ * Parameters:
+ *      board - the solver board
+ * Returns:
+ *      The key of the position, never 0
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t solverKey(const SolverBoard* board) {
+    return board->current + board->mask + bottomMask;
+}
+
+/*
+ * Purpose:
+ *      To get the key of the position reflected left to right
+ * Parameters:
+ *      key - the key of a position
+ * Returns:
+ *      The key of the mirrored position
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t mirrorKey(const uint64_t key) {
+    // the key being built
+    uint64_t mirrored = 0;
+    // the counter for the columns
+    int column = 0;
+
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        // the bits of one column, including the spare bit on top
+        uint64_t bits = (key >> (column * BITBOARD_HEIGHT)) & (((uint64_t)1 << BITBOARD_HEIGHT) - 1);
+        mirrored |= bits << ((BOARD_COLUMNS - 1 - column) * BITBOARD_HEIGHT);
+    }
+
+    return mirrored;
+}
+
+/*
+ * Purpose:
+ *      To play a move on a solver board
+ * Parameters:
+ *      board - the solver board
+ *      move - the bitboard of the cell to play, one of the playable cells
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The board is modified and the player to move is switched
+ */
+void playSolverMove(SolverBoard* board, const uint64_t move) {
+    board->current ^= board->mask;
+    board->mask |= move;
+    board->moveCount++;
+}
+
+/*
+ * Purpose:
+ *      To find the moves that do not lose straight away. If the opponent has a
+ *      cell they win in next move it must be blocked, and a move directly below
+ *      a cell the opponent wins in would let them play there.
+ * Parameters:
+ *      board - the solver board. The player to move must not have a winning move.
+ * Returns:
+ *      A bitboard of the moves that do not lose on the next move, 0 if every move loses
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t nonLosingMoves(const SolverBoard* board) {
+    // the cells a piece can be played in
+    uint64_t possible = playableCells(board->mask);
+    // the cells the opponent wins in
+    uint64_t opponentWins = winningCells(board->current ^ board->mask, board->mask);
+    // the opponents wins that can be played next move
+    uint64_t forced = possible & opponentWins;
+
+    if (forced) {
+        // two threats at once cannot both be blocked
+        if (forced & (forced - 1)) {
+            return 0;
+        }
+        possible = forced;
+    }
+
+    return possible & ~(opponentWins >> 1);
+}
+
+/*
+ * Purpose:
+ *      To check if the player to move on a solver board can win with their next move
+ * Parameters:
+ *      board - the solver board
+ * Returns:
+ *      Non zero if a playable cell completes four in a row for the player to move
+ * Side-Effects:
+ *      NONE
+ */
+int canWinNext(const SolverBoard* board) {
+    return (winningCells(board->current, board->mask) & playableCells(board->mask)) != 0;
+}
+
+/*
+ * Purpose:
+ *      To allocate the transposition table of a solver
+ * Parameters:
+ *      solver - the solver to set up
+ *      megabytes - the size of the transposition table, rounded down to a power of two entries
+ *                  and halved until it fits the memory budget
+ * Returns:
+ *      1 if the table was allocated, 0 if there was not enough memory
+ * Side-Effects:
+ *      The table is allocated and cleared and its memory is taken from the budget
+ */
+int initSolver(Solver* solver, const int megabytes) {
+    // the number of entries that fit in the requested memory
+    size_t entries = ((size_t)megabytes << 20) / sizeof(uint64_t);
+    // the bytes the memory budget allows for the table
+    size_t bytes = 0;
+
+    solver->tableBits = 1;
+    while (((size_t)1 << (solver->tableBits + 1)) <= entries) {
+        solver->tableBits++;
+    }
+    bytes = reserveMemory(MEMORY_TRANSPOSITION, ((size_t)1 << solver->tableBits) * sizeof(uint64_t), MEMORY_MIN_TABLE);
+    while ((solver->tableBits > 1) && (((size_t)1 << solver->tableBits) * sizeof(uint64_t) > bytes)) {
+        solver->tableBits--;
+    }
+    solver->table = (bytes > 0) ? calloc((size_t)1 << solver->tableBits, sizeof(uint64_t)) : NULL;
+    if ((solver->table == NULL) && (bytes > 0)) {
+        releaseMemory(MEMORY_TRANSPOSITION, bytes);
+    }
+    solver->nodes = 0;
+    solver->nodeLimit = 0;
+    solver->aborted = 0;
+    solver->book = activeBook;
+    solver->checkpointing = 0;
+
+    return solver->table != NULL;
+}
+
+/*
+ * Purpose:
+ *      To free the transposition table of a solver
+ * Parameters:
+ *      solver - the solver
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The table is freed and its memory is given back to the budget
+ */
+void freeSolver(Solver* solver) {
+    if (solver->table != NULL) {
+        releaseMemory(MEMORY_TRANSPOSITION, ((size_t)1 << solver->tableBits) * sizeof(uint64_t));
+    }
+    free(solver->table);
+    solver->table = NULL;
+}
+
+/*
+ * Purpose:
+ *      To find the index of the transposition table entry a key is stored in
+ * Parameters:
+ *      solver - the solver
+ *      key - the position key
+ * Returns:
+ *      The index into the table
+ * Side-Effects:
+ *      NONE
+ */
+size_t solverTableIndex(const Solver* solver, const uint64_t key) {
+    // multiplying by a large odd constant mixes every bit of the key into the top bits
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - solver->tableBits));
+}
+
+/*
+ * Purpose:
+ *      To look up the stored bound for a position
+ * Parameters:
+ *      solver - the solver
+ *      key - the position key
+ * Returns:
+ *      The encoded bound, or 0 if the position is not in the table
+ * Side-Effects:
+ *      NONE
+ */
+int getSolverEntry(const Solver* solver, const uint64_t key) {
+    // the entry the key would be stored in
+    uint64_t entry = solver->table[solverTableIndex(solver, key)];
+
+    return ((entry & 0x00FFFFFFFFFFFFFFull) == key) ? (int)(entry >> 56) : 0;
+}
+
+/*
+ * Purpose:
+ *      To store a bound for a position, replacing whatever was in its entry
+ * Parameters:
+ *      solver - the solver
+ *      key - the position key
+ *      value - the encoded bound (1 - 255)
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The table entry is overwritten
+ */
+void putSolverEntry(Solver* solver, const uint64_t key, const int value) {
+    if (!solver->aborted) {
+        solver->table[solverTableIndex(solver, key)] = key | ((uint64_t)value << 56);
+    }
+}
+
+/*
+ * Purpose:
+ *      To rebuild the solver board a key was made from
+ * Parameters:
+ *      key - the key of a position
+ *      board - set to the position
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The board is overwritten
+ */
+void decodeSolverKey(const uint64_t key, SolverBoard* board) {
+    // the counter for the columns
+    int column = 0;
+
+    board->current = 0;
+    board->mask = 0;
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        // each column of the key is the pieces of the player to move plus the
+        // bit above the top piece, so the highest set bit gives the height
+        uint64_t bits = (key >> (column * BITBOARD_HEIGHT)) & (((uint64_t)1 << BITBOARD_HEIGHT) - 1);
+        int height = 63 - __builtin_clzll(bits);
+        board->mask |= (((uint64_t)1 << height) - 1) << (column * BITBOARD_HEIGHT);
+        board->current |= (bits - ((uint64_t)1 << height)) << (column * BITBOARD_HEIGHT);
+    }
+    board->moveCount = __builtin_popcountll(board->mask);
+}
+
+/*
+ * Purpose:
+ *      To get the key a position is stored under in an opening book
+ * Parameters:
+ *      board - the position
+ * Returns:
+ *      The smaller of the keys of the position and of its mirror image
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t canonicalKey(const SolverBoard* board) {
+    // the key of the position and of its mirror image
+    uint64_t key = solverKey(board);
+    uint64_t mirrored = mirrorKey(key);
+
+    return (mirrored < key) ? mirrored : key;
+}
+
+/*
+ * Purpose:
+ *      To read a little endian 64 bit number from a file
+ * Parameters:
+ *      file - the file to read from
+ *      value - set to the number read
+ * Returns:
+ *      1 if 8 bytes were read, otherwise 0
+ * Side-Effects:
+ *      The file position is advanced
+ */
+int readUint64(FILE* file, uint64_t* value) {
+    // the low and high halves of the number
+    uint32_t low = 0;
+    uint32_t high = 0;
+
+    if ((!readUint32(file, &low)) || (!readUint32(file, &high))) {
+        return 0;
+    }
+    *value = low | ((uint64_t)high << 32);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To write a little endian 64 bit number to a file
+ * Parameters:
+ *      file - the file to write to
+ *      value - the number to write
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      8 bytes are written to the file
+ */
+void writeUint64(FILE* file, const uint64_t value) {
+    writeUint32(file, (uint32_t)value);
+    writeUint32(file, (uint32_t)(value >> 32));
+}
+
+/*
+ * Purpose:
+ *      To write a number to a file as a variable length number of 7 bits per
+ *      byte, with the high bit set on every byte but the last
+ * Parameters:
+ *      file - the file to write to
+ *      value - the number to write
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      1 to 10 bytes are written to the file
+ */
+void writeVarint(FILE* file, uint64_t value) {
+    while (value >= 0x80) {
+        fputc((int)((value & 0x7F) | 0x80), file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+/*
+ * Purpose:
+ *      To read a variable length number written by writeVarint
+ * Parameters:
+ *      file - the file to read from
+ *      value - set to the number read
+ * Returns:
+ *      1 if a whole number was read, otherwise 0
+ * Side-Effects:
+ *      The file position is advanced
+ */
+int readVarint(FILE* file, uint64_t* value) {
+    // the byte read
+    int byte = 0;
+    // the position of the next 7 bits
+    int shift = 0;
+
+    *value = 0;
+    do {
+        byte = fgetc(file);
+        if ((byte == EOF) || (shift > 63)) {
+            return 0;
+        }
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To start writing a checkpoint. It is written to a temporary file first so
+ *      a crash while it is written leaves the last checkpoint whole.
+ * Parameters:
+ *      kind - the CHECKPOINT_ kind of job
+ * Returns:
+ *      The temporary file with the checkpoint header written, or NULL if it could not be created
+ * Side-Effects:
+ *      The temporary file is created
+ */
+FILE* openCheckpoint(const uint32_t kind) {
+    // the name of the temporary file
+    char temporaryName[PATH_MAX];
+    // the temporary file
+    FILE* file = NULL;
+
+    snprintf(temporaryName, sizeof(temporaryName), "%s.tmp", checkpointName);
+    file = fopen(temporaryName, "wb");
+    if (file != NULL) {
+        fwrite("C4CP", 1, 4, file);
+        writeUint32(file, 1);
+        writeUint32(file, kind);
+    }
+
+    return file;
+}
+
+/*
+ * Purpose:
+ *      To finish writing a checkpoint and put it in place of the last one
+ * Parameters:
+ *      file - the temporary file from openCheckpoint
+ * Returns:
+ *      1 if the checkpoint was saved, otherwise 0
+ * Side-Effects:
+ *      The temporary file is flushed to disk, closed and renamed over the checkpoint file
+ */
+int closeCheckpoint(FILE* file) {
+    // the name of the temporary file
+    char temporaryName[PATH_MAX];
+    // set if everything was written
+    int saved = (fflush(file) == 0) && (!ferror(file)) && (fsync(fileno(file)) == 0);
+
+    saved = (fclose(file) == 0) && (saved);
+    snprintf(temporaryName, sizeof(temporaryName), "%s.tmp", checkpointName);
+    if ((!saved) || (rename(temporaryName, checkpointName) != 0)) {
+        fprintf(stderr, "Could not save the checkpoint '%s'\n", checkpointName);
+        remove(temporaryName);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To open the checkpoint file and check it is for this kind of job
+ * Parameters:
+ *      kind - the CHECKPOINT_ kind of job
+ *      file - set to the checkpoint file, positioned after the header
+ * Returns:
+ *      1 if the checkpoint was opened, 0 if there is none, -1 if it is not a
+ *      checkpoint of this kind
+ * Side-Effects:
+ *      The file is opened if 1 is returned
+ */
+int openResume(const uint32_t kind, FILE** file) {
+    // the magic bytes, version and kind from the header
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t fileKind = 0;
+
+    *file = fopen(checkpointName, "rb");
+    if (*file == NULL) {
+        return 0;
+    }
+    if ((fread(magic, 1, 4, *file) != 4) || (memcmp(magic, "C4CP", 4) != 0) || (!readUint32(*file, &version)) || (version != 1) || (!readUint32(*file, &fileKind)) || (fileKind != kind)) {
+        fclose(*file);
+        *file = NULL;
+        return -1;
+    }
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To save the range the score of a solve is known to be in and its
+ *      transposition table, so a solve that is restarted skips the null-window
+ *      searches already finished and finds the bounds already proved. Only the
+ *      used entries are saved, each as the gap from the last used index and the entry.
+ * Parameters:
+ *      solver - the solver
+ * Returns:
+ *      1 if the checkpoint was saved, otherwise 0
+ * Side-Effects:
+ *      The checkpoint file is replaced
+ */
+int writeSolverCheckpoint(const Solver* solver) {
+    // the checkpoint file
+    FILE* file = openCheckpoint(CHECKPOINT_SOLVE);
+    // the number of table entries and of used entries
+    size_t size = (size_t)1 << solver->tableBits;
+    uint64_t used = 0;
+    // the index of the last used entry written
+    size_t last = 0;
+    // the counter for the entries
+    size_t i = 0;
+
+    if (file == NULL) {
+        fprintf(stderr, "Could not save the checkpoint '%s'\n", checkpointName);
+        return 0;
+    }
+    for (i = 0; i < size; i++) {
+        used += (solver->table[i] != 0);
+    }
+    writeUint32(file, solver->tableBits);
+    writeUint64(file, solver->rootKey);
+    writeUint32(file, (uint32_t)solver->rootLowest);
+    writeUint32(file, (uint32_t)solver->rootHighest);
+    writeUint64(file, solver->nodes);
+    writeUint64(file, used);
+    for (i = 0; i < size; i++) {
+        if (solver->table[i] != 0) {
+            writeVarint(file, i - last);
+            writeUint64(file, solver->table[i]);
+            last = i;
+        }
+    }
+
+    return closeCheckpoint(file);
+}
+
+/*
+ * Purpose:
+ *      To load the transposition table of a solve from its checkpoint
+ * Parameters:
+ *      solver - the solver, with its table allocated and its root key set
+ * Returns:
+ *      1 if the solve was resumed, 0 if there is no checkpoint, -1 if the
+ *      checkpoint is for another solve or table size or is damaged
+ * Side-Effects:
+ *      The table and node count of the solver are loaded
+ */
+int readSolverCheckpoint(Solver* solver) {
+    // the checkpoint file
+    FILE* file = NULL;
+    // the table size, root key, score range, node count and used entries from the checkpoint
+    uint32_t tableBits = 0;
+    uint64_t rootKey = 0;
+    uint32_t lowest = 0;
+    uint32_t highest = 0;
+    uint64_t nodes = 0;
+    uint64_t used = 0;
+    // the index of the entry being read and its gap from the last one
+    uint64_t index = 0;
+    uint64_t gap = 0;
+    // set while the file is valid
+    int valid = openResume(CHECKPOINT_SOLVE, &file);
+    // the counter for the entries
+    uint64_t i = 0;
+
+    if (valid <= 0) {
+        return valid;
+    }
+    valid = (readUint32(file, &tableBits)) && (tableBits == (uint32_t)solver->tableBits) && (readUint64(file, &rootKey)) && (rootKey == solver->rootKey) && (readUint32(file, &lowest)) && (readUint32(file, &highest)) && (readUint64(file, &nodes)) && (readUint64(file, &used));
+    for (i = 0; (i < used) && (valid); i++) {
+        valid = (readVarint(file, &gap)) && (index + gap < ((uint64_t)1 << tableBits));
+        index += gap;
+        valid = (valid) && (readUint64(file, &solver->table[index]));
+    }
+    fclose(file);
+    if (!valid) {
+        memset(solver->table, 0, ((size_t)1 << solver->tableBits) * sizeof(uint64_t));
+        return -1;
+    }
+    solver->nodes = (long long)nodes;
+    solver->rootLowest = (int)lowest;
+    solver->rootHighest = (int)highest;
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To save a checkpoint of a solve when one is due or has been asked for by
+ *      a signal. A signal also stops the solve once the checkpoint is saved.
+ * Parameters:
+ *      solver - the solver
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The checkpoint file may be replaced and the solve may be aborted
+ */
+void checkpointSolver(Solver* solver) {
+    // the time now
+    double now = monotonicSeconds();
+
+    if ((checkpointRequested) || (now >= solver->nextCheckpoint)) {
+        writeSolverCheckpoint(solver);
+        solver->nextCheckpoint = now + checkpointInterval;
+        if (checkpointRequested) {
+            solver->aborted = 1;
+        }
+    }
+}
+
+/*
+ * Purpose:
+ *      To ask a long job to save a checkpoint and stop, as the SIGTERM and SIGINT
+ *      handler. The checkpoint is saved by the job, not inside the handler.
+ * Parameters:
+ *      signalNumber - the signal received
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      checkpointRequested is set
+ */
+void requestCheckpoint(int signalNumber) {
+    (void)signalNumber;
+    checkpointRequested = 1;
+}
+
+/*
+ * Purpose:
+ *      To have SIGTERM and SIGINT save a checkpoint while a job that polls
+ *      checkpointRequested runs, and to give them back their default action after
+ * Parameters:
+ *      catching - 1 to install the checkpoint handler, 0 to restore the defaults
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The SIGTERM and SIGINT handlers are changed if a checkpoint file was given
+ */
+void catchCheckpointSignals(const int catching) {
+    if (checkpointName != NULL) {
+        signal(SIGTERM, (catching) ? requestCheckpoint : SIG_DFL);
+        signal(SIGINT, (catching) ? requestCheckpoint : SIG_DFL);
+    }
+}
+
+/*
+ * Purpose:
+ *      To look up the exact score of a position in an opening book
+ * Parameters:
+ *      book - the opening book
+ *      board - the position to look up
+ *      score - set to the exact score for the player to move if it is found
+ * Returns:
+ *      1 if the position is in the book and solved, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int lookupBook(const OpeningBook* book, const SolverBoard* board, int* score) {
+    // the key the position is stored under
+    uint64_t key = 0;
+    // the ends of the binary search
+    size_t low = 0;
+    size_t high = 0;
+
+    if ((board->moveCount < book->minPly) || (board->moveCount > book->maxPly) || (book->count == 0)) {
+        return 0;
+    }
+    key = canonicalKey(board);
+    if (book->keys != NULL) {
+        // binary search the sorted keys held in memory
+        low = 0;
+        high = book->count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (book->keys[middle] < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if ((low < book->count) && (book->keys[low] == key) && (book->scores[low] != BOOK_UNSOLVED)) {
+            *score = book->scores[low];
+            return 1;
+        }
+        return 0;
+    } else {
+        // the block data read from the file
+        unsigned char block[BOOK_BLOCK_ENTRIES * 11];
+        // the size of the block, its number of entries and the read position in it
+        size_t size = 0;
+        size_t entries = 0;
+        size_t offset = 0;
+        // the key of the entry being decoded
+        uint64_t entryKey = 0;
+        // the counter for the entries in the block
+        size_t i = 0;
+
+        // find the last block whose first key is not after the key
+        low = 0;
+        high = book->blockCount;
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (book->blockKeys[middle] <= key) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        if (key < book->blockKeys[low]) {
+            return 0;
+        }
+        size = book->blockOffsets[low + 1] - book->blockOffsets[low];
+        entries = (low + 1 < book->blockCount) ? BOOK_BLOCK_ENTRIES : book->count - low * BOOK_BLOCK_ENTRIES;
+        if ((size > sizeof(block)) || (pread(book->file, block, size, (off_t)book->blockOffsets[low]) != (ssize_t)size)) {
+            return 0;
+        }
+        // the scores come first, then the gaps between the keys
+        entryKey = book->blockKeys[low];
+        offset = entries;
+        for (i = 0; (i < entries) && (entryKey < key); i++) {
+            if (i + 1 == entries) {
+                return 0;
+            }
+            uint64_t gap = 0;
+            int shift = 0;
+            while ((offset < size) && (block[offset] & 0x80)) {
+                gap |= (uint64_t)(block[offset++] & 0x7F) << shift;
+                shift += 7;
+            }
+            gap |= (uint64_t)block[offset++] << shift;
+            entryKey += gap;
+        }
+        // a position stored without a score is not in the book
+        if ((entryKey == key) && ((signed char)block[i] != BOOK_UNSOLVED)) {
+            *score = (signed char)block[i];
+            return 1;
+        }
+        return 0;
+    }
+}
+
+/*
+ * Purpose:
+ *      To find the exact score of a position inside a window with negamax alpha-beta.
+ *      Only moves that do not lose at once are searched, ordered by how many
+ *      winning cells they create, and bounds are stored in the transposition table.
+ *      Upper bounds are stored as score - MIN_SCORE + 1 and lower bounds as
+ *      score + MAX_SCORE - 2 * MIN_SCORE + 2 so both fit in one byte.
+ * Parameters:
+ *      solver - the solver
+ *      board - the position. The player to move must not be able to win next move.
+ *      alpha - the lower end of the window
+ *      beta - the upper end of the window
+ * Returns:
+ *      The exact score if it is inside the window, otherwise a bound on the side
+ *      of the window it is on
+ * Side-Effects:
+ *      The transposition table is updated
+ */
+int solveNegamax(Solver* solver, const SolverBoard* board, int alpha, int beta) {
+    // the moves that do not lose at once
+    uint64_t next = nonLosingMoves(board);
+    // the key of the position
+    uint64_t key = 0;
+    // the stored bound for the position
+    int stored = 0;
+    // the lowest and highest scores still possible
+    int lowest = 0;
+    int highest = 0;
+    // the moves to search and their ordering scores, best first
+    uint64_t moves[BOARD_COLUMNS];
+    int moveScores[BOARD_COLUMNS];
+    int moveCount = 0;
+    // counters for the moves
+    int i = 0;
+    int j = 0;
+
+    solver->nodes++;
+    if ((solver->nodeLimit > 0) && (solver->nodes > solver->nodeLimit)) {
+        solver->aborted = 1;
+    }
+    // a solve run by the engine can be stopped or given a time limit
+    if (((solver->nodes & 4095) == 0) && (atomic_load_explicit(&searchDeadline, memory_order_relaxed) > 0) && (monotonicSeconds() > atomic_load_explicit(&searchDeadline, memory_order_relaxed))) {
+        atomic_store(&searchStop, 1);
+    }
+    if (((solver->nodes & 4095) == 0) && (solver->checkpointing)) {
+        checkpointSolver(solver);
+    }
+    if (atomic_load_explicit(&searchStop, memory_order_relaxed)) {
+        solver->aborted = 1;
+    }
+    if (solver->aborted) {
+        return alpha;
+    }
+    // every move lets the opponent win
+    if (next == 0) {
+        return -(NUM_CELLS - board->moveCount) / 2;
+    }
+    // neither player can win with the last two moves so the game is a tie
+    if (board->moveCount >= NUM_CELLS - 2) {
+        return 0;
+    }
+    // the opponent cannot win with their next move so the score is at least this
+    lowest = -(NUM_CELLS - 2 - board->moveCount) / 2;
+    if (alpha < lowest) {
+        alpha = lowest;
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+    // the player to move cannot win with this move so the score is at most this
+    highest = (NUM_CELLS - 1 - board->moveCount) / 2;
+    // early positions may already be solved in the opening book
+    if ((solver->book != NULL) && (lookupBook(solver->book, board, &stored))) {
+        return stored;
+    }
+    key = solverKey(board);
+    // near the start of the game a position and its mirror image are often both
+    // reached, so they share one entry. Later on it is not worth the extra work.
+    if (board->moveCount < SYMMETRY_MOVES) {
+        uint64_t mirrored = mirrorKey(key);
+        key = (mirrored < key) ? mirrored : key;
+    }
+    stored = getSolverEntry(solver, key);
+    if (stored > MAX_SCORE - MIN_SCORE + 1) {
+        lowest = stored + 2 * MIN_SCORE - MAX_SCORE - 2;
+        if (alpha < lowest) {
+            alpha = lowest;
+            if (alpha >= beta) {
+                return alpha;
+            }
+        }
+    } else if (stored != 0) {
+        highest = stored + MIN_SCORE - 1;
+    }
+    if (beta > highest) {
+        beta = highest;
+        if (alpha >= beta) {
+            return beta;
+        }
+    }
+
+    // sort the moves by the number of winning cells they create with an insertion
+    // sort. Columns are added from the edges in so ties keep the centre first.
+    for (i = BOARD_COLUMNS - 1; i >= 0; i--) {
+        uint64_t move = next & columnMask(columnOrder[i]);
+        int score = 0;
+        if (!move) {
+            continue;
+        }
+        score = __builtin_popcountll(winningCells(board->current | move, board->mask));
+        for (j = moveCount; (j > 0) && (moveScores[j - 1] > score); j--) {
+            moves[j] = moves[j - 1];
+            moveScores[j] = moveScores[j - 1];
+        }
+        moves[j] = move;
+        moveScores[j] = score;
+        moveCount++;
+    }
+
+    // the best moves are at the end of the sorted list
+    for (i = moveCount - 1; i >= 0; i--) {
+        SolverBoard child = *board;
+        int score = 0;
+        playSolverMove(&child, moves[i]);
+        score = -solveNegamax(solver, &child, -beta, -alpha);
+        if (score >= beta) {
+            putSolverEntry(solver, key, score + MAX_SCORE - 2 * MIN_SCORE + 2);
+            return score;
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+    }
+    putSolverEntry(solver, key, alpha - MIN_SCORE + 1);
+
+    return alpha;
+}
+
+/*
+ * Purpose:
+ *      To find the exact score of a position by narrowing the range of possible
+ *      scores with null-window searches until only one score is left
+ * Parameters:
+ *      solver - the solver
+ *      board - the position to solve. The game must not be over.
+ * Returns:
+ *      The exact score for the player to move: positive if they win, 0 for a tie,
+ *      negative if they lose. The size of a win or loss is larger the sooner it comes.
+ *      The score is meaningless if the solver's node limit was reached.
+ * Side-Effects:
+ *      The transposition table is updated
+ */
+int solveBoard(Solver* solver, const SolverBoard* board) {
+    // the range the score is known to be in
+    int lowest = -(NUM_CELLS - board->moveCount) / 2;
+    int highest = (NUM_CELLS + 1 - board->moveCount) / 2;
+
+    if (canWinNext(board)) {
+        return (NUM_CELLS + 1 - board->moveCount) / 2;
+    }
+    // a solve carried on from a checkpoint starts from the range already found
+    if (solver->checkpointing) {
+        lowest = (solver->rootLowest > lowest) ? solver->rootLowest : lowest;
+        highest = (solver->rootHighest < highest) ? solver->rootHighest : highest;
+    }
+    while (lowest < highest) {
+        // the score tested by the next null-window search. Testing closer to 0
+        // first settles the sign of the score, which is the most common question.
+        int middle = lowest + (highest - lowest) / 2;
+        int result = 0;
+        if ((middle <= 0) && (lowest / 2 < middle)) {
+            middle = lowest / 2;
+        } else if ((middle >= 0) && (highest / 2 > middle)) {
+            middle = highest / 2;
+        }
+        result = solveNegamax(solver, board, middle, middle + 1);
+        if (solver->aborted) {
+            break;
+        }
+        if (result <= middle) {
+            highest = result;
+        } else {
+            lowest = result;
+        }
+        solver->rootLowest = lowest;
+        solver->rootHighest = highest;
+    }
+
+    return lowest;
+}
+
+/*
+ * Purpose:
+ *      To get the score of the position after a move without searching again
+ *      if the move ends the game
+ * Parameters:
+ *      solver - the solver
+ *      board - the position the move is played from
+ *      move - the bitboard of the cell played
+ *      score - set to the exact score of the position after the move for the player to move there
+ * Returns:
+ *      1 if the move wins the game, otherwise 0
+ * Side-Effects:
+ *      The transposition table is updated
+ */
+int solveAfterMove(Solver* solver, const SolverBoard* board, const uint64_t move, int* score) {
+    // the position after the move
+    SolverBoard child = *board;
+
+    // the move completes four in a row
+    if (winningCells(board->current, board->mask) & move) {
+        *score = -(NUM_CELLS + 1 - board->moveCount) / 2;
+        return 1;
+    }
+    playSolverMove(&child, move);
+    *score = (child.moveCount == NUM_CELLS) ? 0 : solveBoard(solver, &child);
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To find the principal variation of a solved position, the line of moves
+ *      where both players play perfectly. Each step only checks that a move
+ *      reaches the known score with a null-window search, which the
+ *      transposition table makes cheap.
+ * Parameters:
+ *      solver - the solver
+ *      board - the solved position
+ *      score - the exact score of the position
+ *      variation - set to the column indexes of the line, ending with -1
+ *      maxLength - the size of the variation array
+ * Returns:
+ *      The number of moves in the line
+ * Side-Effects:
+ *      The transposition table is updated
+ */
+int solvePrincipalVariation(Solver* solver, const SolverBoard* board, int score, int* variation, const int maxLength) {
+    // the position at the current step of the line
+    SolverBoard current = *board;
+    // the number of moves in the line
+    int length = 0;
+    // the counter for the column order
+    int i = 0;
+
+    while ((length < maxLength - 1) && (current.moveCount < NUM_CELLS)) {
+        // the column played at this step
+        int bestColumn = -1;
+        // the move played at this step
+        uint64_t bestMove = 0;
+        // set if the best move wins the game
+        int winning = 0;
+        for (i = 0; (i < BOARD_COLUMNS) && (bestColumn < 0); i++) {
+            uint64_t move = playableCells(current.mask) & columnMask(columnOrder[i]);
+            SolverBoard child = current;
+            int childScore = 0;
+            if (!move) {
+                continue;
+            }
+            if (winningCells(current.current, current.mask) & move) {
+                winning = 1;
+                bestColumn = columnOrder[i];
+                bestMove = move;
+                continue;
+            }
+            playSolverMove(&child, move);
+            if (child.moveCount == NUM_CELLS) {
+                childScore = 0;
+            } else if (canWinNext(&child)) {
+                childScore = (NUM_CELLS + 1 - child.moveCount) / 2;
+            } else {
+                // the child is at least -score, check that it is not more
+                childScore = solveNegamax(solver, &child, -score, -score + 1);
+            }
+            if (childScore <= -score) {
+                bestColumn = columnOrder[i];
+                bestMove = move;
+            }
+        }
+        if (bestColumn < 0) {
+            break;
+        }
+        variation[length++] = bestColumn;
+        if (winning) {
+            break;
+        }
+        playSolverMove(&current, bestMove);
+        score = -score;
+    }
+    variation[length] = -1;
+
+    return length;
+}
+
+/*
+ * Purpose:
+ *      To convert a solver score into the number of moves until the game ends
+ * Parameters:
+ *      score - the exact score for the player to move
+ *      moveCount - the number of moves already played
+ * Returns:
+ *      The number of moves, including the winning move, until the winner
+ *      completes four in a row, or 0 for a tie
+ * Side-Effects:
+ *      NONE
+ */
+int scoreToDistance(const int score, const int moveCount) {
+    // the number of moves played before the winning move
+    int movesBeforeWin = 0;
+
+    if (score == 0) {
+        return 0;
+    }
+    // a win for the player to move is scored (NUM_CELLS + 1 - movesBeforeWin) / 2,
+    // and the parity of movesBeforeWin tells whose move the win was
+    movesBeforeWin = NUM_CELLS + 1 - 2 * ((score > 0) ? score : -score);
+    if (((movesBeforeWin - moveCount) & 1) != ((score > 0) ? 0 : 1)) {
+        movesBeforeWin--;
+    }
+
+    return movesBeforeWin - moveCount + 1;
+}
+
+/*
+ * The score of one move in a ranking of every legal move
+ */
+typedef struct {
+    // the column index of the move
+    int column;
+    // the score of the move for the player making it
+    int score;
+    // set if the score is exact, otherwise the score is only an upper bound
+    // because the move was shown to be no better than the moves ranked above it
+    int exact;
+    // the principal variation starting with the move, ending with -1
+    int variation[NUM_CELLS + 1];
+} RankedMove;
+
+/*
+ * Purpose:
+ *      To sort ranked moves with the exact scores first, best to worst, and the
+ *      upper bounds after them
+ * Parameters:
+ *      ranked - the moves to sort
+ *      count - the number of moves
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The moves are reordered
+ */
+void sortRankedMoves(RankedMove* ranked, const int count) {
+    // counters for the moves
+    int i = 0;
+    int j = 0;
+
+    for (i = 1; i < count; i++) {
+        RankedMove move = ranked[i];
+        for (j = i; (j > 0) && ((move.exact > ranked[j - 1].exact) || ((move.exact == ranked[j - 1].exact) && (move.score > ranked[j - 1].score))); j--) {
+            ranked[j] = ranked[j - 1];
+        }
+        ranked[j] = move;
+    }
+}
+
+/*
+ * Purpose:
+ *      To get the score a move must beat to be one of the best moves found so far
+ * Parameters:
+ *      ranked - the moves scored so far
+ *      count - the number of moves scored so far
+ *      best - the number of best moves wanted
+ * Returns:
+ *      The score of the best'th best exact score, or INT_MIN if fewer have been found
+ * Side-Effects:
+ *      NONE
+ */
+int rankingBound(const RankedMove* ranked, const int count, const int best) {
+    // the exact scores found so far, best first
+    int scores[BOARD_COLUMNS];
+    int exactCount = 0;
+    // counters for the moves
+    int i = 0;
+    int j = 0;
+
+    for (i = 0; i < count; i++) {
+        if (ranked[i].exact) {
+            for (j = exactCount; (j > 0) && (scores[j - 1] < ranked[i].score); j--) {
+                scores[j] = scores[j - 1];
+            }
+            scores[j] = ranked[i].score;
+            exactCount++;
+        }
+    }
+
+    return (exactCount >= best) ? scores[best - 1] : INT_MIN;
+}
+
+/*
+ * Purpose:
+ *      To find the exact score and principal variation of the best moves of a
+ *      position. Every move shares the solvers transposition table. Once enough
+ *      moves have exact scores each other move is first tested with one
+ *      null-window search against the worst of them, and only a move that beats
+ *      it is solved exactly, so asking for the single best move costs about the
+ *      same as solving the position.
+ * Parameters:
+ *      solver - the solver
+ *      board - the position, the game must not be over
+ *      best - the number of best moves to score exactly, BOARD_COLUMNS for every move
+ *      ranked - set to the legal moves, sorted best first
+ * Returns:
+ *      The number of legal moves
+ * Side-Effects:
+ *      The transposition table is updated
+ */
+int rankMovesExact(Solver* solver, const SolverBoard* board, const int best, RankedMove* ranked) {
+    // the number of legal moves
+    int count = 0;
+    // the counter for the column order
+    int i = 0;
+
+    for (i = 0; i < BOARD_COLUMNS; i++) {
+        // the move and the position after it
+        uint64_t move = playableCells(board->mask) & columnMask(columnOrder[i]);
+        SolverBoard child = *board;
+        // the score to beat to be one of the best moves
+        int bound = rankingBound(ranked, count, best);
+        RankedMove* ranking = &ranked[count];
+        if (move == 0) {
+            continue;
+        }
+        count++;
+        ranking->column = columnOrder[i];
+        ranking->exact = 1;
+        ranking->variation[0] = columnOrder[i];
+        ranking->variation[1] = -1;
+        if (winningCells(board->current, board->mask) & move) {
+            ranking->score = (NUM_CELLS + 1 - board->moveCount) / 2;
+            continue;
+        }
+        playSolverMove(&child, move);
+        if (child.moveCount == NUM_CELLS) {
+            ranking->score = 0;
+            continue;
+        }
+        // the score of the move is the negated score for the opponent after it,
+        // and it beats the bound only if the opponent scores below -bound
+        if ((bound != INT_MIN) && (!canWinNext(&child)) && (solveNegamax(solver, &child, -bound - 1, -bound) >= -bound)) {
+            ranking->score = bound;
+            ranking->exact = 0;
+            continue;
+        }
+        ranking->score = -solveBoard(solver, &child);
+        solvePrincipalVariation(solver, &child, -ranking->score, ranking->variation + 1, NUM_CELLS);
+    }
+    sortRankedMoves(ranked, count);
+
+    return count;
+}
+
+/*
+ * Purpose:
+ *      To find the searched score and principal variation of the best moves of a
+ *      position. Once enough moves have scores each other move is searched with
+ *      its alpha set to the worst of them, so a move that cannot beat it is cut
+ *      off as quickly as in a single search.
+ * Parameters:
+ *      position - the position, it is restored before returning
+ *      depth - the number of moves to search
+ *      best - the number of best moves to score exactly, BOARD_COLUMNS for every move
+ *      ranked - set to the legal moves, sorted best first
+ *      nodes - the number of positions searched is added to this
+ * Returns:
+ *      The number of legal moves
+ * Side-Effects:
+ *      NONE
+ */
+int rankMovesSearch(Position* position, const int depth, const int best, RankedMove* ranked, long long* nodes) {
+    // the number of legal moves
+    int count = 0;
+    // counters for the column order and the variation
+    int i = 0;
+    int j = 0;
+
+    for (i = 0; i < BOARD_COLUMNS; i++) {
+        // the column of the move and the score to beat to be one of the best moves
+        int column = columnOrder[i];
+        int bound = rankingBound(ranked, count, best);
+        RankedMove* ranking = &ranked[count];
+        if (!canPlay(position, column)) {
+            continue;
+        }
+        count++;
+        ranking->column = column;
+        ranking->exact = 1;
+        ranking->variation[0] = column;
+        ranking->variation[1] = -1;
+        if (makeMove(position, column)) {
+            ranking->score = WIN_SCORE - position->moveCount;
+        } else if (depth <= 1) {
+            ranking->score = -staticEvaluation(position);
+        } else {
+            ranking->score = -searchPosition(position, depth - 1, -WIN_SCORE - 1, (bound == INT_MIN) ? WIN_SCORE + 1 : -bound, nodes);
+            if ((bound != INT_MIN) && (ranking->score <= bound)) {
+                ranking->score = bound;
+                ranking->exact = 0;
+            } else {
+                // follow the best reply at each shallower depth for the variation
+                for (j = 1; (j < depth) && (position->moveCount < NUM_CELLS); j++) {
+                    // the score of the reply, not needed
+                    int replyScore = 0;
+                    ranking->variation[j] = searchBestMove(position, depth - j, &replyScore, nodes);
+                    ranking->variation[j + 1] = -1;
+                    if (makeMove(position, ranking->variation[j])) {
+                        j++;
+                        break;
+                    }
+                }
+                // take the variation back off the board
+                while (--j >= 1) {
+                    unmakeMove(position, ranking->variation[j]);
+                }
+            }
+        }
+        unmakeMove(position, column);
+    }
+    sortRankedMoves(ranked, count);
+
+    return count;
+}
+
+// the number of tasks each enumeration worker can queue before it searches
+// new subtrees itself instead of sharing them
+#define TASK_QUEUE_SIZE 4096
+// the deepest ply at which subtrees are queued for other workers to steal
+#define ENUMERATION_SPLIT_PLY 7
+// the most hash set slots probed before the set is treated as full
+#define HASH_SET_MAX_PROBES 4096
+
+/*
+ * A double ended queue of positions waiting to be enumerated. The owning worker
+ * pushes and pops at the bottom so it works depth first, and idle workers steal
+ * from the top where the oldest and largest subtrees are.
+ */
+typedef struct {
+    // the lock held while the queue is changed
+    pthread_mutex_t lock;
+    // the queued positions, used as a ring buffer
+    SolverBoard tasks[TASK_QUEUE_SIZE];
+    // the number of tasks taken from the top and pushed to the bottom so far
+    long long top;
+    long long bottom;
+} TaskQueue;
+
+/*
+ * The state shared by every worker of a parallel enumeration
+ */
+typedef struct {
+    // the open addressing hash set of position keys seen, 0 is an empty slot
+    _Atomic uint64_t* slots;
+    // the number of slots minus one, the number of slots is a power of two
+    size_t slotMask;
+    // the number of tasks queued or being worked on. The workers stop when it reaches 0
+    atomic_llong pending;
+    // set if a key could not be added because the hash set was too full
+    atomic_int overflow;
+    // one queue for every worker
+    TaskQueue* queues;
+    // the number of workers
+    int threadCount;
+    // the last ply to enumerate
+    int targetPly;
+} Enumeration;
+
+/*
+ * One worker thread of a parallel enumeration
+ */
+typedef struct {
+    // the shared enumeration state
+    Enumeration* enumeration;
+    // the index of the worker and its queue
+    int id;
+    // the number of new positions found at each ply
+    long long counts[NUM_CELLS + 1];
+    // the thread running the worker
+    pthread_t thread;
+} EnumerationWorker;
+
+/*
+ * Purpose:
+ *      To check if a player has four in a row anywhere on the board
+ * Parameters:
+ *      pieces - the bitboard of the players pieces
+ * Returns:
+ *      Non zero if four pieces are connected in any direction
+ * Side-Effects:
+ *      NONE
+ */
+int hasFourInARow(const uint64_t pieces) {
+    // the shift for one step vertically, up-left, horizontally and up-right
+    const int steps[4] = {1, BITBOARD_HEIGHT - 1, BITBOARD_HEIGHT, BITBOARD_HEIGHT + 1};
+    // the pieces with a neighbour in the direction being checked
+    uint64_t pairs = 0;
+    // the counter for the direction
+    int i = 0;
+
+    for (i = 0; i < 4; i++) {
+        pairs = pieces & (pieces >> steps[i]);
+        if (pairs & (pairs >> (2 * steps[i]))) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// the largest board whose size can be picked at run time
+#define WIDE_MAX_COLUMNS 16
+#define WIDE_MAX_ROWS 15
+// the number of 64 bit words in a wide bitboard, enough for the largest board
+// with a spare bit on top of every column
+#define WIDE_WORDS 4
+// the most shifts used to find a line in one direction, enough to double a
+// run of pieces up to the longest line and make up the rest
+#define WIDE_MAX_SHIFTS 6
+
+#if WIDE_MAX_COLUMNS * (WIDE_MAX_ROWS + 1) > 64 * WIDE_WORDS
+#error "the largest board does not fit in a wide bitboard"
+#endif
+
+/*
+ * A bitboard for boards too big for 64 bits, laid out like the fixed size
+ * bitboards (column by column with a spare bit on top of every column) and
+ * split over several words with the lowest cells in the first word
+ */
+typedef struct {
+    uint64_t words[WIDE_WORDS];
+} WideBitboard;
+
+/*
+ * The size of a board picked at run time and the masks that go with it, shared
+ * by every position played on a board of that size
+ */
+typedef struct {
+    // the number of columns and rows, and the number of pieces to connect to win
+    int columns;
+    int rows;
+    int connectLength;
+    // the number of bits used for each column, one more than the rows
+    int height;
+    // the number of words the board uses
+    int wordCount;
+    // the number of directions a line fits on the board in, and for each of
+    // them the shifts that find the runs of pieces as long as a line
+    int directionCount;
+    int shiftCounts[4];
+    int shifts[4][WIDE_MAX_SHIFTS];
+    // the bottom cell of every column, and every cell of the board
+    WideBitboard bottomMask;
+    WideBitboard boardMask;
+    // the column of every bit of the board, so a move found as a bit does not
+    // need a division to find its column
+    unsigned char cellColumns[WIDE_WORDS * 64];
+} WideLayout;
+
+/*
+ * A position on a board whose size is picked at run time. Player 0 is the
+ * player that moved first.
+ */
+typedef struct {
+    // the size of the board
+    const WideLayout* layout;
+    // the bitboards of each players pieces and of every piece on the board
+    WideBitboard pieces[2];
+    WideBitboard occupied;
+    // the number of pieces in each column
+    unsigned char heights[WIDE_MAX_COLUMNS];
+    // the number of moves that have been played
+    int moveCount;
+} WidePosition;
+
+/*
+ * Purpose:
+ *      To keep the cells of a wide bitboard that are still set after the
+ *      bitboard is shifted down by a number of bits. The words are updated from
+ *      the bottom up so every word above is read before it is changed.
+ * Parameters:
+ *      words - the words of the bitboard followed by at least WIDE_WORDS + 1
+ *              empty words, so the words above the top word can be read
+ *              without checking for the end
+ *      wordCount - the number of words the board uses
+ *      shift - the number of bits to shift by
+ * Returns:
+ *      Non zero if any cell is still set
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t andShiftedWide(uint64_t* words, const int wordCount, const int shift) {
+    // the number of whole words and the bits left over
+    int wordShift = shift >> 6;
+    int bitShift = shift & 63;
+    // every word ored together
+    uint64_t any = 0;
+    // the counter for the words
+    int i = 0;
+
+    for (i = 0; i < wordCount; i++) {
+        // the word above is shifted in two steps so a shift of 0 bits does not
+        // shift it by the undefined 64 bits
+        words[i] &= (words[i + wordShift] >> bitShift) | ((words[i + wordShift + 1] << 1) << (63 - bitShift));
+        any |= words[i];
+    }
+
+    return any;
+}
+
+/*
+ * Purpose:
+ *      To set up the masks for a board size picked at run time
+ * Parameters:
+ *      layout - the layout to fill in
+ *      columns - the number of columns (up to WIDE_MAX_COLUMNS)
+ *      rows - the number of rows (up to WIDE_MAX_ROWS)
+ *      connectLength - the number of pieces to connect to win
+ * Returns:
+ *      1 if the size is supported, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int initWideLayout(WideLayout* layout, const int columns, const int rows, const int connectLength) {
+    // the shift for one step vertically, up-left, horizontally and up-right
+    const int steps[4] = {1, rows, rows + 1, rows + 2};
+    // if a line fits on the board in each direction
+    const int fits[4] = {connectLength <= rows, (connectLength <= rows) && (connectLength <= columns), connectLength <= columns, (connectLength <= rows) && (connectLength <= columns)};
+    // the length of the runs of pieces found by the shifts so far
+    int length = 0;
+    // the counter for the directions
+    int i = 0;
+    // the counter for the columns and the first bit of the column
+    int column = 0;
+    int bit = 0;
+
+    if ((columns < 1) || (columns > WIDE_MAX_COLUMNS) || (rows < 1) || (rows > WIDE_MAX_ROWS) || (connectLength < 2) || ((connectLength > columns) && (connectLength > rows))) {
+        return 0;
+    }
+    memset(layout, 0, sizeof(WideLayout));
+    layout->columns = columns;
+    layout->rows = rows;
+    layout->connectLength = connectLength;
+    layout->height = rows + 1;
+    layout->wordCount = (columns * layout->height + 63) / 64;
+    for (column = 0; column < columns; column++) {
+        bit = column * layout->height;
+        layout->bottomMask.words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+        // the rows of a column can run over into the next word
+        for (; bit < column * layout->height + rows; bit++) {
+            layout->boardMask.words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+            layout->cellColumns[bit] = (unsigned char)column;
+        }
+    }
+    // a shift by a step keeps the pieces with a neighbour, so doubling the
+    // length of the runs with each shift finds a line in a few shifts. The
+    // last shift overlaps two runs to make up the rest of the length.
+    for (i = 0; i < 4; i++) {
+        if (!fits[i]) {
+            continue;
+        }
+        for (length = 1; length * 2 <= connectLength; length *= 2) {
+            layout->shifts[layout->directionCount][layout->shiftCounts[layout->directionCount]++] = length * steps[i];
+        }
+        if (length < connectLength) {
+            layout->shifts[layout->directionCount][layout->shiftCounts[layout->directionCount]++] = (connectLength - length) * steps[i];
+        }
+        layout->directionCount++;
+    }
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To set a wide position to the empty board
+ * Parameters:
+ *      position - the position
+ *      layout - the size of the board
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void initWidePosition(WidePosition* position, const WideLayout* layout) {
+    memset(position, 0, sizeof(WidePosition));
+    position->layout = layout;
+}
+
+/*
+ * Purpose:
+ *      To check if a player has connected enough pieces anywhere on a board that
+ *      fits in one word, with plain shifts like the fixed size bitboards. A line
+ *      that fits on the board spans less than a word, so no shift is by a whole word.
+ * Parameters:
+ *      pieces - the bitboard of the players pieces
+ *      layout - the size of the board, which must use one word
+ * Returns:
+ *      1 if enough pieces are connected in any direction, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int hasNarrowLine(const uint64_t pieces, const WideLayout* layout) {
+    // the cells that start a run of pieces in the direction being checked
+    uint64_t any = 0;
+    // the counters for the direction and the shift
+    int i = 0;
+    int k = 0;
+
+    for (i = 0; i < layout->directionCount; i++) {
+        any = pieces;
+        if (layout->shiftCounts[i] == 2) {
+            // the two shifts of a line of three or four, without the loop
+            any &= any >> layout->shifts[i][0];
+            any &= any >> layout->shifts[i][1];
+        } else {
+            for (k = 0; (k < layout->shiftCounts[i]) && any; k++) {
+                any &= any >> layout->shifts[i][k];
+            }
+        }
+        if (any) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To check if a player has connected enough pieces anywhere on a wide board.
+ *      A run of pieces is doubled in length with each shift, so the number of
+ *      shifts per direction grows with the log of the connect length, and the
+ *      spare bit on top of every column stops runs wrapping between columns.
+ * Parameters:
+ *      pieces - the bitboard of the players pieces
+ *      layout - the size of the board
+ * Returns:
+ *      1 if enough pieces are connected in any direction, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int hasWideLine(const WideBitboard pieces, const WideLayout* layout) {
+    // the cells that start a run of pieces in the direction being checked,
+    // followed by the empty words andShiftedWide reads past the top
+    uint64_t runs[2 * WIDE_WORDS + 1];
+    // if any runs are left
+    uint64_t any = 0;
+    // the counters for the direction and the shift
+    int i = 0;
+    int k = 0;
+
+    if (layout->wordCount == 1) {
+        return hasNarrowLine(pieces.words[0], layout);
+    }
+
+    memset(runs + layout->wordCount, 0, (2 * WIDE_WORDS + 1 - layout->wordCount) * sizeof(uint64_t));
+    for (i = 0; i < layout->directionCount; i++) {
+        memcpy(runs, pieces.words, layout->wordCount * sizeof(uint64_t));
+        any = 1;
+        for (k = 0; (k < layout->shiftCounts[i]) && any; k++) {
+            any = andShiftedWide(runs, layout->wordCount, layout->shifts[i][k]);
+        }
+        if (any) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To find the cells a piece can be dropped into on a wide board, one per
+ *      column that is not full
+ * Parameters:
+ *      position - the position
+ * Returns:
+ *      A bitboard of the lowest empty cell of every column
+ * Side-Effects:
+ *      NONE
+ */
+WideBitboard wideMoves(const WidePosition* position) {
+    // the playable cells
+    WideBitboard cells = {{0}};
+    // the carry out of the word below
+    uint64_t carry = 0;
+    // the counter for the words
+    int i = 0;
+
+    // adding a bit to the bottom of each column carries up to the first empty
+    // cell, and the carry of a column that runs over a word goes into the next word
+    for (i = 0; i < position->layout->wordCount; i++) {
+        uint64_t sum = position->occupied.words[i] + position->layout->bottomMask.words[i];
+        uint64_t carried = sum + carry;
+
+        carry = (sum < position->occupied.words[i]) || (carried < sum);
+        cells.words[i] = carried & position->layout->boardMask.words[i];
+    }
+
+    return cells;
+}
+
+/*
+ * Purpose:
+ *      To play a move on a wide board
+ * Parameters:
+ *      position - the position
+ *      column - the column index, which must not be full
+ * Returns:
+ *      1 if the move connects enough pieces to win, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int makeWideMove(WidePosition* position, const int column) {
+    // the player moving and the bit of the cell the piece lands in
+    int player = position->moveCount & 1;
+    int bit = column * position->layout->height + position->heights[column];
+
+    position->pieces[player].words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    position->occupied.words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    position->heights[column]++;
+    position->moveCount++;
+
+    return hasWideLine(position->pieces[player], position->layout);
+}
+
+/*
+ * Purpose:
+ *      To take back the last move played in a column of a wide board
+ * Parameters:
+ *      position - the position
+ *      column - the column index of the last move
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void unmakeWideMove(WidePosition* position, const int column) {
+    // the bit of the cell the piece is taken from
+    int bit = 0;
+
+    position->moveCount--;
+    position->heights[column]--;
+    bit = column * position->layout->height + position->heights[column];
+    position->pieces[position->moveCount & 1].words[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+    position->occupied.words[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+}
+
+/*
+ * Purpose:
+ *      To count the games of a number of moves on a board that fits in one word,
+ *      in the same way as countFixedGames but with the masks and shifts of the layout
+ * Parameters:
+ *      layout - the size of the board, which must use one word
+ *      pieces - the bitboard of the pieces of the player to move
+ *      occupied - the bitboard of every piece on the board
+ *      depth - the number of moves to play
+ * Returns:
+ *      The number of games
+ * Side-Effects:
+ *      NONE
+ */
+long long countNarrowGames(const WideLayout* layout, const uint64_t pieces, const uint64_t occupied, const int depth) {
+    // the cells that can be played
+    uint64_t moves = 0;
+    // the number of games
+    long long games = 0;
+
+    if (depth == 0) {
+        return 1;
+    }
+    moves = (occupied + layout->bottomMask.words[0]) & layout->boardMask.words[0];
+    while (moves != 0) {
+        // the lowest playable cell
+        uint64_t cell = moves & -moves;
+
+        moves ^= cell;
+        // the player who moved becomes the opponent of the next player to move
+        games += hasNarrowLine(pieces | cell, layout) ? 1 : countNarrowGames(layout, (pieces | cell) ^ (occupied | cell), occupied | cell, depth - 1);
+    }
+
+    return (games > 0) ? games : 1;
+}
+
+/*
+ * Purpose:
+ *      To count the games of a number of moves that follow a wide position,
+ *      stopping at wins and full boards. A board that fits in one word is
+ *      counted by countNarrowGames without the loops over words.
+ * Parameters:
+ *      position - the position, left as it was
+ *      depth - the number of moves to play
+ * Returns:
+ *      The number of games
+ * Side-Effects:
+ *      NONE
+ */
+long long countWideGames(WidePosition* position, const int depth) {
+    // the cells that can be played
+    WideBitboard moves;
+    // the number of games
+    long long games = 0;
+    // the counter for the words
+    int i = 0;
+
+    if (position->layout->wordCount == 1) {
+        return countNarrowGames(position->layout, position->pieces[position->moveCount & 1].words[0], position->occupied.words[0], depth);
+    }
+    if (depth == 0) {
+        return 1;
+    }
+    moves = wideMoves(position);
+    for (i = 0; i < position->layout->wordCount; i++) {
+        while (moves.words[i] != 0) {
+            // the column of the lowest playable cell
+            int column = position->layout->cellColumns[i * 64 + __builtin_ctzll(moves.words[i])];
+
+            moves.words[i] &= moves.words[i] - 1;
+            games += makeWideMove(position, column) ? 1 : countWideGames(position, depth - 1);
+            unmakeWideMove(position, column);
+        }
+    }
+
+    return (games > 0) ? games : 1;
+}
+
+/*
+ * Purpose:
+ *      To count the games of a number of moves on the fixed size board in the
+ *      same way as countWideGames, so the two can be checked and timed against
+ *      each other
+ * Parameters:
+ *      pieces - the bitboard of the pieces of the player to move
+ *      occupied - the bitboard of every piece on the board
+ *      depth - the number of moves to play
+ * Returns:
+ *      The number of games
+ * Side-Effects:
+ *      NONE
+ */
+long long countFixedGames(const uint64_t pieces, const uint64_t occupied, const int depth) {
+    // the cells that can be played
+    uint64_t moves = 0;
+    // the number of games
+    long long games = 0;
+
+    if (depth == 0) {
+        return 1;
+    }
+    moves = playableCells(occupied);
+    while (moves != 0) {
+        // the lowest playable cell
+        uint64_t cell = moves & -moves;
+
+        moves ^= cell;
+        // the player who moved becomes the opponent of the next player to move
+        games += hasFourInARow(pieces | cell) ? 1 : countFixedGames((pieces | cell) ^ (occupied | cell), occupied | cell, depth - 1);
+    }
+
+    return (games > 0) ? games : 1;
+}
+
+/*
+ * Purpose:
+ *      To add a key to the shared hash set of an enumeration
+ * Parameters:
+ *      enumeration - the enumeration
+ *      key - the key to add, never 0
+ * Returns:
+ *      1 if the key was not in the set before, otherwise 0
+ * Side-Effects:
+ *      The key is written into an empty slot, or the overflow flag is set if
+ *      there was no empty slot near its home slot
+ */
+int insertEnumerationKey(Enumeration* enumeration, const uint64_t key) {
+    // the slot being probed
+    size_t index = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 17) & enumeration->slotMask;
+    // the counter for the slots probed
+    int probes = 0;
+
+    for (probes = 0; probes < HASH_SET_MAX_PROBES; probes++) {
+        uint64_t found = atomic_load_explicit(&enumeration->slots[index], memory_order_relaxed);
+        if (found == key) {
+            return 0;
+        }
+        if (found == 0) {
+            // claim the empty slot. If another worker got there first, check
+            // what it wrote before moving on as it may be the same key
+            uint64_t expected = 0;
+            if (atomic_compare_exchange_strong(&enumeration->slots[index], &expected, key)) {
+                return 1;
+            }
+            if (expected == key) {
+                return 0;
+            }
+        }
+        index = (index + 1) & enumeration->slotMask;
+    }
+    atomic_store(&enumeration->overflow, 1);
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To queue a position at the bottom of a workers queue
+ * Parameters:
+ *      queue - the workers queue
+ *      board - the position to queue
+ * Returns:
+ *      1 if the position was queued, 0 if the queue is full
+ * Side-Effects:
+ *      The queue is modified
+ */
+int pushTask(TaskQueue* queue, const SolverBoard* board) {
+    // set if there was room for the task
+    int pushed = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->bottom - queue->top < TASK_QUEUE_SIZE) {
+        queue->tasks[queue->bottom % TASK_QUEUE_SIZE] = *board;
+        queue->bottom++;
+        pushed = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return pushed;
+}
+
+/*
+ * Purpose:
+ *      To take a position from a queue, from the bottom for the owner or the top for a thief
+ * Parameters:
+ *      queue - the queue to take from
+ *      fromTop - set when another worker is stealing from the queue
+ *      board - set to the position taken
+ * Returns:
+ *      1 if a position was taken, 0 if the queue was empty
+ * Side-Effects:
+ *      The queue is modified
+ */
+int takeTask(TaskQueue* queue, const int fromTop, SolverBoard* board) {
+    // set if a task was taken
+    int taken = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->bottom > queue->top) {
+        if (fromTop) {
+            *board = queue->tasks[queue->top % TASK_QUEUE_SIZE];
+            queue->top++;
+        } else {
+            queue->bottom--;
+            *board = queue->tasks[queue->bottom % TASK_QUEUE_SIZE];
+        }
+        taken = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return taken;
+}
+
+/*
+ * Purpose:
+ *      To enumerate every position reachable from a position up to the target ply.
+ *      Positions already in the hash set were reached by another move order and
+ *      are not searched again. Subtrees near the root are queued so idle
+ *      workers can steal them.
+ * Parameters:
+ *      worker - the worker doing the enumeration
+ *      board - the position to enumerate from
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      Keys are added to the hash set, the workers counts are increased and tasks may be queued
+ */
+void enumerateFrom(EnumerationWorker* worker, const SolverBoard* board) {
+    // the shared enumeration state
+    Enumeration* enumeration = worker->enumeration;
+    // the cells a piece can be played in
+    uint64_t possible = 0;
+    // the counter for the columns
+    int column = 0;
+
+    if (!insertEnumerationKey(enumeration, solverKey(board))) {
+        return;
+    }
+    worker->counts[board->moveCount]++;
+    // the game is over once the player that moved last has four in a row
+    if ((board->moveCount >= enumeration->targetPly) || (board->moveCount == NUM_CELLS) || (hasFourInARow(board->current ^ board->mask))) {
+        return;
+    }
+    possible = playableCells(board->mask);
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        SolverBoard child = *board;
+        uint64_t move = possible & columnMask(column);
+        if (!move) {
+            continue;
+        }
+        playSolverMove(&child, move);
+        // near the root share the subtree, deeper down search it straight away
+        if (child.moveCount <= ENUMERATION_SPLIT_PLY) {
+            atomic_fetch_add(&enumeration->pending, 1);
+            if (pushTask(&enumeration->queues[worker->id], &child)) {
+                continue;
+            }
+            atomic_fetch_sub(&enumeration->pending, 1);
+        }
+        enumerateFrom(worker, &child);
+    }
+}
+
+/*
+ * Purpose:
+ *      To run one enumeration worker until every queued position has been enumerated
+ * Parameters:
+ *      argument - the EnumerationWorker to run
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      The workers counts are filled in
+ */
+void* runEnumerationWorker(void* argument) {
+    // the worker being run
+    EnumerationWorker* worker = argument;
+    // the shared enumeration state
+    Enumeration* enumeration = worker->enumeration;
+    // the task being worked on
+    SolverBoard board;
+    // the counter for the queues to steal from
+    int i = 0;
+
+    while (atomic_load(&enumeration->pending) > 0) {
+        // take from our own queue first, otherwise steal from the other workers
+        int found = takeTask(&enumeration->queues[worker->id], 0, &board);
+        for (i = 1; (i < enumeration->threadCount) && (!found); i++) {
+            found = takeTask(&enumeration->queues[(worker->id + i) % enumeration->threadCount], 1, &board);
+        }
+        if (!found) {
+            sched_yield();
+            continue;
+        }
+        enumerateFrom(worker, &board);
+        atomic_fetch_sub(&enumeration->pending, 1);
+    }
+
+    return NULL;
+}
+
+/*
+ * Purpose:
+ *      To count the unique positions reachable at every ply up to a target ply,
+ *      splitting the move tree across a pool of work stealing threads
+ * Parameters:
+ *      root - the position to enumerate from
+ *      targetPly - the last ply to count
+ *      megabytes - the size of the hash set used to remove transpositions
+ *      reserved - if not NULL, set to the megabytes the memory budget gave the hash set
+ *      threadCount - the number of worker threads
+ *      counts - set to the number of unique positions at each ply, NUM_CELLS + 1 entries
+ *      keys - if not NULL, set to an allocated array of the key of every position
+ *      found, which the caller must free
+ *      keyCount - if keys is not NULL, set to the number of keys
+ * Returns:
+ *      1 if the enumeration finished, 0 if memory could not be allocated or the
+ *      hash set was too small for the number of positions
+ * Side-Effects:
+ *      NONE
+ */
+int enumeratePositions(const SolverBoard* root, const int targetPly, const int megabytes, int* reserved, const int threadCount, long long* counts, uint64_t** keys, size_t* keyCount) {
+    // the shared enumeration state
+    Enumeration enumeration;
+    // the worker threads
+    EnumerationWorker* workers = calloc(threadCount, sizeof(EnumerationWorker));
+    // the number of slots in the hash set
+    size_t slots = 1;
+    // counters for the workers and plies
+    int i = 0;
+    int ply = 0;
+    // set if the enumeration finished
+    int finished = 0;
+
+    while (slots * 2 * sizeof(uint64_t) <= ((size_t)megabytes << 20)) {
+        slots *= 2;
+    }
+    // a smaller hash set may still hold every position, and overflows if not
+    slots = reserveMemory(MEMORY_ENUMERATION, slots * sizeof(uint64_t), MEMORY_MIN_TABLE) / sizeof(uint64_t);
+    if (reserved != NULL) {
+        *reserved = (int)((slots * sizeof(uint64_t)) >> 20);
+    }
+    enumeration.slots = (slots > 0) ? calloc(slots, sizeof(uint64_t)) : NULL;
+    enumeration.slotMask = slots - 1;
+    enumeration.queues = calloc(threadCount, sizeof(TaskQueue));
+    enumeration.threadCount = threadCount;
+    enumeration.targetPly = targetPly;
+    atomic_init(&enumeration.pending, 1);
+    atomic_init(&enumeration.overflow, 0);
+    if ((workers != NULL) && (enumeration.slots != NULL) && (enumeration.queues != NULL)) {
+        for (i = 0; i < threadCount; i++) {
+            pthread_mutex_init(&enumeration.queues[i].lock, NULL);
+        }
+        pushTask(&enumeration.queues[0], root);
+        for (i = 0; i < threadCount; i++) {
+            workers[i].enumeration = &enumeration;
+            workers[i].id = i;
+            pthread_create(&workers[i].thread, NULL, runEnumerationWorker, &workers[i]);
+        }
+        // merge the per worker counts once every worker has stopped
+        for (ply = 0; ply <= NUM_CELLS; ply++) {
+            counts[ply] = 0;
+        }
+        for (i = 0; i < threadCount; i++) {
+            pthread_join(workers[i].thread, NULL);
+            pthread_mutex_destroy(&enumeration.queues[i].lock);
+            for (ply = 0; ply <= NUM_CELLS; ply++) {
+                counts[ply] += workers[i].counts[ply];
+            }
+        }
+        finished = !atomic_load(&enumeration.overflow);
+    }
+    // the hash set already holds every key so it is packed down and handed back
+    if ((keys != NULL) && (finished)) {
+        uint64_t* packed = (uint64_t*)enumeration.slots;
+        size_t count = 0;
+        size_t slot = 0;
+        for (slot = 0; slot < slots; slot++) {
+            if (packed[slot] != 0) {
+                packed[count++] = packed[slot];
+            }
+        }
+        *keys = realloc(packed, ((count > 0) ? count : 1) * sizeof(uint64_t));
+        *keyCount = count;
+        enumeration.slots = NULL;
+    }
+    free(workers);
+    free((void*)enumeration.slots);
+    free(enumeration.queues);
+    // the keys handed back are counted by the caller that keeps them
+    releaseMemory(MEMORY_ENUMERATION, slots * sizeof(uint64_t));
+
+    return finished;
+}
+
+/*
+ * Purpose:
+ *      To get the number of processor cores that can run threads
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      The number of online cores, at least 1
+ * Side-Effects:
+ *      NONE
+ */
+int countCores() {
+    // the number of cores reported by the system
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (cores > 0) ? (int)cores : 1;
+}
+
+/*
+ * Purpose:
+ *      To write the solved positions of a book held in memory to a compressed book file
+ * Parameters:
+ *      book - the book held in memory, with its keys sorted
+ *      fileName - the name of the file to write
+ * Returns:
+ *      The number of bytes written, or 0 if the file could not be written
+ * Side-Effects:
+ *      The file is written
+ */
+long long writeBookFile(const OpeningBook* book, const char* fileName) {
+    // the book file
+    FILE* file = fopen(fileName, "wb");
+    // the number of blocks
+    size_t blockCount = (book->count + BOOK_BLOCK_ENTRIES - 1) / BOOK_BLOCK_ENTRIES;
+    // the size of the header and index, where the first block starts
+    uint64_t dataStart = 4 + 4 * 4 + 8 + blockCount * 16 + 8;
+    // the offset of the block being written
+    uint64_t offset = dataStart;
+    // counters for the blocks and entries
+    size_t block = 0;
+    size_t i = 0;
+
+    if (file == NULL) {
+        return 0;
+    }
+    fwrite("C4BK", 1, 4, file);
+    writeUint32(file, 1);
+    writeUint32(file, book->minPly);
+    writeUint32(file, book->maxPly);
+    writeUint32(file, BOOK_BLOCK_ENTRIES);
+    writeUint64(file, book->count);
+    // the index is written first, so the size of each block is worked out
+    // before any block is written
+    for (block = 0; block < blockCount; block++) {
+        size_t first = block * BOOK_BLOCK_ENTRIES;
+        size_t last = (first + BOOK_BLOCK_ENTRIES < book->count) ? first + BOOK_BLOCK_ENTRIES : book->count;
+        writeUint64(file, book->keys[first]);
+        writeUint64(file, offset);
+        offset += last - first;
+        for (i = first + 1; i < last; i++) {
+            uint64_t gap = book->keys[i] - book->keys[i - 1];
+            do {
+                offset++;
+                gap >>= 7;
+            } while (gap != 0);
+        }
+    }
+    writeUint64(file, offset);
+    for (block = 0; block < blockCount; block++) {
+        size_t first = block * BOOK_BLOCK_ENTRIES;
+        size_t last = (first + BOOK_BLOCK_ENTRIES < book->count) ? first + BOOK_BLOCK_ENTRIES : book->count;
+        for (i = first; i < last; i++) {
+            fputc((unsigned char)book->scores[i], file);
+        }
+        for (i = first + 1; i < last; i++) {
+            uint64_t gap = book->keys[i] - book->keys[i - 1];
+            while (gap >= 0x80) {
+                fputc((int)((gap & 0x7F) | 0x80), file);
+                gap >>= 7;
+            }
+            fputc((int)gap, file);
+        }
+    }
+    fclose(file);
+
+    return (long long)offset;
+}
+
+/*
+ * Purpose:
+ *      To free an opening book
+ * Parameters:
+ *      book - the book to free, may be NULL
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The book is freed and its file is closed
+ */
+void freeBook(OpeningBook* book) {
+    if (book != NULL) {
+        if (book->file >= 0) {
+            close(book->file);
+        }
+        free(book->keys);
+        free(book->scores);
+        releaseMemory(MEMORY_BOOK, book->memoryBytes);
+        free(book->blockKeys);
+        free(book->blockOffsets);
+        free(book);
+    }
+}
+
+/*
+ * Purpose:
+ *      To open a compressed book file and load its block index
+ * Parameters:
+ *      fileName - the name of the book file
+ * Returns:
+ *      The opened book, or NULL if the file is missing or not a valid book
+ * Side-Effects:
+ *      The book is allocated and the file is kept open for lookups
+ */
+OpeningBook* loadBook(const char* fileName) {
+    // the book file, read through stdio for the header and index
+    FILE* file = fopen(fileName, "rb");
+    // the book being loaded
+    OpeningBook* book = calloc(1, sizeof(OpeningBook));
+    // the magic bytes, version and block size from the header
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t minPly = 0;
+    uint32_t maxPly = 0;
+    uint32_t blockEntries = 0;
+    uint64_t count = 0;
+    // set while the file is valid
+    int valid = 0;
+    // the counter for the blocks
+    size_t block = 0;
+
+    if (book != NULL) {
+        book->file = -1;
+    }
+    if ((file != NULL) && (book != NULL)) {
+        valid = (fread(magic, 1, 4, file) == 4) && (memcmp(magic, "C4BK", 4) == 0) && (readUint32(file, &version)) && (version == 1) && (readUint32(file, &minPly)) && (readUint32(file, &maxPly)) && (readUint32(file, &blockEntries)) && (blockEntries == BOOK_BLOCK_ENTRIES) && (readUint64(file, &count));
+    }
+    if (valid) {
+        book->minPly = minPly;
+        book->maxPly = maxPly;
+        book->count = count;
+        book->blockCount = (count + BOOK_BLOCK_ENTRIES - 1) / BOOK_BLOCK_ENTRIES;
+        book->blockKeys = malloc((book->blockCount + 1) * sizeof(uint64_t));
+        book->blockOffsets = malloc((book->blockCount + 1) * sizeof(uint64_t));
+        valid = (book->blockKeys != NULL) && (book->blockOffsets != NULL);
+        for (block = 0; (block < book->blockCount) && (valid); block++) {
+            valid = (readUint64(file, &book->blockKeys[block])) && (readUint64(file, &book->blockOffsets[block]));
+        }
+        valid = valid && (readUint64(file, &book->blockOffsets[book->blockCount]));
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    if (valid) {
+        book->file = open(fileName, O_RDONLY);
+        valid = book->file >= 0;
+    }
+    if (!valid) {
+        freeBook(book);
+        book = NULL;
+    }
+
+    return book;
+}
+
+/*
+ * The state shared by the threads solving one ply of a book being built
+ */
+typedef struct {
+    // the book being built, held in memory
+    OpeningBook* book;
+    // the number of moves played in each book position
+    unsigned char* plies;
+    // the ply being solved
+    int ply;
+    // the index of the next position to look at
+    atomic_llong next;
+    // the number of solver nodes used
+    atomic_llong nodes;
+    // the transposition table size of each thread
+    int megabytes;
+    // the number of threads that have finished the ply
+    atomic_int finishedThreads;
+    // the number of threads that could not allocate a transposition table
+    atomic_int tableFailures;
+} BookBuilder;
+
+/*
+ * Purpose:
+ *      To solve the book positions of the current ply until none are left
+ * Parameters:
+ *      argument - the BookBuilder shared by the threads
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      The scores of the book are filled in
+ */
+void* runBookWorker(void* argument) {
+    // the shared builder state
+    BookBuilder* builder = argument;
+    // the book being built
+    OpeningBook* book = builder->book;
+    // this threads solver
+    Solver solver;
+    // the index of the position being solved and its score
+    long long index = 0;
+    int score = 0;
+
+    if (!initSolver(&solver, builder->megabytes)) {
+        atomic_fetch_add(&builder->tableFailures, 1);
+        atomic_fetch_add(&builder->finishedThreads, 1);
+        return NULL;
+    }
+    // deeper plies are already solved, so the solver can look them up
+    solver.book = book;
+    while ((index = atomic_fetch_add(&builder->next, 1)) < (long long)book->count) {
+        SolverBoard board;
+        // positions solved before a checkpoint was resumed are skipped
+        if ((builder->plies[index] != builder->ply) || (book->scores[index] != BOOK_UNSOLVED)) {
+            continue;
+        }
+        decodeSolverKey(book->keys[index], &board);
+        // the score of a solve stopped to save a checkpoint is not kept
+        score = solveBoard(&solver, &board);
+        if (solver.aborted) {
+            break;
+        }
+        book->scores[index] = (signed char)score;
+    }
+    atomic_fetch_add(&builder->nodes, solver.nodes);
+    freeSolver(&solver);
+    atomic_fetch_add(&builder->finishedThreads, 1);
+
+    return NULL;
+}
+
+/*
+ * Purpose:
+ *      To compare two keys for sorting
+ * Parameters:
+ *      a, b - pointers to the keys
+ * Returns:
+ *      A negative number, 0 or a positive number as a is before, equal to or after b
+ * Side-Effects:
+ *      NONE
+ */
+int compareKeys(const void* a, const void* b) {
+    // the keys being compared
+    uint64_t first = *(const uint64_t*)a;
+    uint64_t second = *(const uint64_t*)b;
+
+    return (first > second) - (first < second);
+}
+
+/*
+ * Purpose:
+ *      To collect every position of a book from the positions reachable from a
+ *      starting position. Positions where the game is already won are left out
+ *      and mirror images are stored once.
+ * Parameters:
+ *      root - the starting position
+ *      book - the book held in memory, with its ply range set
+ *      threadCount - the number of threads for the enumeration
+ *      megabytes - the size of the enumeration hash set
+ * Returns:
+ *      1 if the positions were collected, otherwise 0
+ * Side-Effects:
+ *      The keys and scores of the book are allocated, the scores are set to unsolved
+ */
+int collectBookPositions(const SolverBoard* root, OpeningBook* book, const int threadCount, const int megabytes) {
+    // the number of positions found at each ply, not used here
+    long long counts[NUM_CELLS + 1];
+    // every key found by the enumeration
+    uint64_t* keys = NULL;
+    size_t keyCount = 0;
+    // counters for the keys read and kept
+    size_t i = 0;
+    size_t kept = 0;
+
+    if (!enumeratePositions(root, book->maxPly, megabytes, NULL, threadCount, counts, &keys, &keyCount)) {
+        return 0;
+    }
+    for (i = 0; i < keyCount; i++) {
+        SolverBoard board;
+        decodeSolverKey(keys[i], &board);
+        if ((board.moveCount >= book->minPly) && (!hasFourInARow(board.current ^ board.mask))) {
+            keys[kept++] = canonicalKey(&board);
+        }
+    }
+    qsort(keys, kept, sizeof(uint64_t), compareKeys);
+    // remove the second copy of positions whose mirror image was also reached
+    keyCount = kept;
+    kept = 0;
+    for (i = 0; i < keyCount; i++) {
+        if ((kept == 0) || (keys[kept - 1] != keys[i])) {
+            keys[kept++] = keys[i];
+        }
+    }
+    book->keys = keys;
+    book->count = kept;
+    book->memoryBytes = reserveMemory(MEMORY_BOOK, keyCount * sizeof(uint64_t) + kept, keyCount * sizeof(uint64_t) + kept);
+    if ((book->memoryBytes == 0) && (keyCount > 0)) {
+        return 0;
+    }
+    book->scores = malloc((kept > 0) ? kept : 1);
+    if (book->scores == NULL) {
+        return 0;
+    }
+    memset(book->scores, BOOK_UNSOLVED, kept);
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To save the positions of a book being built and every score solved so
+ *      far. The scores are written first, one byte each, then the sorted keys
+ *      as the gaps between them.
+ * Parameters:
+ *      book - the book held in memory
+ *      rootKey - the key of the position the book was built from
+ * Returns:
+ *      1 if the checkpoint was saved, otherwise 0
+ * Side-Effects:
+ *      The checkpoint file is replaced
+ */
+int writeBookCheckpoint(const OpeningBook* book, const uint64_t rootKey) {
+    // the checkpoint file
+    FILE* file = openCheckpoint(CHECKPOINT_BOOK);
+    // the counter for the positions
+    size_t i = 0;
+
+    if (file == NULL) {
+        fprintf(stderr, "Could not save the checkpoint '%s'\n", checkpointName);
+        return 0;
+    }
+    writeUint32(file, book->minPly);
+    writeUint32(file, book->maxPly);
+    writeUint64(file, rootKey);
+    writeUint64(file, book->count);
+    // a score the solver threads write while this runs is either saved or
+    // solved again after a restart
+    fwrite(book->scores, 1, book->count, file);
+    for (i = 0; i < book->count; i++) {
+        writeVarint(file, book->keys[i] - ((i > 0) ? book->keys[i - 1] : 0));
+    }
+
+    return closeCheckpoint(file);
+}
+
+/*
+ * Purpose:
+ *      To load the positions and scores of a book being built from its checkpoint
+ * Parameters:
+ *      book - the book held in memory, with its ply range set
+ *      rootKey - the key of the position the book is built from
+ * Returns:
+ *      1 if the build was resumed, 0 if there is no checkpoint, -1 if the
+ *      checkpoint is for another book or is damaged
+ * Side-Effects:
+ *      The keys and scores of the book are allocated and loaded
+ */
+int readBookCheckpoint(OpeningBook* book, const uint64_t rootKey) {
+    // the checkpoint file
+    FILE* file = NULL;
+    // the ply range, root key and position count from the checkpoint
+    uint32_t minPly = 0;
+    uint32_t maxPly = 0;
+    uint64_t fileRootKey = 0;
+    uint64_t count = 0;
+    // the gap from the last key
+    uint64_t gap = 0;
+    // set while the file is valid
+    int valid = openResume(CHECKPOINT_BOOK, &file);
+    // the counter for the positions
+    size_t i = 0;
+
+    if (valid <= 0) {
+        return valid;
+    }
+    valid = (readUint32(file, &minPly)) && (minPly == (uint32_t)book->minPly) && (readUint32(file, &maxPly)) && (maxPly == (uint32_t)book->maxPly) && (readUint64(file, &fileRootKey)) && (fileRootKey == rootKey) && (readUint64(file, &count));
+    if (valid) {
+        book->count = count;
+        book->memoryBytes = reserveMemory(MEMORY_BOOK, count * (sizeof(uint64_t) + 1), count * (sizeof(uint64_t) + 1));
+        book->keys = malloc((count > 0) ? count * sizeof(uint64_t) : 1);
+        book->scores = malloc((count > 0) ? count : 1);
+        valid = ((book->memoryBytes > 0) || (count == 0)) && (book->keys != NULL) && (book->scores != NULL) && (fread(book->scores, 1, count, file) == count);
+    }
+    for (i = 0; (i < count) && (valid); i++) {
+        valid = readVarint(file, &gap);
+        book->keys[i] = ((i > 0) ? book->keys[i - 1] : 0) + gap;
+    }
+    fclose(file);
+    if (!valid) {
+        free(book->keys);
+        free(book->scores);
+        book->keys = NULL;
+        book->scores = NULL;
+        book->count = 0;
+        return -1;
+    }
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To build an opening book by solving every position in its ply range,
+ *      deepest ply first so the shallower solves can look the deeper ones up.
+ *      If a checkpoint file was given the scores are saved to it every
+ *      checkpointInterval seconds, after each ply, and when a signal asks for it.
+ * Parameters:
+ *      book - the book held in memory with its positions collected
+ *      rootKey - the key of the position the book is built from
+ *      threadCount - the number of solver threads
+ *      megabytes - the transposition table size of each thread
+ * Returns:
+ *      The number of solver nodes used, BOOK_BUILD_STOPPED if the build was
+ *      stopped by a signal, or BOOK_BUILD_FAILED if a position of the ply range
+ *      was left unsolved
+ * Side-Effects:
+ *      The scores of the book are filled in
+ */
+long long solveBookPositions(OpeningBook* book, const uint64_t rootKey, const int threadCount, const int megabytes) {
+    // the shared builder state
+    BookBuilder builder;
+    // the solver threads
+    pthread_t* threads = calloc(threadCount, sizeof(pthread_t));
+    // the time the next checkpoint is due
+    double nextCheckpoint = monotonicSeconds() + checkpointInterval;
+    // the number of positions left unsolved
+    size_t unsolved = 0;
+    // counters for the positions and threads
+    size_t i = 0;
+    int t = 0;
+
+    builder.book = book;
+    builder.plies = malloc((book->count > 0) ? book->count : 1);
+    builder.megabytes = megabytes;
+    atomic_init(&builder.nodes, 0);
+    atomic_init(&builder.tableFailures, 0);
+    for (i = 0; i < book->count; i++) {
+        SolverBoard board;
+        decodeSolverKey(book->keys[i], &board);
+        builder.plies[i] = (unsigned char)board.moveCount;
+    }
+    for (builder.ply = book->maxPly; builder.ply >= book->minPly; builder.ply--) {
+        double start = monotonicSeconds();
+        atomic_store(&builder.next, 0);
+        atomic_store(&builder.finishedThreads, 0);
+        for (t = 0; t < threadCount; t++) {
+            pthread_create(&threads[t], NULL, runBookWorker, &builder);
+        }
+        // save the scores while the threads solve, and stop them if a signal
+        // asks for a checkpoint
+        while ((checkpointName != NULL) && (atomic_load(&builder.finishedThreads) < threadCount)) {
+            usleep(100000);
+            if (checkpointRequested) {
+                atomic_store(&searchStop, 1);
+            } else if (monotonicSeconds() >= nextCheckpoint) {
+                writeBookCheckpoint(book, rootKey);
+                nextCheckpoint = monotonicSeconds() + checkpointInterval;
+            }
+        }
+        for (t = 0; t < threadCount; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        if (checkpointName != NULL) {
+            writeBookCheckpoint(book, rootKey);
+        }
+        if (checkpointRequested) {
+            break;
+        }
+        // a thread without a table leaves the build short of the threads asked
+        // for, or with nothing solved at all under a tight memory budget
+        if (atomic_load(&builder.tableFailures) > 0) {
+            fprintf(stderr, "%d solver threads could not allocate a %d MB transposition table\n", atomic_load(&builder.tableFailures), megabytes);
+            unsolved = 1;
+            break;
+        }
+        // the shallower plies look this one up, so they can not be solved
+        // from a ply with holes in it
+        for (i = 0; i < book->count; i++) {
+            unsolved += (builder.plies[i] == builder.ply) && (book->scores[i] == BOOK_UNSOLVED);
+        }
+        if (unsolved > 0) {
+            fprintf(stderr, "%zu positions of ply %d were not solved\n", unsolved, builder.ply);
+            break;
+        }
+        fprintf(stderr, "solved ply %d in %.1f s\n", builder.ply, monotonicSeconds() - start);
+    }
+    free(builder.plies);
+    free(threads);
+    atomic_store(&searchStop, 0);
+
+    if (checkpointRequested) {
+        return BOOK_BUILD_STOPPED;
+    }
+
+    return (unsolved > 0) ? BOOK_BUILD_FAILED : atomic_load(&builder.nodes);
+}
+
+/*
+ * The state of a xoshiro256** random number generator. Every thread keeps its
+ * own so random numbers never need a lock and a run can be repeated from its seed.
+ */
+typedef struct {
+    // the four words of generator state, never all 0
+    uint64_t state[4];
+} RandomState;
+
+/*
+ * Purpose:
+ *      To seed a random number generator, spreading the seed over the state with splitmix64
+ * Parameters:
+ *      random - the generator to seed
+ *      seed - any 64 bit seed
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The generator state is overwritten
+ */
+void seedRandom(RandomState* random, uint64_t seed) {
+    // the counter for the state words
+    int i = 0;
+
+    for (i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        random->state[i] = z ^ (z >> 31);
+    }
+}
+
+/*
+ * Purpose:
+ *      To get the next 64 random bits from a generator
+ * Parameters:
+ *      random - the generator
+ * Returns:
+ *      64 random bits
+ * Side-Effects:
+ *      The generator state is advanced
+ */
+uint64_t nextRandom(RandomState* random) {
+    // the state words, named as in the xoshiro256** reference code
+    uint64_t* s = random->state;
+    uint64_t result = s[1] * 5;
+    uint64_t t = s[1] << 17;
+
+    result = ((result << 7) | (result >> 57)) * 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+
+    return result;
+}
+
+/*
+ * Purpose:
+ *      To get an unbiased random number below a limit. The top 32 bits are
+ *      scaled into the range by a multiply, and the few values that would make
+ *      some results more likely are drawn again, so a division is only needed
+ *      in the rare case of a value near the edge.
+ * Parameters:
+ *      random - the generator
+ *      limit - the number of possible results, greater than 0
+ * Returns:
+ *      A random number from 0 to limit - 1
+ * Side-Effects:
+ *      The generator state is advanced
+ */
+uint32_t randomBelow(RandomState* random, const uint32_t limit) {
+    // the random bits scaled by the limit, the result is the high half
+    uint64_t scaled = (nextRandom(random) >> 32) * limit;
+    // the number of low halves that must be drawn again
+    uint32_t threshold = 0;
+
+    if ((uint32_t)scaled < limit) {
+        threshold = -limit % limit;
+        while ((uint32_t)scaled < threshold) {
+            scaled = (nextRandom(random) >> 32) * limit;
+        }
+    }
+
+    return (uint32_t)(scaled >> 32);
+}
+
+/*
+ * Purpose:
+ *      To pick one cell of a bitboard at random, every cell equally likely
+ * Parameters:
+ *      random - the generator
+ *      cells - the cells to pick from, at least one must be set
+ * Returns:
+ *      A bitboard of the cell picked
+ * Side-Effects:
+ *      The generator state is advanced
+ */
+uint64_t randomCell(RandomState* random, uint64_t cells) {
+    // the number of lower cells to skip
+    uint32_t skip = randomBelow(random, __builtin_popcountll(cells));
+
+    while (skip-- > 0) {
+        cells &= cells - 1;
+    }
+
+    return cells & (~cells + 1);
+}
+
+/*
+ * Purpose:
+ *      To pick a column that is not full at random, every column equally likely
+ * Parameters:
+ *      random - the generator
+ *      occupied - the bitboard of every piece on the board, which must not be full
+ * Returns:
+ *      The column index (0 - 6)
+ * Side-Effects:
+ *      The generator state is advanced
+ */
+int randomColumn(RandomState* random, const uint64_t occupied) {
+    return bitboardColumn(randomCell(random, playableCells(occupied)));
+}
+
+// the generator for the random moves of the interactive game, seeded by
+// --seed or the time. Every thread that makes random moves of its own keeps
+// its own generator.
+RandomState gameRandom;
+
+// the size in bytes of one training record: two bitboards, score, best move,
+// number of moves and flags
+#define TRAINING_RECORD_SIZE 20
+// the number of records each generator thread collects before writing them
+#define TRAINING_BATCH_SIZE 1024
+
+/*
+ * The state shared by the threads of a training data generator
+ */
+typedef struct {
+    // the file the records are written to
+    FILE* output;
+    // the lock held while writing to the output
+    pthread_mutex_t outputLock;
+    // the number of positions wanted
+    long long target;
+    // the number of positions claimed by threads so far
+    atomic_llong claimed;
+    // the number of positions written and the number given up at the node limit
+    atomic_llong written;
+    atomic_llong skipped;
+    // the number of solver nodes used over every thread
+    atomic_llong nodes;
+    // the number of labels that are a loss, a tie and a win for the player to move
+    atomic_llong results[3];
+    // the number of threads that have finished
+    atomic_int finishedThreads;
+    // set to play positions out with a shallow search instead of random moves
+    int selfPlay;
+    // the range of plies the positions are taken from
+    int minPly;
+    int maxPly;
+    // the transposition table size and node limit of each threads solver
+    int megabytes;
+    long long nodeLimit;
+    // the number of positions given up at the node limit after which the
+    // threads stop, so a node limit too small for the plies cannot run forever
+    long long skipLimit;
+    // the seed the thread generators are made from
+    uint64_t seed;
+} TrainingGenerator;
+
+/*
+ * One thread of a training data generator
+ */
+typedef struct {
+    // the shared generator state
+    TrainingGenerator* generator;
+    // the index of the thread
+    int id;
+    // the thread running the generator
+    pthread_t thread;
+} TrainingWorker;
+
+/*
+ * Purpose:
+ *      To write a training record as little endian bytes so the file is the same on every machine
+ * Parameters:
+ *      record - the TRAINING_RECORD_SIZE bytes to fill in
+ *      board - the labelled position
+ *      score - the exact score for the player to move
+ *      bestColumn - the column index of a best move
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The record bytes are overwritten
+ */
+void packTrainingRecord(unsigned char* record, const SolverBoard* board, const int score, const int bestColumn) {
+    // the counter for the bytes of the bitboards
+    int i = 0;
+
+    for (i = 0; i < 8; i++) {
+        record[i] = (unsigned char)(board->current >> (8 * i));
+        record[8 + i] = (unsigned char)(board->mask >> (8 * i));
+    }
+    record[16] = (unsigned char)(signed char)score;
+    record[17] = (unsigned char)bestColumn;
+    record[18] = (unsigned char)board->moveCount;
+    // reserved for later use
+    record[19] = 0;
+}
+
+/*
+ * Purpose:
+ *      To play a game out to a random ply to make a training position. Random
+ *      play picks uniformly from the legal columns, self play mostly uses a
+ *      shallow search with some random moves so the games do not repeat.
+ * Parameters:
+ *      generator - the generator settings
+ *      random - the threads random number generator
+ *      board - set to the position made
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The random number generator is advanced
+ */
+void makeTrainingPosition(const TrainingGenerator* generator, RandomState* random, SolverBoard* board) {
+    // the game being played out
+    Position position;
+    // the ply to stop at
+    int targetPly = generator->minPly + randomBelow(random, generator->maxPly - generator->minPly + 1);
+    // set if the game was won before the target ply
+    int winGame = 1;
+    // the number of positions searched by the self play search
+    long long nodes = 0;
+
+    // start again whenever a game ends before the target ply
+    while (winGame) {
+        initPosition(&position);
+        winGame = 0;
+        while ((position.moveCount < targetPly) && (!winGame)) {
+            int column = -1;
+            int score = 0;
+            if ((generator->selfPlay) && (randomBelow(random, 8) != 0)) {
+                column = searchBestMove(&position, 4, &score, &nodes);
+            }
+            if ((column < 0) || (!canPlay(&position, column))) {
+                column = randomColumn(random, position.occupied);
+            }
+            winGame = makeMove(&position, column);
+        }
+    }
+    loadSolverBoard(board, &position);
+}
+
+/*
+ * Purpose:
+ *      To run one training data thread until the wanted number of positions has been
+ *      claimed or too many positions have been given up at the node limit
+ * Parameters:
+ *      argument - the TrainingWorker to run
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      Records are written to the output file
+ */
+void* runTrainingWorker(void* argument) {
+    // the worker being run
+    TrainingWorker* worker = argument;
+    // the shared generator state
+    TrainingGenerator* generator = worker->generator;
+    // the threads random number generator
+    RandomState random;
+    // the threads solver
+    Solver solver;
+    // the records waiting to be written
+    unsigned char* batch = malloc(TRAINING_BATCH_SIZE * TRAINING_RECORD_SIZE);
+    // the number of records in the batch
+    int batchCount = 0;
+
+    // each thread gets its own stream from the seed
+    seedRandom(&random, generator->seed + 0x632BE59BD9B4E019ull * (uint64_t)(worker->id + 1));
+    if ((batch != NULL) && (initSolver(&solver, generator->megabytes))) {
+        while ((atomic_load(&generator->skipped) < generator->skipLimit) && (atomic_fetch_add(&generator->claimed, 1) < generator->target)) {
+            SolverBoard board;
+            int score = 0;
+            int variation[2];
+            makeTrainingPosition(generator, &random, &board);
+            solver.nodes = 0;
+            solver.aborted = 0;
+            solver.nodeLimit = generator->nodeLimit;
+            score = solveBoard(&solver, &board);
+            if (!solver.aborted) {
+                solvePrincipalVariation(&solver, &board, score, variation, 2);
+            }
+            atomic_fetch_add(&generator->nodes, solver.nodes);
+            if (solver.aborted) {
+                // the position is too hard for the node limit so it is left out
+                // rather than given a label that may be wrong
+                atomic_fetch_add(&generator->skipped, 1);
+                atomic_fetch_sub(&generator->claimed, 1);
+                continue;
+            }
+            atomic_fetch_add(&generator->results[(score > 0) - (score < 0) + 1], 1);
+            packTrainingRecord(batch + batchCount * TRAINING_RECORD_SIZE, &board, score, variation[0]);
+            batchCount++;
+            if (batchCount == TRAINING_BATCH_SIZE) {
+                pthread_mutex_lock(&generator->outputLock);
+                fwrite(batch, TRAINING_RECORD_SIZE, batchCount, generator->output);
+                pthread_mutex_unlock(&generator->outputLock);
+                atomic_fetch_add(&generator->written, batchCount);
+                batchCount = 0;
+            }
+        }
+        freeSolver(&solver);
+    }
+    if (batchCount > 0) {
+        pthread_mutex_lock(&generator->outputLock);
+        fwrite(batch, TRAINING_RECORD_SIZE, batchCount, generator->output);
+        pthread_mutex_unlock(&generator->outputLock);
+        atomic_fetch_add(&generator->written, batchCount);
+    }
+    free(batch);
+    atomic_fetch_add(&generator->finishedThreads, 1);
+
+    return NULL;
+}
+
+// the longest line read from a game log
+#define GAME_LOG_LINE 256
+// the most output one analysed game can produce
+#define ANALYSIS_REPORT_SIZE (NUM_CELLS * 96)
+
+/*
+ * The state shared by the threads analysing a game log. Each line of the log is
+ * one game given as its moves, e.g. 4453, and anything after the moves is ignored.
+ */
+typedef struct {
+    // the game log and the lock held while reading a game from it
+    FILE* input;
+    pthread_mutex_t inputLock;
+    // the number of the next game to be read, counting from 1
+    long long nextGame;
+    // the file the report is written to and the lock held while writing it
+    FILE* output;
+    pthread_mutex_t outputLock;
+    // the transposition table size and node limit of each threads solver
+    int megabytes;
+    long long nodeLimit;
+    // the number of games and moves analysed
+    atomic_llong games;
+    atomic_llong moves;
+    // the number of lines that are not a valid game
+    atomic_llong invalid;
+    // the number of moves that turned a won or tied position into a lost one,
+    // and the number that turned a won position into a tie
+    atomic_llong blunders;
+    atomic_llong missedWins;
+    // the number of moves that could not be judged within the node limit
+    atomic_llong unknown;
+    // the number of solver nodes used over every thread
+    atomic_llong nodes;
+    // the number of threads that have finished
+    atomic_int finishedThreads;
+} GameAnalysis;
+
+/*
+ * One thread of a game log analysis
+ */
+typedef struct {
+    // the shared analysis state
+    GameAnalysis* analysis;
+    // the thread running the analysis
+    pthread_t thread;
+} AnalysisWorker;
+
+/*
+ * Purpose:
+ *      To solve every position of a game and report the moves that threw away a
+ *      win or a tie. The positions are solved from the end of the game back to
+ *      the start so the earlier solves find the later ones in the transposition
+ *      table, and the score of each move played is the negated score of the
+ *      position after it so every position is only solved once. Earlier
+ *      positions are harder to solve, so once one reaches the node limit the
+ *      moves before it are not tried.
+ * Parameters:
+ *      analysis - the shared analysis state
+ *      solver - the threads solver
+ *      gameNumber - the line number of the game in the log
+ *      line - the line of the log holding the game
+ *      report - set to the lines reporting the mistakes found
+ * Returns:
+ *      The length of the report, or -1 if the line is not a valid game
+ * Side-Effects:
+ *      The counts of the analysis are updated
+ */
+int analyzeGame(GameAnalysis* analysis, Solver* solver, const long long gameNumber, const char* line, char* report) {
+    // the positions before each move
+    SolverBoard boards[NUM_CELLS + 1];
+    // the column index of each move
+    int columns[NUM_CELLS];
+    // the exact score of each position and whether it is known
+    int scores[NUM_CELLS + 1];
+    int known[NUM_CELLS + 1];
+    // the kind of mistake made by each move, NULL for none, and the best column instead
+    const char* mistakes[NUM_CELLS];
+    int bestColumns[NUM_CELLS];
+    // the number of moves in the game
+    int moveCount = 0;
+    // set if the last move won the game
+    int won = 0;
+    // the length of the report
+    int length = 0;
+    // the counter for the moves
+    int ply = 0;
+
+    // read and replay the moves
+    boards[0].current = 0;
+    boards[0].mask = 0;
+    boards[0].moveCount = 0;
+    while ((line[moveCount] >= '1') && (line[moveCount] <= '0' + BOARD_COLUMNS)) {
+        uint64_t move = 0;
+        if ((won) || (moveCount == NUM_CELLS)) {
+            return -1;
+        }
+        columns[moveCount] = line[moveCount] - '1';
+        move = playableCells(boards[moveCount].mask) & columnMask(columns[moveCount]);
+        if (move == 0) {
+            return -1;
+        }
+        won = (winningCells(boards[moveCount].current, boards[moveCount].mask) & move) != 0;
+        boards[moveCount + 1] = boards[moveCount];
+        playSolverMove(&boards[moveCount + 1], move);
+        moveCount++;
+    }
+    if ((line[moveCount] != '\0') && (line[moveCount] != '\n') && (line[moveCount] != '\r') && (line[moveCount] != ' ') && (line[moveCount] != '\t')) {
+        return -1;
+    }
+    // the final position is over, a tie if the board is full, or solved if the
+    // game stopped early, e.g. a truncated log or a player out of time
+    known[moveCount] = (!won) && (moveCount == NUM_CELLS);
+    scores[moveCount] = 0;
+    if ((!won) && (moveCount < NUM_CELLS)) {
+        solver->nodes = 0;
+        solver->aborted = 0;
+        solver->nodeLimit = analysis->nodeLimit;
+        scores[moveCount] = solveBoard(solver, &boards[moveCount]);
+        known[moveCount] = !solver->aborted;
+        atomic_fetch_add(&analysis->nodes, solver->nodes);
+    }
+    for (ply = moveCount - 1; ply >= 0; ply--) {
+        // set if the move played won the game
+        int winning = (won) && (ply == moveCount - 1);
+        mistakes[ply] = NULL;
+        if ((!winning) && (!known[ply + 1])) {
+            // the position after the move could not be solved so neither can this one
+            known[ply] = 0;
+            atomic_fetch_add(&analysis->unknown, 1);
+            continue;
+        }
+        solver->nodes = 0;
+        solver->aborted = 0;
+        solver->nodeLimit = analysis->nodeLimit;
+        scores[ply] = solveBoard(solver, &boards[ply]);
+        known[ply] = !solver->aborted;
+        atomic_fetch_add(&analysis->nodes, solver->nodes);
+        if (!known[ply]) {
+            atomic_fetch_add(&analysis->unknown, 1);
+        } else {
+            // the score of the move played and of the best move
+            int played = (winning) ? (NUM_CELLS + 1 - ply) / 2 : -scores[ply + 1];
+            int best = scores[ply];
+            if (((played < 0) && (best >= 0)) || ((played == 0) && (best > 0))) {
+                // the variation holding the best move
+                int variation[2];
+                solvePrincipalVariation(solver, &boards[ply], best, variation, 2);
+                mistakes[ply] = (played < 0) ? "blunder" : "missed-win";
+                bestColumns[ply] = variation[0];
+                atomic_fetch_add((played < 0) ? &analysis->blunders : &analysis->missedWins, 1);
+            }
+        }
+    }
+    // report the mistakes in the order they were played
+    for (ply = 0; ply < moveCount; ply++) {
+        if (mistakes[ply] != NULL) {
+            int played = ((won) && (ply == moveCount - 1)) ? (NUM_CELLS + 1 - ply) / 2 : -scores[ply + 1];
+            length += snprintf(report + length, ANALYSIS_REPORT_SIZE - length, "game %lld ply %d column %d %s played %d best %d bestcolumn %d\n", gameNumber, ply + 1, columns[ply] + 1, mistakes[ply], played, scores[ply], bestColumns[ply] + 1);
+        }
+    }
+    atomic_fetch_add(&analysis->games, 1);
+    atomic_fetch_add(&analysis->moves, moveCount);
+
+    return length;
+}
+
+/*
+ * Purpose:
+ *      To run one game log analysis thread until every game has been read
+ * Parameters:
+ *      argument - the AnalysisWorker to run
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      The report of each game is written to the output as soon as it is done
+ */
+void* runAnalysisWorker(void* argument) {
+    // the worker being run
+    AnalysisWorker* worker = argument;
+    // the shared analysis state
+    GameAnalysis* analysis = worker->analysis;
+    // the threads solver
+    Solver solver;
+    // the line read from the log and the report on it
+    char line[GAME_LOG_LINE];
+    char* report = malloc(ANALYSIS_REPORT_SIZE);
+
+    if ((report != NULL) && (initSolver(&solver, analysis->megabytes))) {
+        while (1) {
+            // the number of the game read
+            long long gameNumber = 0;
+            // the length of the report on the game
+            int length = 0;
+            pthread_mutex_lock(&analysis->inputLock);
+            if (fgets(line, sizeof(line), analysis->input) != NULL) {
+                gameNumber = analysis->nextGame++;
+                // skip the rest of a line too long to read at once
+                if (strchr(line, '\n') == NULL) {
+                    int c = 0;
+                    while (((c = fgetc(analysis->input)) != EOF) && (c != '\n')) {
+                    }
+                }
+            }
+            pthread_mutex_unlock(&analysis->inputLock);
+            if (gameNumber == 0) {
+                break;
+            }
+            // blank lines and comments are skipped
+            if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r') || (line[0] == '\0')) {
+                continue;
+            }
+            length = analyzeGame(analysis, &solver, gameNumber, line, report);
+            if (length < 0) {
+                atomic_fetch_add(&analysis->invalid, 1);
+                length = snprintf(report, ANALYSIS_REPORT_SIZE, "game %lld invalid\n", gameNumber);
+            }
+            if (length > 0) {
+                pthread_mutex_lock(&analysis->outputLock);
+                fwrite(report, 1, length, analysis->output);
+                pthread_mutex_unlock(&analysis->outputLock);
+            }
+        }
+        freeSolver(&solver);
+    }
+    free(report);
+    atomic_fetch_add(&analysis->finishedThreads, 1);
+
+    return NULL;
+}
+
+// the results a stored game can have
+#define RESULT_UNFINISHED 0
+#define RESULT_FIRST_WIN 1
+#define RESULT_SECOND_WIN 2
+#define RESULT_DRAW 3
+// the size of a stored game: a byte holding the number of moves and the
+// result, then 3 bits for each move
+#define DATABASE_GAME_SIZE (1 + (NUM_CELLS * 3 + 7) / 8)
+// the size of the header of the game file: the magic bytes, version and number of plies indexed
+#define DATABASE_HEADER_SIZE 12
+// the number of plies of each game indexed when a database is created
+#define DATABASE_INDEX_PLIES 16
+// the size of index data after which a new block is started
+#define DATABASE_BLOCK_BYTES 4096
+// the number of index segments kept before they are merged into one
+#define DATABASE_MAX_SEGMENTS 8
+// the size of an index segment header: the range of games it indexes, the
+// number of records and blocks, and the offset of its block index
+#define SEGMENT_HEADER_SIZE 40
+
+// the names of the results, in the order of the RESULT_ numbers
+const char* resultNames[4] = {"unfinished", "first", "second", "draw"};
+
+/*
+ * One segment of a game database index. Each segment indexes a range of games
+ * and holds a record for every position reached in their first plies, sorted
+ * by the position key. A record is the gap from the key before it, the number
+ * of games with each result, the size of its game list, and the game numbers
+ * as gaps. The records are split into blocks, and the first key, file offset
+ * and number of records of every block is kept in memory so a lookup reads
+ * one block.
+ */
+typedef struct {
+    // the range of games indexed, from firstGame up to but not including endGame
+    uint64_t firstGame;
+    uint64_t endGame;
+    // the number of records and blocks
+    uint64_t recordCount;
+    uint64_t blockCount;
+    // the first key, file offset and number of records of each block
+    uint64_t* blockKeys;
+    uint64_t* blockOffsets;
+    uint64_t* blockRecords;
+} DatabaseSegment;
+
+/*
+ * A database of games. The games are stored in a file of fixed size records
+ * so a game is found from its number, and the index is kept in a second file
+ * of segments. New games get a new segment of their own, and the segments are
+ * merged into one once there are too many.
+ */
+typedef struct {
+    // the names of the game and index files
+    char gamesName[PATH_MAX];
+    char indexName[PATH_MAX];
+    // the open game and index files
+    FILE* games;
+    FILE* index;
+    // the number of plies of each game that are indexed
+    int indexPlies;
+    // the number of games stored
+    uint64_t gameCount;
+    // the index segments, oldest first
+    int segmentCount;
+    DatabaseSegment segments[DATABASE_MAX_SEGMENTS + 1];
+    // the end of the last finished segment in the index file, anything after
+    // it is a segment that was being written when the program stopped
+    long long indexEnd;
+} GameDatabase;
+
+/*
+ * A position reached in a game, collected while indexing new games
+ */
+typedef struct {
+    // the canonical key of the position
+    uint64_t key;
+    // the number of the game
+    uint64_t game;
+    // the result of the game
+    int result;
+} DatabaseEntry;
+
+/*
+ * The state of an index segment being written. The records are written as
+ * they come and the block index is written after them.
+ */
+typedef struct {
+    // the index file
+    FILE* file;
+    // the file offset of the segment header
+    long long headerOffset;
+    // the number of bytes written to the data so far and to the current block
+    long long dataBytes;
+    long long blockBytes;
+    // the key of the last record written
+    uint64_t lastKey;
+    // the number of records written
+    uint64_t recordCount;
+    // the first key, file offset and number of records of each block, and the
+    // number of blocks there is room for
+    uint64_t* blockKeys;
+    uint64_t* blockOffsets;
+    uint64_t* blockRecords;
+    uint64_t blockCount;
+    uint64_t blockCapacity;
+} SegmentWriter;
+
+/*
+ * The state of a segment being read in key order while segments are merged
+ */
+typedef struct {
+    // this cursors own handle on the index file
+    FILE* file;
+    // the segment being read
+    const DatabaseSegment* segment;
+    // the next block and the records left in the current block and in the segment
+    uint64_t nextBlock;
+    uint64_t blockLeft;
+    uint64_t recordsLeft;
+    // the current record: its key, result counts, size of its game list and
+    // number of games not read yet
+    uint64_t key;
+    uint64_t counts[4];
+    uint64_t idBytes;
+    uint64_t idsLeft;
+    // the last game number read from the current record
+    uint64_t lastId;
+    // set while the cursor is on a record
+    int valid;
+} SegmentCursor;
+
+/*
+ * Purpose:
+ *      To get the number of bytes a variable length number takes
+ * Parameters:
+ *      value - the number
+ * Returns:
+ *      The number of bytes writeVarint writes for it
+ * Side-Effects:
+ *      NONE
+ */
+int varintLength(uint64_t value) {
+    // the number of bytes
+    int length = 1;
+
+    while (value >= 0x80) {
+        value >>= 7;
+        length++;
+    }
+
+    return length;
+}
+
+/*
+ * Purpose:
+ *      To pack a game given as a move string into a database record
+ * Parameters:
+ *      moves - the columns played, from 1-7. The string may end with a newline.
+ *      record - the DATABASE_GAME_SIZE bytes to fill
+ * Returns:
+ *      The result of the game, or -1 if a move is invalid
+ * Side-Effects:
+ *      record is overwritten
+ */
+int encodeGame(const char* moves, unsigned char* record) {
+    // the position the moves are played in
+    Position position;
+    // set once the game has been won
+    int winGame = 0;
+    // the result of the game
+    int result = RESULT_UNFINISHED;
+    // the counter for the moves
+    int i = 0;
+
+    initPosition(&position);
+    memset(record, 0, DATABASE_GAME_SIZE);
+    for (i = 0; (moves[i] != '\0') && (moves[i] != '\n') && (moves[i] != '\r'); i++) {
+        // the column index of the move
+        int column = moves[i] - '1';
+        if ((column < 0) || (column >= BOARD_COLUMNS) || (!canPlay(&position, column)) || (winGame)) {
+            return -1;
+        }
+        winGame = makeMove(&position, column);
+        // the 3 bits of the move may be split over two bytes
+        record[1 + i * 3 / 8] |= (unsigned char)(column << ((i * 3) % 8));
+        if ((i * 3) % 8 > 5) {
+            record[2 + i * 3 / 8] |= (unsigned char)(column >> (8 - (i * 3) % 8));
+        }
+    }
+    if (winGame) {
+        result = (i & 1) ? RESULT_FIRST_WIN : RESULT_SECOND_WIN;
+    } else if (i == NUM_CELLS) {
+        result = RESULT_DRAW;
+    }
+    record[0] = (unsigned char)(i | (result << 6));
+
+    return result;
+}
+
+/*
+ * Purpose:
+ *      To unpack a database record into a move string
+ * Parameters:
+ *      record - the DATABASE_GAME_SIZE bytes of the game
+ *      moves - set to the columns played, from 1-7, with room for NUM_CELLS + 1 characters
+ * Returns:
+ *      The result of the game
+ * Side-Effects:
+ *      moves is overwritten
+ */
+int decodeGame(const unsigned char* record, char* moves) {
+    // the number of moves
+    int count = record[0] & 0x3F;
+    // the counter for the moves
+    int i = 0;
+
+    for (i = 0; (i < count) && (i < NUM_CELLS); i++) {
+        // the two bytes the 3 bits of the move are in
+        int bits = record[1 + i * 3 / 8] | (((i * 3) % 8 > 5) ? record[2 + i * 3 / 8] << 8 : 0);
+        moves[i] = (char)('1' + ((bits >> ((i * 3) % 8)) & 7));
+    }
+    moves[i] = '\0';
+
+    return record[0] >> 6;
+}
+
+/*
+ * Purpose:
+ *      To free the block indexes of the segments of a database
+ * Parameters:
+ *      database - the database
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The segments are freed and the segment count is set to 0
+ */
+void freeSegments(GameDatabase* database) {
+    // the counter for the segments
+    int i = 0;
+
+    for (i = 0; i < database->segmentCount; i++) {
+        free(database->segments[i].blockKeys);
+        free(database->segments[i].blockOffsets);
+        free(database->segments[i].blockRecords);
+    }
+    database->segmentCount = 0;
+}
+
+/*
+ * Purpose:
+ *      To read the headers and block indexes of every segment of the index file.
+ *      A segment left without its block index by a crash while it was written
+ *      ends the index, and its games are indexed again by the next append.
+ * Parameters:
+ *      database - the database with its index file open
+ * Returns:
+ *      1 if the index was read, 0 if it is damaged
+ * Side-Effects:
+ *      The segments are loaded
+ */
+int loadSegments(GameDatabase* database) {
+    // the offset of the segment being read
+    long long offset = 8;
+    // the segment being read
+    DatabaseSegment segment;
+    // the offset of the block index of the segment
+    uint64_t indexOffset = 0;
+    // set while the file is valid
+    int valid = 1;
+    // the counter for the blocks
+    uint64_t block = 0;
+
+    freeSegments(database);
+    database->indexEnd = offset;
+    while (valid) {
+        memset(&segment, 0, sizeof(segment));
+        if ((fseeko(database->index, offset, SEEK_SET) != 0) || (!readUint64(database->index, &segment.firstGame)) || (!readUint64(database->index, &segment.endGame)) || (!readUint64(database->index, &segment.recordCount)) || (!readUint64(database->index, &segment.blockCount)) || (!readUint64(database->index, &indexOffset)) || (indexOffset == 0)) {
+            break;
+        }
+        // the segments are merged before there are more than this
+        if (database->segmentCount == DATABASE_MAX_SEGMENTS + 1) {
+            valid = 0;
+            break;
+        }
+        segment.blockKeys = malloc((segment.blockCount + 1) * sizeof(uint64_t));
+        segment.blockOffsets = malloc((segment.blockCount + 1) * sizeof(uint64_t));
+        segment.blockRecords = malloc((segment.blockCount + 1) * sizeof(uint64_t));
+        database->segments[database->segmentCount++] = segment;
+        valid = (segment.blockKeys != NULL) && (segment.blockOffsets != NULL) && (segment.blockRecords != NULL) && (fseeko(database->index, (off_t)indexOffset, SEEK_SET) == 0);
+        for (block = 0; (block < segment.blockCount) && (valid); block++) {
+            valid = (readUint64(database->index, &segment.blockKeys[block])) && (readUint64(database->index, &segment.blockOffsets[block])) && (readUint64(database->index, &segment.blockRecords[block]));
+        }
+        offset = (long long)indexOffset + (long long)segment.blockCount * 24;
+        if (valid) {
+            database->indexEnd = offset;
+        }
+    }
+
+    return valid;
+}
+
+/*
+ * Purpose:
+ *      To close a game database
+ * Parameters:
+ *      database - the database, may be NULL
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The files are closed and the database is freed
+ */
+void closeDatabase(GameDatabase* database) {
+    if (database != NULL) {
+        freeSegments(database);
+        if (database->games != NULL) {
+            fclose(database->games);
+        }
+        if (database->index != NULL) {
+            fclose(database->index);
+        }
+        free(database);
+    }
+}
+
+/*
+ * Purpose:
+ *      To open a game database, or to create it if it does not exist
+ * Parameters:
+ *      name - the name of the game file, the index file has .index added
+ *      create - set to create the database if it does not exist
+ * Returns:
+ *      The open database, or NULL if it is missing or damaged
+ * Side-Effects:
+ *      The database is allocated and its files may be created
+ */
+GameDatabase* openDatabase(const char* name, const int create) {
+    // the database
+    GameDatabase* database = calloc(1, sizeof(GameDatabase));
+    // the magic bytes, version and number of plies indexed from the headers
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t indexPlies = 0;
+    // the size of the game file
+    long long size = 0;
+    // set while the database is valid
+    int valid = (database != NULL);
+
+    if (valid) {
+        snprintf(database->gamesName, sizeof(database->gamesName), "%s", name);
+        snprintf(database->indexName, sizeof(database->indexName), "%s.index", name);
+        database->games = fopen(database->gamesName, "r+b");
+        database->index = fopen(database->indexName, "r+b");
+        // a new database is made of two files holding only their headers
+        if ((create) && (database->games == NULL) && (database->index == NULL)) {
+            database->games = fopen(database->gamesName, "w+b");
+            database->index = fopen(database->indexName, "w+b");
+            if ((database->games != NULL) && (database->index != NULL)) {
+                fwrite("C4GD", 1, 4, database->games);
+                writeUint32(database->games, 1);
+                writeUint32(database->games, DATABASE_INDEX_PLIES);
+                fwrite("C4GI", 1, 4, database->index);
+                writeUint32(database->index, 1);
+                fflush(database->games);
+                fflush(database->index);
+            }
+        }
+        valid = (database->games != NULL) && (database->index != NULL);
+    }
+    if (valid) {
+        rewind(database->games);
+        rewind(database->index);
+        valid = (fread(magic, 1, 4, database->games) == 4) && (memcmp(magic, "C4GD", 4) == 0) && (readUint32(database->games, &version)) && (version == 1) && (readUint32(database->games, &indexPlies)) && (indexPlies <= NUM_CELLS);
+        valid = (valid) && (fread(magic, 1, 4, database->index) == 4) && (memcmp(magic, "C4GI", 4) == 0) && (readUint32(database->index, &version)) && (version == 1);
+    }
+    if (valid) {
+        database->indexPlies = (int)indexPlies;
+        fseeko(database->games, 0, SEEK_END);
+        size = ftello(database->games);
+        // a game cut short by a crash while it was written is not counted
+        database->gameCount = (uint64_t)(size - DATABASE_HEADER_SIZE) / DATABASE_GAME_SIZE;
+        valid = loadSegments(database);
+    }
+    if (!valid) {
+        closeDatabase(database);
+        database = NULL;
+    }
+
+    return database;
+}
+
+/*
+ * Purpose:
+ *      To start writing a new index segment at the end of an index file
+ * Parameters:
+ *      writer - the segment writer to set up
+ *      file - the index file
+ *      firstGame - the first game the segment indexes
+ *      endGame - the game after the last game the segment indexes
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The segment header is written with no block index, which marks the
+ *      segment as unfinished until finishSegment rewrites it
+ */
+void startSegment(SegmentWriter* writer, FILE* file, const uint64_t firstGame, const uint64_t endGame) {
+    memset(writer, 0, sizeof(SegmentWriter));
+    writer->file = file;
+    fseeko(file, 0, SEEK_END);
+    writer->headerOffset = ftello(file);
+    writeUint64(file, firstGame);
+    writeUint64(file, endGame);
+    writeUint64(file, 0);
+    writeUint64(file, 0);
+    writeUint64(file, 0);
+    writer->blockBytes = DATABASE_BLOCK_BYTES;
+}
+
+/*
+ * Purpose:
+ *      To write the start of a record to an index segment. The game numbers of
+ *      the record are written after it as gaps with writeVarint.
+ * Parameters:
+ *      writer - the segment writer
+ *      key - the key of the position, larger than the last key written
+ *      counts - the number of games with each result
+ *      idBytes - the size of the game list that follows
+ * Returns:
+ *      1 if the record was started, 0 if there was not enough memory
+ * Side-Effects:
+ *      The record is written and a new block may be started
+ */
+int addRecord(SegmentWriter* writer, const uint64_t key, const uint64_t counts[4], const uint64_t idBytes) {
+    // the number of bytes in the record header
+    long long headerBytes = 0;
+    // the counter for the results
+    int i = 0;
+
+    // a block is started once the last one is full, and its first key is
+    // written in full so the block can be read on its own
+    if (writer->blockBytes >= DATABASE_BLOCK_BYTES) {
+        if (writer->blockCount == writer->blockCapacity) {
+            writer->blockCapacity = (writer->blockCapacity > 0) ? writer->blockCapacity * 2 : 64;
+            writer->blockKeys = realloc(writer->blockKeys, writer->blockCapacity * sizeof(uint64_t));
+            writer->blockOffsets = realloc(writer->blockOffsets, writer->blockCapacity * sizeof(uint64_t));
+            writer->blockRecords = realloc(writer->blockRecords, writer->blockCapacity * sizeof(uint64_t));
+            if ((writer->blockKeys == NULL) || (writer->blockOffsets == NULL) || (writer->blockRecords == NULL)) {
+                return 0;
+            }
+        }
+        writer->blockKeys[writer->blockCount] = key;
+        writer->blockOffsets[writer->blockCount] = writer->headerOffset + SEGMENT_HEADER_SIZE + writer->dataBytes;
+        writer->blockRecords[writer->blockCount] = 0;
+        writer->blockCount++;
+        writer->blockBytes = 0;
+        writer->lastKey = 0;
+    }
+    writeVarint(writer->file, key - writer->lastKey);
+    headerBytes = varintLength(key - writer->lastKey);
+    for (i = 0; i < 4; i++) {
+        writeVarint(writer->file, counts[i]);
+        headerBytes += varintLength(counts[i]);
+    }
+    writeVarint(writer->file, idBytes);
+    headerBytes += varintLength(idBytes);
+    writer->dataBytes += headerBytes + (long long)idBytes;
+    writer->blockBytes += headerBytes + (long long)idBytes;
+    writer->blockRecords[writer->blockCount - 1]++;
+    writer->recordCount++;
+    writer->lastKey = key;
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To finish an index segment by writing its block index and filling in its header
+ * Parameters:
+ *      writer - the segment writer
+ * Returns:
+ *      1 if the segment was written, otherwise 0
+ * Side-Effects:
+ *      The block index and header are written, the file is flushed and the
+ *      writer is freed
+ */
+int finishSegment(SegmentWriter* writer) {
+    // the offset of the block index
+    uint64_t indexOffset = writer->headerOffset + SEGMENT_HEADER_SIZE + writer->dataBytes;
+    // set if everything was written
+    int written = 0;
+    // the counter for the blocks
+    uint64_t block = 0;
+
+    for (block = 0; block < writer->blockCount; block++) {
+        writeUint64(writer->file, writer->blockKeys[block]);
+        writeUint64(writer->file, writer->blockOffsets[block]);
+        writeUint64(writer->file, writer->blockRecords[block]);
+    }
+    // the block index must be on disk before the header points at it
+    written = (fflush(writer->file) == 0) && (fsync(fileno(writer->file)) == 0);
+    fseeko(writer->file, writer->headerOffset + 16, SEEK_SET);
+    writeUint64(writer->file, writer->recordCount);
+    writeUint64(writer->file, writer->blockCount);
+    writeUint64(writer->file, indexOffset);
+    written = (written) && (fflush(writer->file) == 0) && (!ferror(writer->file));
+    free(writer->blockKeys);
+    free(writer->blockOffsets);
+    free(writer->blockRecords);
+
+    return written;
+}
+
+/*
+ * Purpose:
+ *      To compare two database entries for sorting by key and then by game
+ * Parameters:
+ *      a, b - pointers to the entries
+ * Returns:
+ *      A negative number, 0 or a positive number as a is before, equal to or after b
+ * Side-Effects:
+ *      NONE
+ */
+int compareEntries(const void* a, const void* b) {
+    // the entries being compared
+    const DatabaseEntry* first = a;
+    const DatabaseEntry* second = b;
+
+    if (first->key != second->key) {
+        return (first->key > second->key) - (first->key < second->key);
+    }
+
+    return (first->game > second->game) - (first->game < second->game);
+}
+
+/*
+ * Purpose:
+ *      To index every game stored after the last indexed game in a new segment
+ * Parameters:
+ *      database - the database
+ * Returns:
+ *      1 if the games were indexed, otherwise 0
+ * Side-Effects:
+ *      A segment is added to the index file and the segments are reloaded
+ */
+int indexNewGames(GameDatabase* database) {
+    // the first game not indexed yet
+    uint64_t firstGame = (database->segmentCount > 0) ? database->segments[database->segmentCount - 1].endGame : 0;
+    // the positions reached in the new games and the bytes they take from the budget
+    DatabaseEntry* entries = NULL;
+    size_t entryCount = 0;
+    size_t entryBytes = 0;
+    // the segment being written
+    SegmentWriter writer;
+    // the record of the game being indexed
+    unsigned char record[DATABASE_GAME_SIZE];
+    char moves[NUM_CELLS + 1];
+    // set while everything has worked
+    int valid = 1;
+    // counters for the games, entries and moves
+    uint64_t game = 0;
+    size_t i = 0;
+    size_t j = 0;
+    int ply = 0;
+
+    if (firstGame >= database->gameCount) {
+        return 1;
+    }
+    entryBytes = reserveMemory(MEMORY_DATABASE, (database->gameCount - firstGame) * (database->indexPlies + 1) * sizeof(DatabaseEntry), (database->gameCount - firstGame) * (database->indexPlies + 1) * sizeof(DatabaseEntry));
+    entries = (entryBytes > 0) ? malloc(entryBytes) : NULL;
+    if (entries == NULL) {
+        releaseMemory(MEMORY_DATABASE, entryBytes);
+        return 0;
+    }
+    fseeko(database->games, DATABASE_HEADER_SIZE + (off_t)firstGame * DATABASE_GAME_SIZE, SEEK_SET);
+    for (game = firstGame; (game < database->gameCount) && (valid); game++) {
+        // the position after each move of the game
+        Position position;
+        SolverBoard board;
+        // the result of the game
+        int result = 0;
+        valid = fread(record, 1, DATABASE_GAME_SIZE, database->games) == DATABASE_GAME_SIZE;
+        result = decodeGame(record, moves);
+        initPosition(&position);
+        for (ply = 0; (valid) && (ply <= database->indexPlies); ply++) {
+            loadSolverBoard(&board, &position);
+            entries[entryCount].key = canonicalKey(&board);
+            entries[entryCount].game = game;
+            entries[entryCount++].result = result;
+            if (moves[ply] == '\0') {
+                break;
+            }
+            makeMove(&position, moves[ply] - '1');
+        }
+    }
+    qsort(entries, entryCount, sizeof(DatabaseEntry), compareEntries);
+    // an unfinished segment left by a crash would hide every segment written
+    // after it, so it is cut off and its games are indexed again here
+    fflush(database->index);
+    if (ftruncate(fileno(database->index), (off_t)database->indexEnd) != 0) {
+        free(entries);
+        releaseMemory(MEMORY_DATABASE, entryBytes);
+        return 0;
+    }
+    startSegment(&writer, database->index, firstGame, database->gameCount);
+    for (i = 0; (i < entryCount) && (valid); i = j) {
+        // the number of games with each result and the size of the game list
+        uint64_t counts[4] = {0, 0, 0, 0};
+        uint64_t idBytes = 0;
+        // the last game number written
+        uint64_t lastId = 0;
+        for (j = i; (j < entryCount) && (entries[j].key == entries[i].key); j++) {
+            counts[entries[j].result]++;
+            idBytes += varintLength(entries[j].game - ((j > i) ? entries[j - 1].game : 0));
+        }
+        valid = addRecord(&writer, entries[i].key, counts, idBytes);
+        for (j = i; (valid) && (j < entryCount) && (entries[j].key == entries[i].key); j++) {
+            writeVarint(database->index, entries[j].game - lastId);
+            lastId = entries[j].game;
+        }
+    }
+    valid = (finishSegment(&writer)) && (valid);
+    free(entries);
+    releaseMemory(MEMORY_DATABASE, entryBytes);
+
+    return (valid) && (loadSegments(database));
+}
+
+/*
+ * Purpose:
+ *      To move a segment cursor to the next record
+ * Parameters:
+ *      cursor - the cursor, with the game list of its current record fully read
+ * Returns:
+ *      1 if the cursor is on a record, 0 at the end of the segment
+ * Side-Effects:
+ *      The record header is read
+ */
+int nextCursorRecord(SegmentCursor* cursor) {
+    // the key gap from the last record
+    uint64_t gap = 0;
+    // the counter for the results
+    int i = 0;
+
+    cursor->valid = 0;
+    if (cursor->recordsLeft == 0) {
+        return 0;
+    }
+    // the first key of a block is written in full
+    if (cursor->blockLeft == 0) {
+        fseeko(cursor->file, (off_t)cursor->segment->blockOffsets[cursor->nextBlock], SEEK_SET);
+        cursor->blockLeft = cursor->segment->blockRecords[cursor->nextBlock++];
+        cursor->key = 0;
+    }
+    if (!readVarint(cursor->file, &gap)) {
+        return 0;
+    }
+    cursor->key += gap;
+    cursor->idsLeft = 0;
+    for (i = 0; i < 4; i++) {
+        if (!readVarint(cursor->file, &cursor->counts[i])) {
+            return 0;
+        }
+        cursor->idsLeft += cursor->counts[i];
+    }
+    if (!readVarint(cursor->file, &cursor->idBytes)) {
+        return 0;
+    }
+    cursor->lastId = 0;
+    cursor->blockLeft--;
+    cursor->recordsLeft--;
+    cursor->valid = 1;
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To merge every segment of a database into one. The segments are read
+ *      side by side in key order, so the index never has to fit in memory.
+ *      The merged index is written to a new file that replaces the old one.
+ * Parameters:
+ *      database - the database
+ * Returns:
+ *      1 if the segments were merged, otherwise 0
+ * Side-Effects:
+ *      The index file is replaced and the segments are reloaded
+ */
+int compactDatabase(GameDatabase* database) {
+    // the name of the new index file
+    char temporaryName[PATH_MAX + 4];
+    // the new index file
+    FILE* file = NULL;
+    // the cursors on the old segments
+    SegmentCursor cursors[DATABASE_MAX_SEGMENTS + 1];
+    // the merged segment
+    SegmentWriter writer;
+    // set while everything has worked
+    int valid = 1;
+    // the counter for the segments
+    int i = 0;
+
+    if (database->segmentCount <= 1) {
+        return 1;
+    }
+    snprintf(temporaryName, sizeof(temporaryName), "%s.tmp", database->indexName);
+    file = fopen(temporaryName, "w+b");
+    if (file == NULL) {
+        return 0;
+    }
+    fwrite("C4GI", 1, 4, file);
+    writeUint32(file, 1);
+    for (i = 0; i < database->segmentCount; i++) {
+        memset(&cursors[i], 0, sizeof(SegmentCursor));
+        cursors[i].file = fopen(database->indexName, "rb");
+        cursors[i].segment = &database->segments[i];
+        cursors[i].recordsLeft = database->segments[i].recordCount;
+        valid = (valid) && (cursors[i].file != NULL);
+        if (cursors[i].file != NULL) {
+            nextCursorRecord(&cursors[i]);
+        }
+    }
+    startSegment(&writer, file, database->segments[0].firstGame, database->segments[database->segmentCount - 1].endGame);
+    while (valid) {
+        // the smallest key of the cursors and the merged record
+        uint64_t key = UINT64_MAX;
+        uint64_t counts[4] = {0, 0, 0, 0};
+        uint64_t idBytes = 0;
+        // the file offset of the game list of each cursor on the key
+        off_t listStarts[DATABASE_MAX_SEGMENTS + 1];
+        // the first game of a list, the gap to the next and the last game of the list before
+        uint64_t first = 0;
+        uint64_t gap = 0;
+        uint64_t lastId = 0;
+        // the counters for the results and games
+        int r = 0;
+        uint64_t g = 0;
+        for (i = 0; i < database->segmentCount; i++) {
+            if ((cursors[i].valid) && (cursors[i].key < key)) {
+                key = cursors[i].key;
+            }
+        }
+        if (key == UINT64_MAX) {
+            break;
+        }
+        // the segments hold games in order, so the merged list is their lists
+        // one after another and only the gap to the first game of each list
+        // changes. The lists are read once to find the size of the merged list
+        // so it can be written in the record header.
+        for (i = 0; (i < database->segmentCount) && (valid); i++) {
+            if ((cursors[i].valid) && (cursors[i].key == key)) {
+                listStarts[i] = ftello(cursors[i].file);
+                valid = readVarint(cursors[i].file, &first);
+                idBytes += cursors[i].idBytes - varintLength(first) + varintLength(first - lastId);
+                lastId = first;
+                for (g = 1; (g < cursors[i].idsLeft) && (valid); g++) {
+                    valid = readVarint(cursors[i].file, &gap);
+                    lastId += gap;
+                }
+                for (r = 0; r < 4; r++) {
+                    counts[r] += cursors[i].counts[r];
+                }
+                fseeko(cursors[i].file, listStarts[i], SEEK_SET);
+            }
+        }
+        valid = (valid) && (addRecord(&writer, key, counts, idBytes));
+        lastId = 0;
+        for (i = 0; (i < database->segmentCount) && (valid); i++) {
+            if ((cursors[i].valid) && (cursors[i].key == key)) {
+                valid = readVarint(cursors[i].file, &first);
+                writeVarint(file, first - lastId);
+                lastId = first;
+                for (g = 1; (g < cursors[i].idsLeft) && (valid); g++) {
+                    valid = readVarint(cursors[i].file, &gap);
+                    writeVarint(file, gap);
+                    lastId += gap;
+                }
+                nextCursorRecord(&cursors[i]);
+            }
+        }
+    }
+    valid = (finishSegment(&writer)) && (valid);
+    for (i = 0; i < database->segmentCount; i++) {
+        if (cursors[i].file != NULL) {
+            fclose(cursors[i].file);
+        }
+    }
+    valid = (fclose(file) == 0) && (valid);
+    if ((!valid) || (rename(temporaryName, database->indexName) != 0)) {
+        remove(temporaryName);
+        return 0;
+    }
+    fclose(database->index);
+    database->index = fopen(database->indexName, "r+b");
+
+    return (database->index != NULL) && (loadSegments(database));
+}
+
+/*
+ * Purpose:
+ *      To find the games that reached a position, or its mirror image
+ * Parameters:
+ *      database - the database
+ *      key - the canonical key of the position
+ *      counts - set to the number of games with each result
+ *      games - filled with the numbers of the first games found, oldest first
+ *      maxGames - the number of games there is room for
+ *      gameCount - set to the number of games filled in
+ * Returns:
+ *      1 if the index was read, 0 if it is damaged
+ * Side-Effects:
+ *      NONE
+ */
+int queryDatabase(GameDatabase* database, const uint64_t key, uint64_t counts[4], uint64_t* games, const size_t maxGames, size_t* gameCount) {
+    // the cursor used to read the block of each segment
+    SegmentCursor cursor;
+    // counters for the segments and results
+    int i = 0;
+    int r = 0;
+
+    memset(counts, 0, 4 * sizeof(uint64_t));
+    *gameCount = 0;
+    for (i = 0; i < database->segmentCount; i++) {
+        // the segment being searched
+        const DatabaseSegment* segment = &database->segments[i];
+        // the ends of the binary search for the last block starting at or before the key
+        uint64_t low = 0;
+        uint64_t high = segment->blockCount;
+        if ((segment->blockCount == 0) || (segment->blockKeys[0] > key)) {
+            continue;
+        }
+        while (high - low > 1) {
+            uint64_t middle = low + (high - low) / 2;
+            if (segment->blockKeys[middle] <= key) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        memset(&cursor, 0, sizeof(cursor));
+        cursor.file = database->index;
+        cursor.segment = segment;
+        cursor.nextBlock = low;
+        cursor.recordsLeft = segment->blockRecords[low];
+        // the records before the key are skipped without reading their games
+        while ((nextCursorRecord(&cursor)) && (cursor.key < key)) {
+            if (fseeko(cursor.file, (off_t)cursor.idBytes, SEEK_CUR) != 0) {
+                return 0;
+            }
+        }
+        if ((!cursor.valid) || (cursor.key != key)) {
+            continue;
+        }
+        for (r = 0; r < 4; r++) {
+            counts[r] += cursor.counts[r];
+        }
+        while ((cursor.idsLeft > 0) && (*gameCount < maxGames)) {
+            // the gap to the next game
+            uint64_t gap = 0;
+            if (!readVarint(cursor.file, &gap)) {
+                return 0;
+            }
+            cursor.lastId += gap;
+            cursor.idsLeft--;
+            games[(*gameCount)++] = cursor.lastId;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To read a stored game
+ * Parameters:
+ *      database - the database
+ *      game - the number of the game
+ *      moves - set to the columns played, with room for NUM_CELLS + 1 characters
+ * Returns:
+ *      The result of the game, or -1 if it could not be read
+ * Side-Effects:
+ *      NONE
+ */
+int readDatabaseGame(GameDatabase* database, const uint64_t game, char* moves) {
+    // the record of the game
+    unsigned char record[DATABASE_GAME_SIZE];
+
+    if ((game >= database->gameCount) || (fseeko(database->games, DATABASE_HEADER_SIZE + (off_t)game * DATABASE_GAME_SIZE, SEEK_SET) != 0) || (fread(record, 1, DATABASE_GAME_SIZE, database->games) != DATABASE_GAME_SIZE)) {
+        return -1;
+    }
+
+    return decodeGame(record, moves);
+}
+
+// the seconds on each players clock at the start of a game, 0 for games without clocks
+double clockBase = 0;
+// the seconds added to a players clock after each of their moves
+double clockIncrement = 0;
+// the file every finished interactive game is appended to, NULL to keep no log
+const char* gameLogName = NULL;
+
+// the ways the board can be shown after each move: as a grid, as the moves
+// played so far, as one FEN like line, or not at all
+#define BOARD_STYLE_GRID 0
+#define BOARD_STYLE_MOVES 1
+#define BOARD_STYLE_FEN 2
+#define BOARD_STYLE_NONE 3
+// the size of the buffer a board is drawn into, the grid is the largest at
+// 30 characters for each row and for the three border and label lines
+#define BOARD_BUFFER_SIZE ((BOARD_ROWS + 3) * 30 + 1)
+
+// the way the board is shown after each move
+int boardStyle = BOARD_STYLE_GRID;
+// set to show nothing but the prompts, for headless games
+int quietMode = 0;
+
+// the stages of the computers decision chain that are profiled
+#define STAGE_FIRST_TWO_MOVES 0
+#define STAGE_IMMEDIATE_THREAT 1
+#define STAGE_TIMED_SEARCH 2
+#define STAGE_THREE_TRAP 3
+#define STAGE_TWO_IN_A_ROW 4
+#define STAGE_BLOCK_THREE_TRAP 5
+#define STAGE_BLOCK_TWO_IN_A_ROW 6
+#define STAGE_CONNECT_TWO 7
+#define STAGE_RANDOM_MOVE 8
+#define NUM_STAGES 9
+// the number of latency histogram buckets, bucket b counts calls that took
+// from 2^b up to 2^(b+1) nanoseconds
+#define PROFILE_BUCKETS 32
+
+// the names of the profiled stages, in the order of the STAGE_ numbers
+const char* stageNames[NUM_STAGES] = {"firstTwoMoves", "immediateThreat", "timedSearch", "threeTrap", "twoInARow", "blockThreeTrap", "blockTwoInARow", "connectTwo", "randomMove"};
+
+/*
+ * The timing counters of one stage of the computers decision chain, kept over
+ * every game played
+ */
+typedef struct {
+    // the number of times the stage ran and the number of times it chose the move
+    long long calls;
+    long long fired;
+    // the total and longest time the stage took in nanoseconds
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+    // the number of calls in each latency bucket
+    long long histogram[PROFILE_BUCKETS];
+} StageProfile;
+
+// set to time the stages of the computers decision chain
+int profilingEnabled = 0;
+// the counters of each stage
+StageProfile stageProfiles[NUM_STAGES];
+// set by SIGUSR1 to print the counters after the computers next move
+volatile sig_atomic_t profileDumpRequested = 0;
+
+/*
+ * Purpose:
+ *      To read the monotonic clock in nanoseconds for the stage profiler
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      The time in nanoseconds from an arbitrary starting point
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t profileClock() {
+    // the time read from the clock
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/*
+ * Purpose:
+ *      To note the time a profiled stage starts
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      The time in nanoseconds, or 0 if profiling is off
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t startStage() {
+    return (profilingEnabled) ? profileClock() : 0;
+}
+
+/*
+ * Purpose:
+ *      To add the time a profiled stage took to its counters. It is called with
+ *      the stage's result so the call can wrap the stage, e.g.
+ *      playColumn = endStage(STAGE_CONNECT_TWO, start, connectTwo(...));
+ * Parameters:
+ *      stage - the STAGE_ number of the stage
+ *      start - the time the stage started, from startStage
+ *      playColumn - the column the stage played in, 8 if it did not play
+ * Returns:
+ *      playColumn
+ * Side-Effects:
+ *      The counters of the stage are updated if profiling is on
+ */
+int endStage(const int stage, const uint64_t start, const int playColumn) {
+    // the time the stage took
+    uint64_t elapsed = 0;
+    // the counters of the stage
+    StageProfile* profile = &stageProfiles[stage];
+    // the histogram bucket of the time taken
+    int bucket = 0;
+
+    if (!profilingEnabled) {
+        return playColumn;
+    }
+    elapsed = profileClock() - start;
+    bucket = 63 - __builtin_clzll(elapsed | 1);
+    profile->calls++;
+    profile->fired += (playColumn != 8);
+    profile->totalNanoseconds += elapsed;
+    if (elapsed > profile->maxNanoseconds) {
+        profile->maxNanoseconds = elapsed;
+    }
+    profile->histogram[(bucket < PROFILE_BUCKETS) ? bucket : PROFILE_BUCKETS - 1]++;
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      To print the counters and latency histogram of every stage that has run
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The profile is printed to stderr
+ */
+void printStageProfile() {
+    // counters for the stages and histogram buckets
+    int stage = 0;
+    int bucket = 0;
+
+    fprintf(stderr, "%-16s %10s %10s %7s %12s %12s %12s\n", "stage", "calls", "fired", "fired%", "mean ns", "max ns", "total ms");
+    for (stage = 0; stage < NUM_STAGES; stage++) {
+        StageProfile* profile = &stageProfiles[stage];
+        if (profile->calls == 0) {
+            continue;
+        }
+        fprintf(stderr, "%-16s %10lld %10lld %6.1f%% %12.0f %12llu %12.3f\n", stageNames[stage], profile->calls, profile->fired, 100.0 * profile->fired / profile->calls, (double)profile->totalNanoseconds / profile->calls, (unsigned long long)profile->maxNanoseconds, profile->totalNanoseconds / 1e6);
+        fprintf(stderr, "    latency:");
+        for (bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+            if (profile->histogram[bucket] > 0) {
+                fprintf(stderr, " <%lluns:%lld", 2ull << bucket, profile->histogram[bucket]);
+            }
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+/*
+ * Purpose:
+ *      To ask for the stage profile to be printed, as the SIGUSR1 handler. Printing
+ *      is not safe inside a signal handler so it is left to the game.
+ * Parameters:
+ *      signalNumber - the signal received
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      profileDumpRequested is set
+ */
+void requestProfileDump(int signalNumber) {
+    (void)signalNumber;
+    profileDumpRequested = 1;
+}
+
+/*
+ * Purpose:
+ *      To set up a search position from the game board array
+ * Parameters:
+ *      position - the position to set up
+ *      gameBoard - the game board array
+ *      firstChar - the character of the player that moved first
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The position is overwritten
+ */
+void loadPositionFromBoard(Position* position, const char gameBoard[numColumns][numRows], const char firstChar) {
+    // the number of pieces on the board
+    int pieceCount = 0;
+    // counters for the columns and rows
+    int column = 0;
+    int row = 0;
+
+    initPosition(position);
+    for (column = 0; column < numColumns; column++) {
+        for (row = 0; (row < numRows) && (gameBoard[column][row] != 'O'); row++) {
+            // the order the pieces were played in is not known, but the line counts
+            // do not depend on it, so the move count is only used to pick the
+            // player the piece belongs to and is set properly at the end
+            position->moveCount = (gameBoard[column][row] == firstChar) ? 0 : 1;
+            makeMove(position, column);
+            pieceCount++;
+        }
+    }
+    position->moveCount = pieceCount;
+}
+
+/*
+ * Purpose:
+ *    To set every value of the game board array to O's to represent spaces on the board.
+ * Parameters:
+ *     gameBoard - the 2D array that stores every value in the game board
+ * Returns:
+ *      NONE
+ * Side-Effects: The game board array is modified to set every index to a default value
+ */
+void setGameBoard(char gameBoard[numColumns][numRows]) {
+    // counter for the index of the rows
+    int i = 0;
+    // counter for the index of the columns
+    int j = 0;
+    
+    // loop through the rows starting at row 0
+    while (i < numRows) {
+        // loop through each column and set the default value to 'O'
+        for (j = 0; j < numColumns; j++) {
+            gameBoard[j][i] = 'O';
+        }
+        // increment the row counter by 1 to go up a row and continue setting
+        // default values to each index.
+        i++;
+    // end of loop setting default values
+    }
+}
+
+/*
+ * Purpose:
+ *    To print the game instructions
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      NONE
+ * Side-Effects: 
+ *      NONE
+ */
+void printInstructions() {
+    // print the game rules and instructions
+    printf("Welcome to Connect Four!\n");
+    printf("The rules are simple. Drop your pieces into columns trying to get 4\n");
+    printf("in a row either vertically, horizontally, or diagonally, but be careful,\n");
+    printf("your goal is to connect four before your opponent does so your defense\n");
+    printf("must also be considered. Each player will alternate dropping pieces and\n");
+    printf("the game board will be printed after every move until the game ends.\n");
+    printf("The game ends when one player gets four in a row or the board\n");
+    printf("is full in which the game ends in a tie. Don't forget to have fun!\n");
+    if (clockBase > 0) {
+        printf("Each player has %.0f seconds plus %.1f seconds per move. A player whose\n", clockBase, clockIncrement);
+        printf("clock runs out loses the game.\n");
+    }
+    printf("\n");
+}
+
+/*
+ * Purpose:
+ *      To validate the users inputted game mode
+ * Parameters:
+ *      gameMode - the variable that stores the users input on what gameMode they want to
+ *      play as a character
+ * Returns:
+ *      gameMode - the validated gameMode character
+ * Side-Effects: 
+ *      NONE
+ */
+char validateGamemode(char gameMode) {
+    // loop asking for the user to enter a new game mode until their input is a valid game mode
+    // u - for user, c - for computer, q - for quit
+    while ((gameMode != 'u') && (gameMode != 'c') && (gameMode != 'q')) {
+        printf("Your choice of '%c' is invalid.\n", gameMode);
+        printf("Would you like to play against another user or the computer?\n");
+        printf("Please enter u for user, c for computer, or q to quit: ");
+        scanf("%c", &gameMode);
+        fgetc(stdin);
+    }
+
+    return gameMode;
+}
+
+/*
+ * Purpose:
+ *      To get the user to enter the game mode they would like to play
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      gameMode - the game mode the user wants to play
+ * Side-Effects:
+ */
+char selectGamemode() {
+    // variable to store the default value for the gameMode
+    char gameMode = 'x';
+    
+    // ask the user to enter the gamemode they would like to play
+    printf("Would you like to play against another user or the computer?\n");
+    printf("Please enter u for user, c for computer or q to quit: ");
+    scanf("%c", &gameMode);
+    fgetc(stdin);
+    // validate the gamemode
+    gameMode = validateGamemode(gameMode);
+
+    return gameMode;
+}
+
+/*
+ * Purpose:
+ *      To validate the character the user wants to use to represent their pieces
+ * Parameters:
+ *      playerChar - the character to represent the player on the game board
+ * Returns:
+ *      playerChar - the validated character to represent the player on the game board
+ * Side-Effects:
+ *      NONE
+ */     
+char validateChar(char playerChar, int player, const char gameMode, const char* playerPronoun) {
+   
+    // while the user enters a character that is not uppercase from A - Z, 
+    // and is not the default value of 'O', prompt the user to re enter the character
+    while ((playerChar < 'A') || (playerChar > 'Z') || (playerChar == 'O')) {
+        printf("Your input of '%c' is invalid.\n", playerChar);
+        printf("\n");
+        printf("Player %d: Please enter an uppercase character you\n", player);
+        printf("would like to use to represent %s pieces [A-Z]: ", playerPronoun);
+        scanf( "%c", &playerChar);
+        fgetc(stdin);
+    }
+    
+    return playerChar;
+}
+
+/*
+ * Purpose:
+ *      To get the user to input a character the user would like to represent their pieces
+ * Parameters:
+ *      player - the number value given to each player
+ *      gameMode - the gameMode the user is playing to determine the pronoun to address the player as
+ * Returns:
+ *      userChar - the character the user will use to represent their pieces on the board
+ * Side-Effects:
+ *      NONE
+ */
+char getPlayerChar(int player, const char gameMode) {
+    // set default value for the players character
+    char playerChar = 'c';
+    // default player pronoun for a real user
+    char* playerPronoun = "your";
+    
+    // if the user is playing against the computer (which is player 2), set the 
+    // player pronoun to "the computers" to output an appropriate prompt.
+    if ((gameMode == 'c') && (player == 2)) {
+        playerPronoun = "the computer's";
+        player = 1;
+    }
+    // ask player to enter
+    printf("Player %d: Please enter an uppercase character you\n", player);
+    printf("would like to use to represent %s pieces [A-Z]: ", playerPronoun);
+    scanf( "%c", &playerChar);
+    fgetc(stdin);
+    // validate the users character
+    playerChar = validateChar(playerChar, player, gameMode, playerPronoun);
+    
+    // return the validated userChar
+    return playerChar;
+}
+
+/*
+ * Purpose:
+ *      To validate the column the user plays their piece in is from 1-7 (inclusive)
+ *      because those are the possible columns in the game board
+ * Parameters:
+ *      columnSlot - the column the user would like to put their piece in
+ *      gameBoard - the 2D array of the game board to validate that the
+ *      row the user is putting their piece in is not full
+ * Returns:
+ *      columnSlot - the validated column the user places their pieces in
+ * Side-Effects:
+ *      NONE - gameboard is const so it is not modified
+ */
+int validateUserPlacement(int columnSlot, const char gameBoard[][numRows]) {
+    // while the users input is not in between 1-7 (the valid columns) prompt 
+    // the user to reenter the column they would like to place their pieces.
+    while ((columnSlot > 7) || (columnSlot < 1)) {
+        printf("Your entry of column %d is inavlid.\n", columnSlot);
+        printf("Please enter a new column you would like to drop your piece in [1-7]: ");
+        scanf("%d", &columnSlot);
+        fgetc(stdin);
+    }
+    // while they have entered a column that is full (the value is not the default
+    // at that index), ask them to choose a new column
+    while (gameBoard[columnSlot - 1][5] != 'O') {
+        printf("Column %d is full.\n", columnSlot);
+        printf("Please enter a new column you would like to drop your piece in [1-7]: ");
+        scanf("%d", &columnSlot);
+        fgetc(stdin);
+    }
+
+    return columnSlot;
+}
+
+/*
+ * Purpose:
+ *      To place the users piece in the column they have selected at the "lowest" available row
+ * Parameters:
+ *      gameBoard - the 2D array to be modified when the users piece is placed
+ *      userChar - the character the user chose to represent their pieces to 
+ *      be "dropped" into the gameboard
+ *      columnSlot - the column the user wants to play their piece in
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The gameboard is modified with the users piece placement
+ */
+void placepiece( char gameBoard[numColumns][numRows], const char userChar, const int columnSlot) {
+    // variable to store the row the users piece will be placed into
+    int rowSlot = 0;
+    
+    // starting from the bottom row (index 0), while the value is not the default
+    // and the upper bound has not been reached, the loop will increment up row by row,
+    // until it finds an index pair (column and row) in the gameboard that is the default
+    // value of 'O'. The column slot is subtracted by 1 because the user is presented
+    // with choices from 1-7 while the computers indexes for the columns are 0-6
+    while ((rowSlot < numRows) && (gameBoard[columnSlot - 1][rowSlot] != 'O')) {
+        rowSlot++;
+    }
+    // set the value at the users column slot and the lowest empty row slot to
+    // the character the user chose to represent their pieces.
+    gameBoard[columnSlot - 1][rowSlot] = userChar;
+}
+
+/*
+ * Purpose:
+ *      To check if a player has won the game
+ * Parameters:
+ *      gameBoard - the gameboard array to be checked to see if either player has 4 in a row
+ *      userChar - the character of the user to check if that user has 4 in a row
+ * Returns:
+ *      winGame - the variable storing if a player has won or not
+ * Side-Effects:
+ *      NONE - the gameboard array is not modified because it is a const
+ */         
+int checkWinGame(const char gameBoard[numColumns][numRows], const char userChar) {
+    // the variable to store if a player has won or not
+    int winGame = 0;
+    // the gameboard viewed as one array so the cell indexes in the line table can be used
+    const char* cells = &gameBoard[0][0];
+    // the counter for the winning line being checked
+    int line = 0;
+    // the counter for the piece in the line being checked
+    int k = 0;
+
+    // check every winning line on the board. The line table only holds lines that
+    // fit on the board so no bounds need to be checked here
+    for (line = 0; (line < NUM_LINES) && (!winGame); line++) {
+        // count how many pieces in a row from the start of the line belong to the player
+        for (k = 0; (k < CONNECT_LENGTH) && (cells[lineCells[line][k]] == userChar); k++) {
+        }
+        // every piece in the line belongs to the player so they have won
+        if (k == CONNECT_LENGTH) {
+            winGame = 1;
+        }
+    }
+
+    return winGame;
+}
+
+/*
+ * Purpose:
+ *      To check if the piece in one cell is part of four in a row. This is
+ *      used after a single piece is placed as only the lines through that
+ *      cell can have changed.
+ * Parameters:
+ *      gameBoard - the gameboard array to be checked
+ *      userChar - the character of the player to check
+ *      column - the column index (0 - 6) of the cell
+ *      row - the row index (0 - 5) of the cell
+ * Returns:
+ *      winGame - 1 if a line through the cell is filled with the players pieces, otherwise 0
+ * Side-Effects:
+ *      NONE - the gameboard array is not modified because it is a const
+ */
+int checkWinThroughCell(const char gameBoard[numColumns][numRows], const char userChar, const int column, const int row) {
+    // the variable to store if a player has won or not
+    int winGame = 0;
+    // the gameboard viewed as one array so the cell indexes in the line table can be used
+    const char* cells = &gameBoard[0][0];
+    // the flattened index of the cell to check
+    int cell = column * numRows + row;
+    // the counter for the lines through the cell
+    int i = 0;
+    // the counter for the piece in the line being checked
+    int k = 0;
+
+    for (i = 0; (i < cellLineCount[cell]) && (!winGame); i++) {
+        // the winning line being checked
+        const unsigned char* line = lineCells[cellLines[cell][i]];
+        for (k = 0; (k < CONNECT_LENGTH) && (cells[line[k]] == userChar); k++) {
+        }
+        if (k == CONNECT_LENGTH) {
+            winGame = 1;
+        }
+    }
+
+    return winGame;
+}
+
+/*
+ * Purpose:
+ *      For the player to pick a column to play their piece in. The piece is
+ *      placed by the game loop once the move is given to it.
+ * Parameters:
+ *      gameBoard - the game board array
+ *      player - the number of the player being asked
+ * Returns:
+ *      columnSlot - the column number (1 - 7) the player chose, which is not full
+ * Side-Effects:
+ *      NONE
+ */
+int askPlayerColumn(const char gameBoard[numColumns][numRows], const int player) {
+    int columnSlot = 0;
+    // ask user what column they would like to play their piece into
+    printf("\nPlayer %d: Which column would you like to drop your piece into? [1-7]: ", player);
+    scanf("%d", &columnSlot);
+    fgetc(stdin);
+    // validate the users column is within the game board and is not full
+    columnSlot = validateUserPlacement(columnSlot, gameBoard);
+
+    return columnSlot;
+}
+
+/*
+ * Purpose:
+ *      To play a piece that wins the game for the computer straight away, or if
+ *      there is none, a piece that stops the opponent winning on their next move.
+ *      The winning cells of both players are found with bitboards so the whole
+ *      check is a few shifts and ANDs.
+ * Parameters:
+ *      gameBoard - the game board array
+ *      computerChar - the character representing the computers pieces
+ *      opponentChar - the character representing the pieces of the computers opponent
+ * Returns:
+ *      playColumn - the column index the computer played in, or 8 if there was no
+ *      move to win or block
+ * Side-Effects:
+ *      The gameBoard array is modified wherever the computer plays its piece to win the game
+ *      or to prevent the user from winning.
+ */
+int playImmediateThreat(char gameBoard[numColumns][numRows], const char computerChar, const char opponentChar) {
+    // the bitboard of every piece on the board
+    uint64_t occupied = boardToBitboard(gameBoard, 0);
+    // the cells a piece can be dropped into
+    uint64_t playable = playableCells(occupied);
+    // the playable cells that win for the computer and for the opponent
+    uint64_t computerWins = winningCells(boardToBitboard(gameBoard, computerChar), occupied) & playable;
+    uint64_t opponentWins = winningCells(boardToBitboard(gameBoard, opponentChar), occupied) & playable;
+    // a default value for the play column that is not a valid column so the computer
+    // turn function will move on to the next function to find a move
+    int playColumn = 8;
+
+    // winning is always better than blocking
+    if (computerWins) {
+        playColumn = bitboardColumn(computerWins);
+    } else if (opponentWins) {
+        playColumn = bitboardColumn(opponentWins);
+    }
+    if (playColumn != 8) {
+        // place piece takes the column numbered from 1 - 7
+        placepiece(gameBoard, computerChar, playColumn + 1);
+    }
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      To check if the computers move will give the player a winning move and undo
+ *      it if it does
+ * Parameters:
+ *      gameBoard - the array to be modified to check if the player will win if the
+ *      computers plays a move and to be modified to undo it to prevent the computer
+ *      from losing on that turn
+ *      opponentChar - the character representing the pieces of the computers opponent
+ *      playColumn - the column the computer played its piece. If the move the computer 
+ *      made gives the opponent the win it will be changed back to its default value so
+ *      the computer can make a new move.
+ * Returns:
+ *      The column the computer plays its piece in
+ * Side-Effects:
+ *      The computers last move is reset to the default ('O') if it gives the
+ *      user a winning move
+ */
+int dontGiveWin(char gameBoard[numColumns][numRows], const char opponentChar, int playColumn) {
+    // the bitboard of every piece on the board
+    uint64_t occupied = 0;
+    // the bitboard of the empty cell directly above the computers last move
+    uint64_t above = 0;
+
+    // there is no need to check if the player can win if the computer has not gone yet
+    if (playColumn != 8) {
+        occupied = boardToBitboard(gameBoard, 0);
+        // the playable cell in the column the computer played in is the one above its piece.
+        // It is not set if the column is now full
+        above = playableCells(occupied) & columnMask(playColumn);
+        // if the opponent completes four in a row by playing on top of the computers
+        // piece, take the computers move back so it can make a new move
+        if (above & winningCells(boardToBitboard(gameBoard, opponentChar), occupied)) {
+            // the row of the computers last move is the one below the cell above it
+            gameBoard[playColumn][__builtin_ctzll(above) % BITBOARD_HEIGHT - 1] = 'O';
+            // set play column back to 8 so the computer can move to the next
+            // function in its logic to make a move.
+            playColumn = 8;
+        }
+    }
+
+    return playColumn;
+}
+
+// what a cell looked at by a line pattern must hold
+#define PATTERN_PIECE 0
+#define PATTERN_EMPTY 1
+#define PATTERN_PLAYABLE 2
+// the difference between the flattened indexes (column * numRows + row) of
+// neighbouring cells of a line going right, up, up-right and up-left
+#define STEP_RIGHT BOARD_ROWS
+#define STEP_UP 1
+#define STEP_UP_RIGHT (BOARD_ROWS + 1)
+#define STEP_UP_LEFT (1 - BOARD_ROWS)
+// every position in a winning line, for patterns that can sit anywhere in one
+#define ANY_POSITION ((1 << CONNECT_LENGTH) - 1)
+// the most cells a line pattern looks at besides the players piece
+#define MAX_PATTERN_CELLS 3
+// the first pattern of each rule in linePatterns, and the number of patterns
+#define THREE_TRAP_PATTERNS 0
+#define TWO_IN_A_ROW_PATTERNS 10
+#define CONNECT_TWO_PATTERNS 20
+#define NUM_LINE_PATTERNS 27
+// the play of a line pattern that has no second move
+#define NO_CELL -1
+
+/*
+ * A pattern of pieces and empty cells in a winning line that the rule based
+ * computer looks for, relative to one of the checked players pieces. The
+ * pattern only counts where a winning line holds all of its cells, so it can
+ * still grow into four in a row.
+ */
+typedef struct {
+    // the step between the cells of the line (STEP_RIGHT, STEP_UP, STEP_UP_RIGHT or STEP_UP_LEFT)
+    int step;
+    // the positions in the line the players piece can take, one bit per position
+    int anchors;
+    // the number of other cells the pattern looks at, their offsets along the
+    // line from the players piece and what each of them must hold
+    int cellCount;
+    int offsets[MAX_PATTERN_CELLS];
+    int needs[MAX_PATTERN_CELLS];
+    // the offsets of the cells to play in, in order, 0 when there is no second move
+    int plays[2];
+} LinePattern;
+
+/*
+ * A line pattern placed on one cell of the board, with the cells it looks at
+ * as bitboards so it is matched with a few ANDs
+ */
+typedef struct {
+    // the cells that must hold the players pieces (the cell itself included),
+    // that must be empty, and that must be empty with a piece or the bottom of
+    // the board below them. Where no winning line holds the pattern every bit
+    // of pieces is set, including the spare bits, so it never matches.
+    uint64_t pieces;
+    uint64_t empty;
+    uint64_t playable;
+    // the flattened indexes of the cells to play in, in order, or NO_CELL
+    int plays[2];
+} LinePatternMatch;
+
+// the patterns of threeTrap, twoInARow and connectTwo, each rule trying its
+// patterns in order at every cell
+const LinePattern linePatterns[NUM_LINE_PATTERNS] = {
+    // threeTrap: X__X and _XX_ horizontally, then the same up-right and up-left,
+    // __XX down-left of the pieces and XX__ up the diagonals
+    {STEP_RIGHT, 1 << 0, 3, {3, 1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE, PATTERN_PLAYABLE}, {1, 2}},
+    {STEP_RIGHT, 1 << 1, 3, {1, -1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE, PATTERN_PLAYABLE}, {-1, 2}},
+    {STEP_UP_RIGHT, 1 << 0, 3, {3, 1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE, PATTERN_PLAYABLE}, {1, 2}},
+    {STEP_UP_RIGHT, 1 << 1, 3, {1, -1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE, PATTERN_PLAYABLE}, {2, -1}},
+    {STEP_UP_LEFT, 1 << 0, 3, {3, 1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE, PATTERN_PLAYABLE}, {1, 2}},
+    {STEP_UP_LEFT, 1 << 1, 3, {1, -1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE, PATTERN_PLAYABLE}, {2, -1}},
+    {STEP_UP_RIGHT, 1 << 2, 3, {1, -1, -2}, {PATTERN_PIECE, PATTERN_EMPTY, PATTERN_PLAYABLE}, {-1, 0}},
+    {STEP_UP_LEFT, 1 << 2, 3, {1, -1, -2}, {PATTERN_PIECE, PATTERN_EMPTY, PATTERN_PLAYABLE}, {-2, 0}},
+    {STEP_UP_RIGHT, 1 << 0, 3, {1, 2, 3}, {PATTERN_PIECE, PATTERN_EMPTY, PATTERN_PLAYABLE}, {3, 0}},
+    {STEP_UP_LEFT, 1 << 0, 3, {1, 2, 3}, {PATTERN_PIECE, PATTERN_EMPTY, PATTERN_PLAYABLE}, {3, 0}},
+    // twoInARow: XX_ vertically, then XX_, _XX and X_X horizontally and up
+    // each diagonal
+    {STEP_UP, ANY_POSITION, 2, {1, 2}, {PATTERN_PIECE, PATTERN_EMPTY}, {2, 0}},
+    {STEP_RIGHT, 1 << 0, 2, {1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE}, {2, 0}},
+    {STEP_RIGHT, 1 << 2, 2, {1, -1}, {PATTERN_PIECE, PATTERN_PLAYABLE}, {-1, 0}},
+    {STEP_RIGHT, 1 << 0, 2, {1, 2}, {PATTERN_PLAYABLE, PATTERN_PIECE}, {1, 0}},
+    {STEP_UP_RIGHT, 1 << 0, 2, {1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE}, {2, 0}},
+    {STEP_UP_RIGHT, 1 << 1, 2, {1, -1}, {PATTERN_PIECE, PATTERN_PLAYABLE}, {-1, 0}},
+    {STEP_UP_RIGHT, ANY_POSITION, 2, {1, 2}, {PATTERN_PLAYABLE, PATTERN_PIECE}, {1, 0}},
+    {STEP_UP_LEFT, 1 << 0, 2, {1, 2}, {PATTERN_PIECE, PATTERN_PLAYABLE}, {2, 0}},
+    {STEP_UP_LEFT, 1 << 1, 2, {1, -1}, {PATTERN_PIECE, PATTERN_PLAYABLE}, {-1, 0}},
+    {STEP_UP_LEFT, ANY_POSITION, 2, {1, 2}, {PATTERN_PLAYABLE, PATTERN_PIECE}, {1, 0}},
+    // connectTwo: the cell above the piece, then right, left, up-right,
+    // down-left, up-left and down-right of it
+    {STEP_UP, ANY_POSITION, 1, {1}, {PATTERN_EMPTY}, {1, 0}},
+    {STEP_RIGHT, ANY_POSITION, 1, {1}, {PATTERN_PLAYABLE}, {1, 0}},
+    {STEP_RIGHT, ANY_POSITION, 1, {-1}, {PATTERN_PLAYABLE}, {-1, 0}},
+    {STEP_UP_RIGHT, ANY_POSITION, 1, {1}, {PATTERN_PLAYABLE}, {1, 0}},
+    {STEP_UP_RIGHT, ANY_POSITION, 1, {-1}, {PATTERN_PLAYABLE}, {-1, 0}},
+    {STEP_UP_LEFT, ANY_POSITION, 1, {1}, {PATTERN_PLAYABLE}, {1, 0}},
+    {STEP_UP_LEFT, ANY_POSITION, 1, {-1}, {PATTERN_PLAYABLE}, {-1, 0}}
+};
+// every line pattern placed on every cell, filled in by initLinePatterns. The
+// patterns of a cell are kept together as they are tried one after another.
+LinePatternMatch linePatternMatches[NUM_CELLS][NUM_LINE_PATTERNS];
+
+/*
+ * Purpose:
+ *      To find the bitboard bit of a cell of the gameboard
+ * Parameters:
+ *      cell - the flattened index (column * numRows + row) of the cell
+ * Returns:
+ *      A bitboard with only the cell set
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t cellBit(const int cell) {
+    return (uint64_t)1 << ((cell / BOARD_ROWS) * BITBOARD_HEIGHT + cell % BOARD_ROWS);
+}
+
+/*
+ * Purpose:
+ *      To place every line pattern on every cell it fits at, once at start up,
+ *      so the rule based computer matches patterns from the winning line table
+ *      instead of checking the bounds of the board around each piece
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      linePatternMatches is filled in. initLineTables must have been called.
+ */
+void initLinePatterns() {
+    // the counters for the pattern, the winning line, the position of the
+    // players piece in the line and the cell of the pattern
+    int pattern = 0;
+    int line = 0;
+    int position = 0;
+    int k = 0;
+
+    memset(linePatternMatches, 0, sizeof(linePatternMatches));
+    for (k = 0; k < NUM_CELLS; k++) {
+        for (pattern = 0; pattern < NUM_LINE_PATTERNS; pattern++) {
+            linePatternMatches[k][pattern].pieces = ~(uint64_t)0;
+        }
+    }
+    for (pattern = 0; pattern < NUM_LINE_PATTERNS; pattern++) {
+        // the pattern being placed
+        const LinePattern* shape = &linePatterns[pattern];
+        for (line = 0; line < NUM_LINES; line++) {
+            if (lineCells[line][1] - lineCells[line][0] != shape->step) {
+                continue;
+            }
+            for (position = 0; position < CONNECT_LENGTH; position++) {
+                // the pattern placed on the cell at this position of the line
+                LinePatternMatch* match = &linePatternMatches[lineCells[line][position]][pattern];
+                // if the players piece can be here and every cell of the pattern is in the line
+                int inLine = (shape->anchors >> position) & 1;
+
+                for (k = 0; k < shape->cellCount; k++) {
+                    inLine = inLine && (position + shape->offsets[k] >= 0) && (position + shape->offsets[k] < CONNECT_LENGTH);
+                }
+                // every line that holds the pattern gives the same cells, so
+                // the first one found is kept
+                if ((!inLine) || (match->pieces != ~(uint64_t)0)) {
+                    continue;
+                }
+                match->pieces = cellBit(lineCells[line][position]);
+                for (k = 0; k < shape->cellCount; k++) {
+                    // the bit of the cell being looked at
+                    uint64_t bit = cellBit(lineCells[line][position + shape->offsets[k]]);
+                    if (shape->needs[k] == PATTERN_PIECE) {
+                        match->pieces |= bit;
+                    } else if (shape->needs[k] == PATTERN_EMPTY) {
+                        match->empty |= bit;
+                    } else {
+                        match->playable |= bit;
+                    }
+                }
+                for (k = 0; k < 2; k++) {
+                    match->plays[k] = (shape->plays[k] != 0) ? lineCells[line][position + shape->plays[k]] : NO_CELL;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Purpose:
+ *      To read the cells of the gameboard that line patterns are matched against
+ * Parameters:
+ *      gameBoard - the game board array
+ *      checkChar - the character of the player whose pieces the patterns are made of
+ *      pieces - set to the bitboard of that players pieces
+ *      empty - set to the bitboard of the empty cells
+ *      playable - set to the bitboard of the empty cells with a piece or the
+ *      bottom of the board below them
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void readPatternBitboards(const char gameBoard[numColumns][numRows], const char checkChar, uint64_t* pieces, uint64_t* empty, uint64_t* playable) {
+    // the bitboard of every piece on the board
+    uint64_t occupied = 0;
+    // the counters for the column and row
+    int column = 0;
+    int row = 0;
+
+    // both bitboards are built in one pass over the board
+    *pieces = 0;
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        for (row = 0; row < BOARD_ROWS; row++) {
+            occupied |= (uint64_t)(gameBoard[column][row] != 'O') << (column * BITBOARD_HEIGHT + row);
+            *pieces |= (uint64_t)(gameBoard[column][row] == checkChar) << (column * BITBOARD_HEIGHT + row);
+        }
+    }
+    *empty = boardMask & ~occupied;
+    // a piece below a cell is the piece one bit lower in the same column
+    *playable = *empty & ((occupied << 1) | bottomMask);
+}
+
+/*
+ * Purpose:
+ *      To find the first of a rules line patterns that matches the board at a cell
+ * Parameters:
+ *      first - the index of the first pattern of the rule
+ *      last - the index after the last pattern of the rule
+ *      cell - the flattened index of the players piece
+ *      pieces - the bitboard of the players pieces
+ *      empty - the bitboard of the empty cells
+ *      playable - the bitboard of the empty cells a piece can be played in
+ * Returns:
+ *      The pattern placed on the cell, or NULL if none of them match
+ * Side-Effects:
+ *      NONE
+ */
+const LinePatternMatch* findLinePattern(const int first, const int last, const int cell, const uint64_t pieces, const uint64_t empty, const uint64_t playable) {
+    // the pattern that matches
+    const LinePatternMatch* found = NULL;
+    // the counter for the pattern
+    int pattern = 0;
+
+    for (pattern = first; (pattern < last) && (found == NULL); pattern++) {
+        // the pattern placed on the cell
+        const LinePatternMatch* match = &linePatternMatches[cell][pattern];
+        if (((pieces & match->pieces) == match->pieces) && ((empty & match->empty) == match->empty) && ((playable & match->playable) == match->playable)) {
+            found = match;
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Purpose:
+ *      To check if the computer or player can indirectly get 3 pieces in a row 
+ *      or prevent the user from playing a trap where they get 3 in a row indirectly.
+ *      Overall this will reduce the risk of a user trapping the computer
+ *      with two possible moves to win at the same time. While this does not address
+ *      every possible trap, it takes action against many of the most common types 
+ *      through this defense/offense 
+  * Parameters:
+ *      gameBoard - the game board array
+ *      computerChar - the character representing the computers pieces
+ *      checkChar - the character for the player that the programming is checking
+ *      if they can get 3 in an indirect line i.e XOOX where playing XXOX could give
+ *      the player a winning move
+ *      opponentChar - the character representing the pieces of the computers opponent
  * Returns:
  *      playColumn - the column the computer played its pieces in to be outputted
  *      to the other player
  * Side-Effects:
- *      The gameBoard array is modified wherever the computer plays its piece to win the game
- *      or to prevent the user from winning. 
+ *      The gameBoard array is modified wherever the computer plays its piece to get
+ *      three in a row indirectly or block the player from getting it
+ */
+int threeTrap(char gameBoard[numColumns][numRows], const char computerChar, const char checkChar, const char opponentChar) {
+    // the gameboard viewed as one array so the cell indexes in the pattern table can be used
+    char* cells = &gameBoard[0][0];
+    // the bitboards of the checked players pieces, the empty cells and the
+    // empty cells a piece can be played in
+    uint64_t pieces = 0;
+    uint64_t empty = 0;
+    uint64_t playable = 0;
+    // the pattern found at the cell being checked
+    const LinePatternMatch* match = NULL;
+    // the counter for the row index
+    int i = 0;
+    // the counter for the column index
+    int j = 0;
+    // the counter for the moves of the pattern
+    int k = 0;
+    // a default value for the play column that is not a valid column so if 
+    // this function does not find a way for the computer to win, the computer turn
+    // function will move on to the next function to try to find a good move for the 
+    // computer to play
+    int playColumn = 8;
+
+    readPatternBitboards(gameBoard, checkChar, &pieces, &empty, &playable);
+    // check the cells row by row, column by column, for a piece of the player
+    // that starts an indirect line of three (like XOOX or OXXO) in a winning
+    // line. The pattern table only holds patterns that fit in a winning line so
+    // no bounds need to be checked here.
+    for (i = 0; (i < numRows) && (playColumn == 8); i++) {
+        for (j = 0; (j < numColumns) && (playColumn == 8); j++) {
+            // every pattern starts from a piece of the player
+            if (!((pieces >> (j * BITBOARD_HEIGHT + i)) & 1)) {
+                continue;
+            }
+            match = findLinePattern(THREE_TRAP_PATTERNS, TWO_IN_A_ROW_PATTERNS, j * numRows + i, pieces, empty, playable);
+            if (match == NULL) {
+                continue;
+            }
+            // play in the first space of the pattern, and if that gives the
+            // opponent a winning move it is undone and the second space is tried
+            for (k = 0; (k < 2) && (match->plays[k] != NO_CELL) && (playColumn == 8); k++) {
+                cells[match->plays[k]] = computerChar;
+                playColumn = dontGiveWin(gameBoard, opponentChar, match->plays[k] / numRows);
+                // dontGiveWin takes back the top piece of the column, which is
+                // not the piece played if it was played above an empty cell, so
+                // then the board is read again
+                if ((playColumn == 8) && (cells[match->plays[k]] != 'O')) {
+                    readPatternBitboards(gameBoard, checkChar, &pieces, &empty, &playable);
+                }
+            }
+        }
+    }
+
+    return playColumn;
+}
+
+
+/*
+ * Purpose:
+ *      For the computer to play a piece to get three in a row or to prevent 
+ *      the user from getting three in a row.
+ * Parameters:
+ *      gameBoard - the game board array
+ *      computerChar - the character for the computer representing its pieces
+ *      checkChar - the character for the player that the programming is checking
+ *      if they have 2 in a row
+ *      opponentChar - the character representing the opponent to check
+ *      if the computers move gives it the win
+ * Returns:
+ *      playColumn - the column the computer played its pieces in to be outputted
+ *      to the player
+ * Side-Effects:
+ *      The gameBoard array is modified wherever the computer plays its piece to get
+ *      three in a row or to prevent the user from getting three in a row. 
+ */
+int twoInARow(char gameBoard[numColumns][numRows], const char computerChar, const char checkChar, const char opponentChar) {
+    // the gameboard viewed as one array so the cell indexes in the pattern table can be used
+    char* cells = &gameBoard[0][0];
+    // the bitboards of the checked players pieces, the empty cells and the
+    // empty cells a piece can be played in
+    uint64_t pieces = 0;
+    uint64_t empty = 0;
+    uint64_t playable = 0;
+    // the pattern found at the cell being checked
+    const LinePatternMatch* match = NULL;
+    // the counter for the row index
+    int i = 0;
+    // the counter for the column index
+    int j = 0;
+    // a default value for the play column that is not a valid column so if 
+    // this function does not find a way for the computer to win, the computer turn
+    // function will move on to the next function to try to find a good move for the 
+    // computer to play
+    int playColumn = 8;
+
+    readPatternBitboards(gameBoard, checkChar, &pieces, &empty, &playable);
+    // check the cells row by row, column by column, for a piece of the player
+    // that makes two of a winning line with a space to play the third in. The
+    // pattern table only holds patterns that fit in a winning line, so three in
+    // a row can still be added on to make 4 in a row and no bounds need to be
+    // checked here.
+    for (i = 0; (i < numRows) && (playColumn == 8); i++) {
+        for (j = 0; (j < numColumns) && (playColumn == 8); j++) {
+            // every pattern starts from a piece of the player
+            if (!((pieces >> (j * BITBOARD_HEIGHT + i)) & 1)) {
+                continue;
+            }
+            match = findLinePattern(TWO_IN_A_ROW_PATTERNS, CONNECT_TWO_PATTERNS, j * numRows + i, pieces, empty, playable);
+            if (match == NULL) {
+                continue;
+            }
+            // play piece to get 3 in a row or prevent the user from getting
+            // three in a row
+            cells[match->plays[0]] = computerChar;
+            // if the computers move gives the user a winning move, undo the 
+            // move and reset the play column to 8 (this can be seen in the function called here)
+            // so the computer will continue to look for good moves
+            playColumn = dontGiveWin(gameBoard, opponentChar, match->plays[0] / numRows);
+            if (playColumn != 8) {
+                // if the computers move gives the user a move to block it from winning, undo the 
+                // move and reset the play column to 8 so the computer will continue to look
+                // for good moves. This aims to eventually force the user
+                // to play a piece to give the computer the win late in the game, instead
+                // of the computer accidentally giving the user a way to tie by blocking it 
+                // from getting 4 in a row. This uses the dont give win function but checks
+                // for places the computer can win instead of the player
+                playColumn = dontGiveWin(gameBoard, computerChar, playColumn);
+            }
+            // dontGiveWin takes back the top piece of the column, which is not
+            // the piece played if it was played above an empty cell, so then
+            // the board is read again
+            if ((playColumn == 8) && (cells[match->plays[0]] != 'O')) {
+                readPatternBitboards(gameBoard, checkChar, &pieces, &empty, &playable);
+            }
+        }
+    }
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      For the computer to place a piece to get 2 in a row
+ * Parameters:
+ *      gameBoard - the gameBoard array
+ *      computerChar - the character representing the computers pieces
+ *      opponentChar - the character representing the opponent to check
+ *      if the computers move gives it the win
+ * Returns:
+ *      playColumn - The column the computer played its piece in to be 
+ *      outputted to the player
+ * Side-Effects:
+ *      The gameboard array is modified when the computer makes its move
+ */
+int connectTwo(char gameBoard[numColumns][numRows], char computerChar, const char opponentChar) {
+    // the gameboard viewed as one array so the cell indexes in the pattern table can be used
+    char* cells = &gameBoard[0][0];
+    // the bitboards of the computers pieces, the empty cells and the empty
+    // cells a piece can be played in
+    uint64_t pieces = 0;
+    uint64_t empty = 0;
+    uint64_t playable = 0;
+    // the pattern found at the cell being checked
+    const LinePatternMatch* match = NULL;
+    // the counter for the row index
+    int i = 0;
+    // the counter for the column index
+    int j = 0;
+    // a default value for the play column that is not a valid column so if 
+    // this function does not find a way for the computer to win, the computer turn
+    // function will move on to the next function to try to find a good move for the 
+    // computer to play
+    int playColumn = 8;
+
+    readPatternBitboards(gameBoard, computerChar, &pieces, &empty, &playable);
+    // check the cells row by row, column by column, for a piece of the computer
+    // with a space next to it in a winning line. The pattern table only holds
+    // patterns that fit in a winning line so no bounds need to be checked here.
+    for (i = 0; (i < numRows) && (playColumn == 8); i++) {
+        for (j = 0; (j < numColumns) && (playColumn == 8); j++) {
+            // every pattern starts from a piece of the player
+            if (!((pieces >> (j * BITBOARD_HEIGHT + i)) & 1)) {
+                continue;
+            }
+            match = findLinePattern(CONNECT_TWO_PATTERNS, NUM_LINE_PATTERNS, j * numRows + i, pieces, empty, playable);
+            if (match == NULL) {
+                continue;
+            }
+            // place piece for the computer to get 2 in a row
+            cells[match->plays[0]] = computerChar;
+            // if the computers move gives the user a winning move, or a move to
+            // block the computer from winning, undo the move and reset the play
+            // column to 8 so the computer will continue to look for good moves
+            playColumn = dontGiveWin(gameBoard, opponentChar, match->plays[0] / numRows);
+            if (playColumn != 8) {
+                playColumn = dontGiveWin(gameBoard, computerChar, playColumn);
+            }
+            // dontGiveWin takes back the top piece of the column, which is not
+            // the piece played if it was played above an empty cell, so then
+            // the board is read again
+            if ((playColumn == 8) && (cells[match->plays[0]] != 'O')) {
+                readPatternBitboards(gameBoard, computerChar, &pieces, &empty, &playable);
+            }
+        }
+    }
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      For the computer to play its first two moves
+ * Parameters:
+ *      gameBoard - the array for the gameboard
+ *      computerChar - the character representing the computers pieces
+ *      opponentChar - the character representing the users pieces
+ *      playColumn - the column the computer plays its piece in
+ *      turn - the turn the game is on
+ * Returns:
+ *      playColumn - the column the computer plays its piece in
+ * Side-Effects:
+ *      The gameboard array is modified to place the computer pieces
+ */
+int playFirstTwoMoves(char gameBoard[numColumns][numRows], const char computerChar, const char opponentChar, int playColumn, const int turn) {
+        // play first turn in the middle of the board as it is a strong strategic position
+    if (turn == 0) {
+        // changes the default value of the 3rd column and 0th row to the computers char
+        gameBoard[3][0] = computerChar;
+        // change the value of the column the computer played to be outputted to the live player
+        playColumn = 3;
+    }
+    // play computer second turn in a good position for the computer
+    else {
+        // based of the minimax algorithm the following moves were made every 
+        // time the second move was simulated so they have been recreated to
+        // give the computer a strong first two moves
+        
+        // NOTE the indexes here are checked as they would be in the array (from 0 - 6)
+        // however for my commenting 1 has been added to the index because that is the
+        // column value the user of the program would see
+        
+        // if the user plays their piece in column 2 or 3, the computer plays its
+        // piece in column 5
+        if ((gameBoard[1][0] == opponentChar) || (gameBoard[2][0] == opponentChar)) {
+            gameBoard[5][0] = computerChar;
+            playColumn = 5;
+        // if the user plays their piece in column 5 or 6, the computer plays its
+        // piece in column 2.
+        } else if ((gameBoard[4][0] == opponentChar) || (gameBoard[5][0] == opponentChar)) {
+            gameBoard[1][0] = computerChar;
+            playColumn = 1;
+        // if the user plays their piece in column 1 or 7, the computer plays its
+        // piece in column 4 above its first piece
+        } else if ((gameBoard[0][0] == opponentChar) || (gameBoard[6][0] == opponentChar)) {
+            gameBoard[3][1] = computerChar;
+            playColumn = 3;
+        // if the user plays their piece in column 4 above the computers first piece
+        // the computer plays its piece above the user piece in column 4
+        } else if (gameBoard[3][1] == opponentChar) {
+            gameBoard[3][2] = computerChar;
+            playColumn = 3;
+        }
+    }
+    
+    return playColumn;
+}
+
+
+/*
+ * Purpose:
+ *      To play the best move for the computer by calling functions
+ *      for the computer to play pieces. It first checks if the computer can get 3
+ *      in a row or prevent the opponent from getting 3 and then it checks if the
+ *      computer can get two in a row and if none of these are met it will play a random
+ *      piece.
+ * Parameters:
+ *      gameBoard - the gameboard that is modified to make the computers move
+ *      computerChar - the character chosen for the computer
+ *      opponentChar - the live players chosen character
+ * Returns:
+ *      playColumn - the column the computer plays its piece in
+ * Side-Effects: 
+ *      The gameboard array is modified in functions called by this one
+ */
+int playBestMove(char gameBoard[numColumns][numRows], const char computerChar, const char opponentChar) {
+    // initiate the variable for the column the computer plays its piece in
+    // as a column number outside the array so the gameboard is not modified unless
+    // the computer finds a move to play within the gameboard where this will be reassigned
+    int playColumn = 8;
+    // the row the computer plays its piece in which is needed if the computer
+    // picks a random column to play in
+    int rowSlot = 0;
+    // the time the stage being profiled started
+    uint64_t start = 0;
+    
+    // the column the computer plays has not been modified from 
+    // the function calls in computer turn function that come before this function call
+    if (playColumn == 8) {
+        // check if the computer can get a set of three in a row in an indirect
+        // line to try to trap the user player. Eg something like this XOXX where 
+        // x is the computer piece
+        start = startStage();
+        playColumn = endStage(STAGE_THREE_TRAP, start, threeTrap(gameBoard, computerChar, computerChar, opponentChar));
+    }
+    if (playColumn == 8) {
+        // check if the computer has 2 in a row (or 2 with an empty 
+        // space in the middle), play a piece to get 3 in a row
+        start = startStage();
+        playColumn = endStage(STAGE_TWO_IN_A_ROW, start, twoInARow(gameBoard, computerChar, computerChar, opponentChar));
+    }
+    if (playColumn == 8) {
+        // check if the player can get a set of three in a row in an indirect
+        // line to try to trap the computer and play a move to block it. Eg something like this X_OX where 
+        // O is the computer piece that has blocked the player from a indirect 3 in a line trap
+        start = startStage();
+        playColumn = endStage(STAGE_BLOCK_THREE_TRAP, start, threeTrap(gameBoard, computerChar, opponentChar, opponentChar));
+    }
+    // the playColumn was not modified by the previous function call
+    if (playColumn == 8) {
+        // check if the user has 2 in a row (or 2 with an empty 
+        // space in the middle), play a piece to prevent them from getting 3 in a row
+        start = startStage();
+        playColumn = endStage(STAGE_BLOCK_TWO_IN_A_ROW, start, twoInARow(gameBoard, computerChar, opponentChar, opponentChar));
+    }
+    // the playColumn was not modified by the previous function call
+    if (playColumn == 8) {
+        // place a piece to give the computer two in a row.
+        start = startStage();
+        playColumn = endStage(STAGE_CONNECT_TWO, start, connectTwo(gameBoard, computerChar, opponentChar));
+    }
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      For the computer to play a random move
+ * Parameters:
+ *      gameBoard - the gameboard that is modified for the computer to play a random move
+ *      computerChar - the character chosen for the computer
+ * Returns:
+ *      playColumn - the column index (0 - 6) the computer plays its piece in
+ * Side-Effects: 
+ *      The gameboard array is modified to play the computer piece
+ */
+int playRandomMove(char gameBoard[numColumns][numRows], const char computerChar) {
+    // pick one of the columns that are not full, each as likely as the others,
+    // without retrying full columns
+    int playColumn = randomColumn(&gameRandom, boardToBitboard(gameBoard, 0));
+
+    // place the computers piece in the column it randomly chose. 1 is added
+    // because the place piece function takes the column number the user enters
+    placepiece(gameBoard, computerChar, playColumn + 1);
+
+    return playColumn;
+}
+
+/*
+ * A search run by the computer on its own thread while the game waits for it
+ */
+typedef struct {
+    // the position searched
+    Position position;
+    // the time wanted for the search
+    double seconds;
+    // the channel the progress and the chosen move are sent on
+    EngineChannel channel;
+    // the thread running the search
+    pthread_t thread;
+} ComputerSearch;
+
+/*
+ * Purpose:
+ *      To run the computers search and send the move it chooses to the game
+ * Parameters:
+ *      argument - the ComputerSearch to run
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      Progress messages and then a move message are sent on the channel
+ */
+void* runComputerSearch(void* argument) {
+    // the search being run
+    ComputerSearch* search = argument;
+    // the move chosen
+    EngineMessage message;
+    // the depth reached, not needed
+    int depth = 0;
+
+    memset(&message, 0, sizeof(message));
+    message.type = MESSAGE_MOVE;
+    // the search is cut off at twice the time wanted in case a depth takes far
+    // longer than expected
+    message.column = searchTimed(&search->position, search->seconds, 2 * search->seconds, 0, NULL, &search->channel, &message.score, &depth, &message.nodes);
+    makeMove(&search->position, message.column);
+    message.pieces[0] = search->position.pieces[0];
+    message.pieces[1] = search->position.pieces[1];
+    publishMessage(&search->channel, &message);
+
+    return NULL;
+}
+
+/*
+ * Purpose:
+ *      To play the move found by a search given the share of the computers clock
+ *      that it can use for this move. The search runs on its own thread and
+ *      sends its progress over a ring buffer, so the game keeps showing how the
+ *      search is going while the computer thinks.
+ * Parameters:
+ *      gameBoard - the game board array
+ *      computerChar - the character representing the computers pieces
+ *      opponentChar - the character representing the pieces of the computers opponent
+ *      clockRemaining - the seconds left on the computers clock
+ * Returns:
+ *      playColumn - the column index the computer played in, or 8 if every move loses
+ *      at once and the choice is left to the other move functions
+ * Side-Effects:
+ *      The gameBoard array is modified wherever the computer plays its piece
+ */
+int playTimedMove(char gameBoard[numColumns][numRows], const char computerChar, const char opponentChar, const double clockRemaining) {
+    // the position the computer is to move in
+    Position position;
+    // the moves that do not let the opponent win at once
+    uint64_t safe = 0;
+    // the time the computer can use
+    double seconds = 0;
+    // the search run on the computers thread and the ring buffer the game reads it from
+    ComputerSearch search;
+    RingBuffer* ring = NULL;
+    // the message read from the ring buffer
+    EngineMessage message;
+    // the column the computer plays in
+    int playColumn = 8;
+
+    // the player to move moved first if an even number of pieces has been played
+    loadPositionFromBoard(&position, gameBoard, (__builtin_popcountll(boardToBitboard(gameBoard, 0)) & 1) ? opponentChar : computerChar);
+    safe = safeMoves(&position);
+    seconds = allocateMoveTime(&position, clockRemaining, clockIncrement);
+    if (__builtin_popcountll(safe) == 1) {
+        // there is only one move that does not lose at once so play it without thinking
+        playColumn = bitboardColumn(safe);
+    } else if ((safe != 0) && ((ring = createRingBuffer()) != NULL)) {
+        memset(&search, 0, sizeof(search));
+        search.position = position;
+        search.seconds = seconds;
+        attachFrontend(&search.channel, ring);
+        pthread_create(&search.thread, NULL, runComputerSearch, &search);
+        // show the progress of the search until its move arrives
+        while (playColumn == 8) {
+            if (!popRingBuffer(ring, &message)) {
+                usleep(1000);
+            } else if (message.type == MESSAGE_PROGRESS) {
+                if (quietMode) {
+                    continue;
+                }
+                printf("\rThe computer is thinking... depth %d, %lld positions, %.1f seconds", message.depth, message.nodes, message.seconds);
+                fflush(stdout);
+            } else {
+                playColumn = message.column;
+            }
+        }
+        if (!quietMode) {
+            printf("\n");
+        }
+        pthread_join(search.thread, NULL);
+        freeRingBuffer(ring);
+    }
+    if (playColumn != 8) {
+        placepiece(gameBoard, computerChar, playColumn + 1);
+    }
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      To find the column of the piece played since the board was last checked
+ * Parameters:
+ *      gameBoard - the game board array
+ *      occupied - the bitboard of the pieces at the last check, updated to the current pieces
+ * Returns:
+ *      The column number (1 - 7) of the new piece, or 0 if there is none
+ * Side-Effects:
+ *      occupied is updated
+ */
+int findPlayedColumn(const char gameBoard[numColumns][numRows], uint64_t* occupied) {
+    // the bitboard of the pieces now on the board
+    uint64_t current = boardToBitboard(gameBoard, 0);
+    // the new pieces
+    uint64_t played = current & ~*occupied;
+
+    *occupied = current;
+
+    return (played != 0) ? bitboardColumn(played) + 1 : 0;
+}
+
+/*
+ * Purpose:
+ *      To add a finished game to the end of the game log so it can be analysed later
+ * Parameters:
+ *      moves - the columns played in the game, e.g. 4453
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      A line is appended to the game log file if one was given
+ */
+void appendGameLog(const char* moves) {
+    // the game log file
+    FILE* file = NULL;
+
+    if (gameLogName == NULL) {
+        return;
+    }
+    file = fopen(gameLogName, "a");
+    if (file == NULL) {
+        printf("Could not write the game to '%s'\n", gameLogName);
+        return;
+    }
+    fprintf(file, "%s\n", moves);
+    fclose(file);
+}
+
+/*
+ * Purpose:
+ *      To take the time a player used for their move off their clock
+ * Parameters:
+ *      clock - the seconds left on the players clock
+ *      moveStart - the time the players move started
+ * Returns:
+ *      1 if the move was made in time, or 0 if the players time ran out
+ * Side-Effects:
+ *      The time used is taken off the clock and the increment is added if the
+ *      move was made in time
+ */
+int chargeClock(double* clock, const double moveStart) {
+    *clock -= monotonicSeconds() - moveStart;
+    if (*clock < 0) {
+        *clock = 0;
+        return 0;
+    }
+    *clock += clockIncrement;
+
+    return 1;
+}
+
+/*
+ * Purpose:
+ *      To print the time left on both players clocks
+ * Parameters:
+ *      clocks - the seconds left for player 1 and player 2
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printClocks(const double clocks[2]) {
+    printf("Clock - player 1: %d:%04.1f  player 2: %d:%04.1f\n", (int)clocks[0] / 60, clocks[0] - 60 * ((int)clocks[0] / 60), (int)clocks[1] / 60, clocks[1] - 60 * ((int)clocks[1] / 60));
+}
+
+// the flags kept in a packed session: the computer moves first, the game is
+// over and, for the multiplex command, the game has been started
+#define SESSION_COMPUTER 1
+#define SESSION_FINISHED 2
+#define SESSION_STARTED 4
+// the largest clock a packed session can hold, in tenths of a second
+#define SESSION_MAX_CLOCK 65535
+
+/*
+ * The whole state of one game packed into 16 bytes so a large number of idle
+ * games can be held in memory. Each column of the board takes 7 bits: the
+ * pieces of the player who moved first, with a marker bit set just above the
+ * top piece. An empty column is only the marker in its bottom bit.
+ */
+typedef struct {
+    // the board, 7 bits for each column
+    uint64_t cells;
+    // the tenths of a second left on the clocks of the first and second player
+    uint16_t clocks[2];
+    // the characters of the first and second player
+    char playerChars[2];
+    // the number of pieces played
+    uint8_t moveCount;
+    // the SESSION_ flags
+    uint8_t flags;
+} PackedSession;
+
+_Static_assert(sizeof(PackedSession) == 16, "a packed session must stay 16 bytes");
+
+// the number of moves kept in each word of a hosted games move list, 3 bits each
+#define HOSTED_MOVES_PER_WORD 21
+
+/*
+ * A game of the multiplex command while it waits for its next line. The board,
+ * clocks, players and state are a packed session. The columns played are kept
+ * for the game log, and the time the move being waited for started so the
+ * clock of the player to move runs on while the game is packed.
+ */
+typedef struct {
+    // the board, clocks, players and SESSION_ flags
+    PackedSession session;
+    // the column index (0 - 6) of every move played in order, 3 bits each
+    uint64_t moveColumns[(NUM_CELLS + HOSTED_MOVES_PER_WORD - 1) / HOSTED_MOVES_PER_WORD];
+    // the time the move being waited for started
+    double moveStart;
+} HostedGame;
+
+/*
+ * Purpose:
+ *      To pack a game into a packed session. Adding the bottom cell of every
+ *      column to the pieces carries up to the first empty cell, which is the
+ *      marker, so the board is packed with one add and one or.
+ * Parameters:
+ *      session - the packed session to fill
+ *      first - the bitboard of the pieces of the player who moved first
+ *      occupied - the bitboard of every piece
+ *      firstChar - the character of the player who moved first
+ *      secondChar - the character of the player who moved second
+ *      clocks - the seconds left on the clocks of the first and second player, or NULL
+ *      flags - the SESSION_ flags
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      session is overwritten
+ */
+void packSession(PackedSession* session, const uint64_t first, const uint64_t occupied, const char firstChar, const char secondChar, const double clocks[2], const int flags) {
+    // the counter for the clocks
+    int i = 0;
+
+    session->cells = first | (occupied + bottomMask);
+    session->moveCount = __builtin_popcountll(occupied);
+    session->playerChars[0] = firstChar;
+    session->playerChars[1] = secondChar;
+    session->flags = flags;
+    for (i = 0; i < 2; i++) {
+        // the clock in tenths of a second
+        double tenths = (clocks != NULL) ? clocks[i] * 10 + 0.5 : 0;
+        session->clocks[i] = (tenths > SESSION_MAX_CLOCK) ? SESSION_MAX_CLOCK : (uint16_t)tenths;
+    }
+}
+
+/*
+ * Purpose:
+ *      To find every piece on the board of a packed session. The top bit of each
+ *      column is smeared down through the column, each shift masked so it does
+ *      not reach into the column below, which leaves the marker and every cell
+ *      under it.
+ * Parameters:
+ *      session - the packed session
+ * Returns:
+ *      The bitboard of the pieces of both players
+ * Side-Effects:
+ *      NONE
+ */
+uint64_t sessionOccupied(const PackedSession* session) {
+    // the cells at and below the marker of every column
+    uint64_t smeared = session->cells;
+
+    // a column is BITBOARD_HEIGHT bits, so shifts of 1, 2 and 4 cover it
+    smeared |= (smeared >> 1) & (bottomMask * (((uint64_t)1 << (BITBOARD_HEIGHT - 1)) - 1));
+    smeared |= (smeared >> 2) & (bottomMask * (((uint64_t)1 << (BITBOARD_HEIGHT - 2)) - 1));
+    smeared |= (smeared >> 4) & (bottomMask * (((uint64_t)1 << (BITBOARD_HEIGHT - 4)) - 1));
+
+    // every cell below the marker holds a piece
+    return (smeared >> 1) & boardMask;
+}
+
+/*
+ * Purpose:
+ *      To unpack a packed session into the bitboards of its board
+ * Parameters:
+ *      session - the packed session
+ *      first - set to the bitboard of the pieces of the player who moved first
+ *      occupied - set to the bitboard of every piece
+ *      clocks - the seconds left on the clocks of the first and second player, or NULL
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      first, occupied and clocks are overwritten
+ */
+void unpackSession(const PackedSession* session, uint64_t* first, uint64_t* occupied, double clocks[2]) {
+    *occupied = sessionOccupied(session);
+    *first = session->cells & *occupied;
+    if (clocks != NULL) {
+        clocks[0] = session->clocks[0] / 10.0;
+        clocks[1] = session->clocks[1] / 10.0;
+    }
+}
+
+/*
+ * Purpose:
+ *      For the computer to play a move
+ * Parameters:
+ *      computerChar - the character representing the computers pieces
+ *      gameBoard - the array for the game board
+ *      opponentChar - the character representing the live players pieces (the computers opponent)
+ *      turn - the turn the game is on
+ *      clockRemaining - the seconds left on the computers clock, 0 in a game without clocks
+ * Returns:
+ *      playColumn - the column index (0 - 6) the computer played in, or 8 if it
+ *      did not play
+ * Side-Effects:
+ *      The gameboard array is modified in functions called by this one
+ */
+int computerTurn(char computerChar, char gameBoard[numColumns][numRows], char opponentChar, int turn, const double clockRemaining) {
+    // set playColumn to 8 meaning computer has not played a move (1-7)
+    int playColumn = 8;
+    // the time the stage being profiled started
+    uint64_t start = 0;
+    
+    if (turn <= 2) {
+        // play the computers first two moves to give the computer a strong start
+        start = startStage();
+        playColumn = endStage(STAGE_FIRST_TWO_MOVES, start, playFirstTwoMoves(gameBoard, computerChar, opponentChar, playColumn, turn));
+    // after the first two turns, resort to a pattern recognition approach
+    // instead of hardcoding every single possible move
+    } else {
+        // if the computer can complete four in a row play it, otherwise if the
+        // opponent could complete four in a row on their next move block it
+        start = startStage();
+        playColumn = endStage(STAGE_IMMEDIATE_THREAT, start, playImmediateThreat(gameBoard, computerChar, opponentChar));
+        
+        // in a game with clocks the computer searches for as long as its clock allows
+        if ((playColumn == 8) && (clockRemaining > 0)) {
+            start = startStage();
+            playColumn = endStage(STAGE_TIMED_SEARCH, start, playTimedMove(gameBoard, computerChar, opponentChar, clockRemaining));
+        }
+
+        // if the computer has not made a move yet, move on to next step
+        // of computer logic
+        if (playColumn == 8) {
+            // call the play best move function to play the best move for the computer
+            playColumn = playBestMove(gameBoard, computerChar, opponentChar);
+        }
+        
+        // if the computer has not made a move yet, move on to next step
+        // of computer logic
+        if (playColumn == 8) {
+            // if the computer has not made a move yet, pick a random column to play
+            // a move. At this point it is likely the computer has no move it can make
+            // that does not let the player win
+            start = startStage();
+            playColumn = endStage(STAGE_RANDOM_MOVE, start, playRandomMove(gameBoard, computerChar));
+        }
+    }
+
+    // the profile was asked for with SIGUSR1
+    if (profileDumpRequested) {
+        profileDumpRequested = 0;
+        printStageProfile();
+    }
+
+    return playColumn;
+}
+
+/*
+ * Purpose:
+ *      To draw the game board as a grid into a buffer, without any formatted
+ *      printing so it stays cheap when many games are shown
+ * Parameters:
+ *      gameBoard - the gameboard array
+ *      buffer - the buffer to draw into, at least BOARD_BUFFER_SIZE characters
+ * Returns:
+ *      The number of characters drawn
+ * Side-Effects:
+ *      NONE
+ */
+int drawGridBoard(const char gameBoard[numColumns][numRows], char* buffer) {
+    // the number of characters drawn
+    int length = 0;
+    // counters for the rows and columns
+    int i = 0;
+    int j = 0;
+
+    memcpy(buffer, "_____________________________\n", 30);
+    length = 30;
+    // the top row is drawn first so the board is the right way up
+    for (i = numRows - 1; i >= 0; i--) {
+        buffer[length++] = '|';
+        for (j = 0; j < numColumns; j++) {
+            buffer[length++] = ' ';
+            buffer[length++] = gameBoard[j][i];
+            buffer[length++] = ' ';
+            buffer[length++] = '|';
+        }
+        buffer[length++] = '\n';
+    }
+    memcpy(buffer + length, "-----------------------------\n", 30);
+    length += 30;
+    // labels for the columns to make it easier to read
+    memcpy(buffer + length, "| 1 | 2 | 3 | 4 | 5 | 6 | 7 |\n", 30);
+    length += 30;
+
+    return length;
+}
+
+/*
+ * Purpose:
+ *      To draw the game board as one line in a FEN like form: the rows from the
+ *      top down separated by '/', with a run of empty cells written as its
+ *      length, then the character of the player to move, e.g. 7/7/7/7/3Y3/3X3 X
+ * Parameters:
+ *      gameBoard - the gameboard array
+ *      nextChar - the character of the player to move
+ *      buffer - the buffer to draw into, at least BOARD_BUFFER_SIZE characters
+ * Returns:
+ *      The number of characters drawn
+ * Side-Effects:
+ *      NONE
+ */
+int drawFenBoard(const char gameBoard[numColumns][numRows], const char nextChar, char* buffer) {
+    // the number of characters drawn
+    int length = 0;
+    // the number of empty cells waiting to be written
+    int empty = 0;
+    // counters for the rows and columns
+    int i = 0;
+    int j = 0;
+
+    for (i = numRows - 1; i >= 0; i--) {
+        for (j = 0; j < numColumns; j++) {
+            if (gameBoard[j][i] == 'O') {
+                empty++;
+                continue;
+            }
+            if (empty > 0) {
+                buffer[length++] = '0' + empty;
+                empty = 0;
+            }
+            buffer[length++] = gameBoard[j][i];
+        }
+        if (empty > 0) {
+            buffer[length++] = '0' + empty;
+            empty = 0;
+        }
+        buffer[length++] = (i > 0) ? '/' : ' ';
+    }
+    buffer[length++] = nextChar;
+    buffer[length++] = '\n';
+
+    return length;
+}
+
+/*
+ * Purpose:
+ *      To show the game board after a move in the style chosen on the command line
+ * Parameters:
+ *      gameBoard - the gameboard array
+ *      moves - the columns played so far, e.g. 4453
+ *      nextChar - the character of the player to move
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The board is written to stdout with one call, or not at all in quiet mode
+ */
+void showBoard(const char gameBoard[numColumns][numRows], const char* moves, const char nextChar) {
+    // the buffer the board is drawn into, kept between calls so nothing is allocated
+    static char buffer[BOARD_BUFFER_SIZE];
+    // the number of characters drawn
+    int length = 0;
+
+    if (boardStyle == BOARD_STYLE_GRID) {
+        length = drawGridBoard(gameBoard, buffer);
+    } else if (boardStyle == BOARD_STYLE_FEN) {
+        length = drawFenBoard(gameBoard, nextChar, buffer);
+    } else if (boardStyle == BOARD_STYLE_MOVES) {
+        length = strlen(moves);
+        memcpy(buffer, moves, length);
+        buffer[length++] = '\n';
+    }
+    if (length > 0) {
+        fwrite(buffer, 1, length, stdout);
+    }
+}
+
+/*
+ * Purpose:
+ *      To print a message to the winning player
+ * Parameters:
+ *      player - the player number
+ *      gameMode - the game mode the user is playing
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printWinMessage(int player, char gameMode) {
+    // if the gamemode is user v computer and the player is #2 (the computer)
+    // print message saying the computer won
+    if ((gameMode == 'c') && (player == 2)){
+        printf("\nToo bad. The computer won!\n");
+    // the game was not against the computer
+    } else {
+        printf("\nCongratulations player %d. You won!\n", player);
+        printf("\n");
+    }
+}
+
+/*
+ * Purpose:
+ *      To print a message if the game ends in a tie
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printTieMessage() {
+    printf("Good Effort! You Tied.\n");
+    printf("\n");
+}
+
+// the game is waiting for a human player to give a move
+#define GAME_WAITING 0
+// the game has been won, lost or tied
+#define GAME_FINISHED 1
+// the move given to the game can not be played
+#define GAME_INVALID -1
+
+/*
+ * A game of connect four kept as explicit state instead of on the stack of a
+ * loop, so it can stop whenever a human player has to move and carry on when
+ * their move arrives from wherever it comes from: the keyboard, a line of a
+ * pipe or a message for one of many games run by one thread
+ */
+typedef struct {
+    // the game board
+    char gameBoard[BOARD_COLUMNS][BOARD_ROWS];
+    // the characters, player numbers and computer flags of the player moving
+    // first (index 0) and the player moving second (index 1)
+    char playerChars[2];
+    int playerNumbers[2];
+    int computer[2];
+    // the gamemode, 'c' against the computer or 'p' against another player
+    char gameMode;
+    // the index of the side to move
+    int side;
+    // the number of pieces on the board
+    int turn;
+    // the seconds left on the clocks of player 1 and player 2, and the time the
+    // current move started
+    double clocks[2];
+    double moveStart;
+    // the columns played so far, kept for the game log
+    char moves[NUM_CELLS + 1];
+    int moveCount;
+    // the column index (0 - 6) of the last move
+    int lastColumn;
+    // GAME_WAITING or GAME_FINISHED
+    int status;
+    // the number of the winning player, 0 for a tie
+    int winner;
+    // 1 to print the boards and messages of the game as it is played
+    int show;
+} GameState;
+
+/*
+ * Purpose:
+ *      To set up a game so it is ready to be stepped
+ * Parameters:
+ *      game - the game to set up
+ *      gameBoard - the board the game starts from
+ *      userChar - the first players character
+ *      playerTwoChar - the second players/computers character
+ *      gameMode - the gamemode, in mode 'c' the computer is player 2 and moves first
+ *      turn - the number of pieces on the board
+ *      show - 1 to print the boards and messages of the game
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void initGame(GameState* game, const char gameBoard[numColumns][numRows], const char userChar, const char playerTwoChar, const char gameMode, const int turn, const int show) {
+    memset(game, 0, sizeof(GameState));
+    memcpy(game->gameBoard, gameBoard, sizeof(game->gameBoard));
+    game->gameMode = gameMode;
+    game->turn = turn;
+    game->show = show;
+    game->clocks[0] = clockBase;
+    game->clocks[1] = clockBase;
+    game->status = GAME_WAITING;
+    game->moveStart = monotonicSeconds();
+    // player 1 moves first against another player
+    game->playerChars[0] = userChar;
+    game->playerChars[1] = playerTwoChar;
+    game->playerNumbers[0] = 1;
+    game->playerNumbers[1] = 2;
+    if (gameMode == 'c') {
+        // the computer is player 2 however it always plays first
+        game->playerChars[0] = playerTwoChar;
+        game->playerChars[1] = userChar;
+        game->playerNumbers[0] = 2;
+        game->playerNumbers[1] = 1;
+        game->computer[0] = 1;
+    }
+}
+
+/*
+ * Purpose:
+ *      To finish a move whose piece is on the board: record it, charge the
+ *      clock of the player who made it and check if it ended the game
+ * Parameters:
+ *      game - the game
+ *      playColumn - the column index (0 - 6) the piece was played in
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The finished game is appended to the game log
+ */
+void finishMove(GameState* game, const int playColumn) {
+    // the player who moved and their opponent
+    int player = game->playerNumbers[game->side];
+    int opponent = game->playerNumbers[1 - game->side];
+
+    game->moves[game->moveCount++] = '1' + playColumn;
+    game->lastColumn = playColumn;
+    game->turn++;
+    if (game->show) {
+        showBoard(game->gameBoard, game->moves, game->playerChars[1 - game->side]);
+    }
+
+    // in a game with clocks the player loses if their time ran out
+    if ((clockBase > 0) && !chargeClock(&game->clocks[player - 1], game->moveStart)) {
+        if (game->show) {
+            printf("\nPlayer %d ran out of time.\n", player);
+            printWinMessage(opponent, game->gameMode);
+        }
+        game->winner = opponent;
+        game->status = GAME_FINISHED;
+    } else {
+        if ((clockBase > 0) && game->show && !quietMode) {
+            printClocks(game->clocks);
+        }
+        if (checkWinGame(game->gameBoard, game->playerChars[game->side])) {
+            if (game->show) {
+                printWinMessage(player, game->gameMode);
+            }
+            game->winner = player;
+            game->status = GAME_FINISHED;
+        // if the board is full the players tied
+        } else if (game->turn >= NUM_CELLS) {
+            if (game->show) {
+                printTieMessage();
+            }
+            game->winner = 0;
+            game->status = GAME_FINISHED;
+        }
+    }
+
+    if (game->status == GAME_FINISHED) {
+        // keep the finished game so it can be analysed later
+        appendGameLog(game->moves);
+    } else {
+        game->side = 1 - game->side;
+        game->moveStart = monotonicSeconds();
+    }
+}
+
+/*
+ * Purpose:
+ *      To run a game forward until a human player has to move or it is over,
+ *      playing every computer move on the way
+ * Parameters:
+ *      game - the game
+ * Returns:
+ *      GAME_WAITING when a human player has to give a move to submitMove,
+ *      GAME_FINISHED when the game is over
+ * Side-Effects:
+ *      NONE
+ */
+int stepGame(GameState* game) {
+    while ((game->status == GAME_WAITING) && game->computer[game->side]) {
+        // the column the computer played in
+        int playColumn = computerTurn(game->playerChars[game->side], game->gameBoard, game->playerChars[1 - game->side], game->turn, game->clocks[game->playerNumbers[game->side] - 1]);
+
+        // the opening moves can leave the computer without a move
+        if (playColumn == 8) {
+            playColumn = playRandomMove(game->gameBoard, game->playerChars[game->side]);
+        }
+        // 1 is added to the column because the gameboard indexes are 0 - 6 but
+        // the players play on a board with columns 1 - 7
+        if (game->show) {
+            printf("\nThe computer plays its piece in column %d\n", playColumn + 1);
+        }
+        finishMove(game, playColumn);
+    }
+
+    return game->status;
+}
+
+/*
+ * Purpose:
+ *      To give a game the move of the human player it is waiting for, then
+ *      run it on to the next human move
+ * Parameters:
+ *      game - the game, waiting for a human move
+ *      columnSlot - the column number (1 - 7) to play in
+ * Returns:
+ *      GAME_INVALID if the move can not be played, otherwise the status
+ *      from stepGame
+ * Side-Effects:
+ *      NONE
+ */
+int submitMove(GameState* game, const int columnSlot) {
+    if ((game->status != GAME_WAITING) || game->computer[game->side]) {
+        return GAME_INVALID;
+    }
+    if ((columnSlot < 1) || (columnSlot > numColumns) || (game->gameBoard[columnSlot - 1][numRows - 1] != 'O')) {
+        return GAME_INVALID;
+    }
+    placepiece(game->gameBoard, game->playerChars[game->side], columnSlot);
+    finishMove(game, columnSlot - 1);
+
+    return stepGame(game);
+}
+
+/*
+ * Purpose:
+ *      To play a game of user v user/computer connect 4
+ * Parameters:
+ *      gameBoard - the array of the gameboard
+ *      userChar - the first players character
+ *      playerTwoChar - the second players/computers character
+ *      gameMode - the gamemode 
+ *      turn - the turn the game is on
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The gameboard array is modified in functions called by this one
+ */
+void playGame(char gameBoard[numColumns][numRows], const char userChar, const char playerTwoChar, const char gameMode, int turn) {
+    // the game being played
+    GameState game;
+
+    initGame(&game, gameBoard, userChar, playerTwoChar, gameMode, turn, 1);
+    // the computer moves are played by the game itself, so only the moves of
+    // the live players have to be asked for until the game is over
+    while (stepGame(&game) == GAME_WAITING) {
+        submitMove(&game, askPlayerColumn(game.gameBoard, game.playerNumbers[game.side]));
+    }
+    memcpy(gameBoard, game.gameBoard, sizeof(game.gameBoard));
+}
+
+/*
+ * Purpose:
+ *      To print a message if the user wants to quit
+ * Parameters:
+ *      NONE
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printQuitMessage() {
+    printf("Thank you for playing connect four!\n");
+    printf("Have a nice day!!");
+}
+
+
+// the kinds of player in a calibration match: random moves, the pattern based
+// computer player, a search to a fixed depth and a search with a node budget
+#define PLAYER_RANDOM 0
+#define PLAYER_HEURISTIC 1
+#define PLAYER_DEPTH 2
+#define PLAYER_NODES 3
+// the most players in one calibration
+#define MAX_CALIBRATION_PLAYERS 32
+
+/*
+ * A player in a calibration, with the counters of its results
+ */
+typedef struct {
+    // the kind of player and its depth or node budget
+    int type;
+    long long budget;
+    // the name the player is shown with
+    char name[32];
+    // the time spent and the positions searched choosing moves, and the number of moves
+    uint64_t nanoseconds;
+    long long nodes;
+    long long moves;
+    // the rating found for the player
+    double elo;
+} CalibrationPlayer;
+
+/*
+ * One game of a calibration
+ */
+typedef struct {
+    // the players moving first and second
+    int first;
+    int second;
+    // the seed of the random opening and of the random players
+    uint64_t seed;
+    // the score of the first player: 2 for a win, 1 for a tie and 0 for a loss
+    int result;
+    // the time spent, positions searched and moves made by each player
+    uint64_t nanoseconds[2];
+    long long nodes[2];
+    long long moves[2];
+    // the columns played, from 1-7
+    char playedMoves[NUM_CELLS + 1];
+} CalibrationGame;
+
+/*
+ * The state shared by the threads of a calibration
+ */
+typedef struct {
+    // the players
+    CalibrationPlayer players[MAX_CALIBRATION_PLAYERS];
+    int playerCount;
+    // the games to play
+    CalibrationGame* games;
+    int gameCount;
+    // the index of the next game to play
+    atomic_int nextGame;
+    // the number of random moves each game starts with
+    int openingPlies;
+} Calibration;
+
+/*
+ * Purpose:
+ *      To search a position with iterative deepening until a node budget is used
+ *      up. A deeper search is only started if the nodes the last one used, grown
+ *      by the rate the searches have been growing, still fit in the budget, so
+ *      the result depends only on the budget and not on the speed of the machine.
+ * Parameters:
+ *      position - the position to search, it is restored before returning
+ *      budget - the number of positions the search may use
+ *      nodes - the number of positions searched is added to this
+ * Returns:
+ *      The best column index found, or -1 if the board is full
+ * Side-Effects:
+ *      NONE
+ */
+int searchNodeBudget(Position* position, const long long budget, long long* nodes) {
+    // the positions used so far and by the last depth
+    long long used = 0;
+    long long lastUsed = 0;
+    // the best column and score of the last depth
+    int bestColumn = -1;
+    int score = 0;
+    // the depth being searched
+    int depth = 1;
+
+    for (depth = 1; depth <= NUM_CELLS - position->moveCount; depth++) {
+        // the positions used by this depth
+        long long depthNodes = 0;
+        if ((depth > 1) && (used + 4 * lastUsed > budget)) {
+            break;
+        }
+        bestColumn = searchBestMove(position, depth, &score, &depthNodes);
+        used += depthNodes;
+        lastUsed = depthNodes;
+        if ((score > WIN_SCORE - NUM_CELLS) || (score < -WIN_SCORE + NUM_CELLS)) {
+            break;
+        }
+    }
+    *nodes += used;
+
+    return bestColumn;
+}
+
+/*
+ * Purpose:
+ *      To play a move for a calibration player. The pattern based player plays
+ *      on the game board array the way the interactive computer does, the other
+ *      players choose a column from the search position.
+ * Parameters:
+ *      player - the player to move
+ *      gameBoard - the game board array, kept the same as the position
+ *      position - the search position
+ *      playerChar - the character of the player to move
+ *      opponentChar - the character of the other player
+ *      random - the random number generator of the game
+ *      nodes - the number of positions searched is added to this
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The move is played on the game board array
+ */
+void playCalibrationMove(const CalibrationPlayer* player, char gameBoard[numColumns][numRows], Position* position, const char playerChar, const char opponentChar, RandomState* random, long long* nodes) {
+    // the column index chosen
+    int column = -1;
+
+    if (player->type == PLAYER_HEURISTIC) {
+        // the opening moves only apply when the computer moved first
+        column = 8;
+        if ((position->moveCount <= 2) && ((position->moveCount & 1) == 0)) {
+            column = playFirstTwoMoves(gameBoard, playerChar, opponentChar, 8, position->moveCount);
+        }
+        if (column == 8) {
+            column = playImmediateThreat(gameBoard, playerChar, opponentChar);
+        }
+        if (column == 8) {
+            column = playBestMove(gameBoard, playerChar, opponentChar);
+        }
+        if (column != 8) {
+            return;
+        }
+        column = -1;
+    } else if (player->type == PLAYER_DEPTH) {
+        // the score of the move, not needed
+        int score = 0;
+        column = searchBestMove(position, (int)player->budget, &score, nodes);
+    } else if (player->type == PLAYER_NODES) {
+        column = searchNodeBudget(position, player->budget, nodes);
+    }
+    // random players, and the pattern based player when none of its patterns
+    // match, play a random column that is not full
+    if ((column < 0) || (!canPlay(position, column))) {
+        column = randomColumn(random, position->occupied);
+    }
+    placepiece(gameBoard, playerChar, column + 1);
+}
+
+/*
+ * Purpose:
+ *      To play one calibration game
+ * Parameters:
+ *      calibration - the calibration
+ *      game - the game to play, its result and counters are filled in
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void playCalibrationGame(const Calibration* calibration, CalibrationGame* game) {
+    // the game board array used by the pattern based player and the search position
+    char gameBoard[numColumns][numRows];
+    Position position;
+    // the random number generator of the game
+    RandomState random;
+    // the characters of the two players
+    const char playerChars[2] = {'X', 'Y'};
+    // the pieces on the board before the last move
+    uint64_t occupied = 0;
+    // set when the last move won the game
+    int winGame = 0;
+
+    setGameBoard(gameBoard);
+    initPosition(&position);
+    seedRandom(&random, game->seed);
+    game->result = 1;
+    while ((position.moveCount < NUM_CELLS) && (!winGame)) {
+        // the player to move
+        int side = position.moveCount & 1;
+        // the time the move started
+        uint64_t start = profileClock();
+        // the column number the piece was played in
+        int column = 0;
+        if (position.moveCount < calibration->openingPlies) {
+            // the games start with random moves so they are not all the same
+            column = randomColumn(&random, position.occupied);
+            placepiece(gameBoard, playerChars[side], column + 1);
+        } else {
+            playCalibrationMove(&calibration->players[(side == 0) ? game->first : game->second], gameBoard, &position, playerChars[side], playerChars[side ^ 1], &random, &game->nodes[side]);
+            game->nanoseconds[side] += profileClock() - start;
+            game->moves[side]++;
+        }
+        column = findPlayedColumn(gameBoard, &occupied);
+        if (column == 0) {
+            // a player that does not add a piece to the board loses
+            game->result = (side == 0) ? 0 : 2;
+            break;
+        }
+        game->playedMoves[position.moveCount] = (char)('0' + column);
+        winGame = makeMove(&position, column - 1);
+        if (winGame) {
+            game->result = (side == 0) ? 2 : 0;
+        }
+    }
+    game->playedMoves[position.moveCount] = '\0';
+}
+
+/*
+ * Purpose:
+ *      To play calibration games until none are left
+ * Parameters:
+ *      argument - the Calibration
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      The results of the games are filled in
+ */
+void* runCalibrationWorker(void* argument) {
+    // the shared calibration state
+    Calibration* calibration = argument;
+    // the index of the game to play
+    int index = 0;
+
+    while ((index = atomic_fetch_add(&calibration->nextGame, 1)) < calibration->gameCount) {
+        playCalibrationGame(calibration, &calibration->games[index]);
+    }
+
+    return NULL;
+}
+
+// the deepest opening tree that can be collected
+#define MAX_OPENING_DEPTH 8
+// the number of games a thread claims at a time
+#define OPENING_GAME_BATCH 16
+
+/*
+ * The totals of the games that started with one opening sequence
+ */
+typedef struct {
+    // the number of games, and the number the first player won, tied and lost
+    long long games;
+    long long results[3];
+    // the time spent and positions searched by both players over those games
+    uint64_t nanoseconds;
+    long long nodes;
+} OpeningNode;
+
+/*
+ * The state shared by the threads of a self-play opening statistics run
+ */
+typedef struct {
+    // the player used for both sides and the number of random moves each game starts with
+    Calibration calibration;
+    // the number of plies of the opening tree
+    int depth;
+    // the number of games to play and the index of the next game to claim
+    long long gameCount;
+    atomic_llong nextGame;
+    // the seed of the games
+    uint64_t seed;
+} OpeningStatistics;
+
+/*
+ * One self-play thread and its own opening tree, so the threads never share a
+ * counter while playing and the trees are added together at the end
+ */
+typedef struct {
+    // the shared run state
+    OpeningStatistics* statistics;
+    // this threads tree, one node for every move sequence up to the tree depth
+    OpeningNode* nodes;
+} OpeningWorker;
+
+/*
+ * Purpose:
+ *      To get the number of opening tree nodes for the sequences shorter than a length
+ * Parameters:
+ *      length - the number of moves
+ * Returns:
+ *      The sum of 7^k for k below length, which is where the nodes of
+ *      sequences of that length start
+ * Side-Effects:
+ *      NONE
+ */
+size_t openingBase(const int length) {
+    // the number of nodes and the number of sequences of the current length
+    size_t base = 0;
+    size_t sequences = 1;
+    // the counter for the lengths
+    int i = 0;
+
+    for (i = 0; i < length; i++) {
+        base += sequences;
+        sequences *= BOARD_COLUMNS;
+    }
+
+    return base;
+}
+
+/*
+ * Purpose:
+ *      To read a player given as random, heuristic, depth:N or nodes:N
+ * Parameters:
+ *      text - the player
+ *      player - the player to fill in
+ * Returns:
+ *      1 if the player was read, otherwise 0
+ * Side-Effects:
+ *      player is overwritten
+ */
+int parsePlayer(const char* text, CalibrationPlayer* player) {
+    memset(player, 0, sizeof(CalibrationPlayer));
+    snprintf(player->name, sizeof(player->name), "%s", text);
+    if (strcmp(text, "random") == 0) {
+        player->type = PLAYER_RANDOM;
+    } else if (strcmp(text, "heuristic") == 0) {
+        player->type = PLAYER_HEURISTIC;
+    } else if (strncmp(text, "depth:", 6) == 0) {
+        player->type = PLAYER_DEPTH;
+        player->budget = atoll(text + 6);
+    } else if (strncmp(text, "nodes:", 6) == 0) {
+        player->type = PLAYER_NODES;
+        player->budget = atoll(text + 6);
+    } else {
+        return 0;
+    }
+
+    return (player->type < PLAYER_DEPTH) || (player->budget > 0);
+}
+
+/*
+ * Purpose:
+ *      To play self-play games until none are left and add each one to the
+ *      node of every opening sequence it started with
+ * Parameters:
+ *      argument - the OpeningWorker to run
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      The workers tree is updated
  */
-int threeInARow(char gameBoard[numColumns][numRows], const char computerChar, const char checkChar) {
-    // the counter for the row index
+void* runOpeningWorker(void* argument) {
+    // the worker being run
+    OpeningWorker* worker = argument;
+    // the shared run state
+    OpeningStatistics* statistics = worker->statistics;
+    // the first game of the batch claimed and the game being played
+    long long first = 0;
+    long long index = 0;
+
+    while ((first = atomic_fetch_add(&statistics->nextGame, OPENING_GAME_BATCH)) < statistics->gameCount) {
+        for (index = first; (index < first + OPENING_GAME_BATCH) && (index < statistics->gameCount); index++) {
+            // the game, played by the same player on both sides
+            CalibrationGame game;
+            // the node of the sequence played so far
+            size_t node = 0;
+            // the counter for the moves
+            int ply = 0;
+            memset(&game, 0, sizeof(game));
+            game.seed = statistics->seed + 0x9E3779B97F4A7C15ull * (uint64_t)(index + 1);
+            playCalibrationGame(&statistics->calibration, &game);
+            for (ply = 0; ply <= statistics->depth; ply++) {
+                OpeningNode* opening = &worker->nodes[openingBase(ply) + node];
+                opening->games++;
+                opening->results[2 - game.result]++;
+                opening->nanoseconds += game.nanoseconds[0] + game.nanoseconds[1];
+                opening->nodes += game.nodes[0] + game.nodes[1];
+                if (game.playedMoves[ply] == '\0') {
+                    break;
+                }
+                node = node * BOARD_COLUMNS + (game.playedMoves[ply] - '1');
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Purpose:
+ *      To print a node of the opening tree and every node below it with enough games
+ * Parameters:
+ *      nodes - the opening tree
+ *      depth - the number of plies of the tree
+ *      minGames - the fewest games a node must have to be printed
+ *      moves - the move sequence of the node, as columns from 1-7
+ *      node - the index of the node among the sequences of its length
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printOpeningTree(const OpeningNode* nodes, const int depth, const long long minGames, char* moves, const size_t node) {
+    // the number of moves in the sequence
+    int length = (int)strlen(moves);
+    // the totals of the node
+    const OpeningNode* opening = &nodes[openingBase(length) + node];
+    // the counter for the next moves
+    int column = 0;
+
+    if ((opening->games < minGames) || (opening->games == 0)) {
+        return;
+    }
+    printf("%*s%-*s games %8lld  first %5.1f%%  tie %5.1f%%  second %5.1f%%  ms/game %8.3f  nodes/game %10.0f\n", 2 * length, "", depth + 1 - length, (length > 0) ? moves : "-", opening->games, 100.0 * opening->results[0] / opening->games, 100.0 * opening->results[1] / opening->games, 100.0 * opening->results[2] / opening->games, opening->nanoseconds / 1e6 / opening->games, (double)opening->nodes / opening->games);
+    if (length < depth) {
+        for (column = 0; column < BOARD_COLUMNS; column++) {
+            moves[length] = (char)('1' + column);
+            moves[length + 1] = '\0';
+            printOpeningTree(nodes, depth, minGames, moves, node * BOARD_COLUMNS + column);
+        }
+        moves[length] = '\0';
+    }
+}
+
+/*
+ * Purpose:
+ *      To rate the players of a calibration from their results with the
+ *      Bradley-Terry model, fitted by minorisation-maximisation. A tie counts as
+ *      half a win for each player, and each pair that played gets one extra
+ *      tie so a player that never scored still gets a finite rating.
+ * Parameters:
+ *      calibration - the calibration with its games played
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      The rating of each player is set, with the first player at 0 Elo
+ */
+void ratePlayers(Calibration* calibration) {
+    // the number of games and the points (in halves) between each pair of players
+    static double played[MAX_CALIBRATION_PLAYERS][MAX_CALIBRATION_PLAYERS];
+    static double points[MAX_CALIBRATION_PLAYERS][MAX_CALIBRATION_PLAYERS];
+    // the strength of each player and the next estimate
+    double strength[MAX_CALIBRATION_PLAYERS];
+    double next[MAX_CALIBRATION_PLAYERS];
+    // the number of players
+    int count = calibration->playerCount;
+    // counters for the games, players and iterations
+    int g = 0;
     int i = 0;
-    // the counter for the column index
     int j = 0;
-    // a default value for the play column that is not a valid column so if 
-    // this function does not find a way for the computer to win, the computer turn
-    // function will move on to the next function to try to find a good move for the 
-    // computer to play
-    int playColumn = 8;
-    
-    // this loop will iterate through the entire array, column by column, row by row,
-    // to check if the computer can get 4 in a row to win, or if it can prevent the 
-    // player from getting four in a row.
-    while (i < numRows){
-        // iterate across each column to find the player/computer pieces (the character representing them)
-        for (j = 0; j < numColumns; j++) {
-            // if the loop gets to a character that is the users/opponent, check if
-            // it can win vertically, horizontally, or diagonally
-            if (gameBoard[j][i] == checkChar) {
-            // for the following a space is defined as available if the slot
-            // below it is the bottom of the board or either the player or opponents piece
-                
-            // for each of the following, constraints are put on the j and i counter
-            // to make sure the piece can be played within the gameboard to win
-            // or prevent the opponent from winning
-                
-                // the two pieces directly above the players piece are also the players 
-                // piece and the space above that is available for a piece to be played in
-                if ((gameBoard[j][i + 1] == checkChar) && (gameBoard[j][i + 2] == checkChar) && (gameBoard[j][i + 3] == 'O') && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j][i + 3] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j;
-                    break;
-                    
-                // the two pieces to the right of the players piece are also the players
-                // piece and the third space to the right is available for a piece to be played in
-                } else if ( ((gameBoard[j + 1][i] == checkChar) && (gameBoard[j + 2][i] == checkChar)) && (gameBoard[j + 3][i] == 'O') && ((gameBoard[j + 3][i - 1] != 'O') || (i == 0)) && (j < 5)) {
-                    // play winning/defending piece
-                    gameBoard[j + 3][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 3;
-                    break;
-                    
-                // the two pieces to the right of the players piece are also the players
-                // piece and the first space to the left is available for a piece to be played in
-                } else if (((gameBoard[j + 1][i] == checkChar) && (gameBoard[j + 2][i] == checkChar)) && (gameBoard[j - 1][i] == 'O') && ((gameBoard[j - 1][i - 1] != 'O') || (i == 0)) && (j > 0)) {
-                    // play winning/defending piece
-                    gameBoard[j - 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    break;
-                    
-                // the second and third piece to the right of the players piece are also the players
-                // piece and the first space to the right is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i] == 'O') && (gameBoard[j + 2][i] == checkChar) && (gameBoard[j + 3][i] == checkChar) && ((gameBoard[j + 1][i - 1] != 'O') || (i == 0)) && (j < 5)) {
-                    // play winning/defending piece
-                    gameBoard[j + 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    break;
-                    
-                // the first and third piece to the right of the players piece are also the players
-                // piece and the second space to the right is available for a piece to be played in
-                } else if ((gameBoard[j + 2][i] == 'O') && (gameBoard[j + 1][i] == checkChar) && (gameBoard[j + 3][i] == checkChar) && ((gameBoard[j + 2][i - 1] != 'O') || (i == 0)) && (j < 5)) {
-                    // play winning/defending piece
-                    gameBoard[j + 2][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 2;
-                    break;
-                    
-                // the two pieces diagonally upward to the right of the players piece are also the players
-                // piece and the third space diagonally upward to the right is available for a piece to be played in
-                } else if (((gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j + 2][i + 2] == checkChar)) && (gameBoard[j + 3][i + 3] == 'O') && (gameBoard[j + 3][i + 2] != 'O') && (j < 4) && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j + 3][i + 3] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 3;
-                    break;
-                    
-                // the two pieces diagonally upward to the right of the players piece are also the players
-                // piece and the first space diagonally downward to the left is available for a piece to be played in
-                } else if ( ((gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j + 2][i + 2] == checkChar)) && (gameBoard[j - 1][i - 1] == 'O') && ((gameBoard[j - 1][i - 2] != 'O') || (i == 1)) && (j > 0) && (j < 5) && (i < 4) && (i > 0)) {
-                    // play winning/defending piece
-                    gameBoard[j - 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    break;
-                    
-                // the second and third pieces diagonally upward to the right of the players piece are also the players
-                // piece and the first space diagonally upward to the right is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i + 1] == 'O') && (gameBoard[j + 2][i + 2] == checkChar) && (gameBoard[j + 3][i + 3] == checkChar) && (gameBoard[j + 1][i] != 'O') && (j < 4) && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j + 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    break;
-                    
-                // the first and third pieces diagonally upward to the right of the players piece are also the players
-                // piece and the second space diagonally upward to the right is available for a piece to be played in
-                } else if ((gameBoard[j + 2][i + 2] == 'O') && (gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j + 3][i + 3] == checkChar) && (gameBoard[j + 2][i + 1] != 'O') && (j < 4) && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j + 2][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 2;
-                    break;
-                    
-                // the two pieces diagonally upward to the left of the players piece are also the players
-                // piece and the third space diagonally upward to the left is available for a piece to be played in
-                } else if (((gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j - 2][i + 2] == checkChar)) && (gameBoard[j - 3][i + 3] == 'O') && (gameBoard[j - 3][i + 2] != 'O') && (j > 2) && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j - 3][i + 3] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 3;
-                    break;
-                    
-                // the two pieces diagonally upward to the left of the players piece are also the players
-                // piece and the first space diagonally downward to the right is available for a piece to be played in
-                } else if (((gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j - 2][i + 2] == checkChar)) && (gameBoard[j + 1][i - 1] == 'O') && ((gameBoard[j + 1][i - 2] != 'O') || (i == 1)) && (j > 1) && (j < 6) && (i > 0) && (i < 4)) {
-                    // play winning/defending piece
-                    gameBoard[j + 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    break;
-                    
-                // the second and third pieces diagonally upward to the left of the players piece are also the players
-                // piece and the first space diagonally upward to the left is available for a piece to be played in
-                } else if ((gameBoard[j - 1][i + 1] == 'O') && (gameBoard[j - 2][i + 2] == checkChar) && (gameBoard[j - 3][i + 3] == checkChar) && (gameBoard[j - 1][i] != 'O') && (j > 2) && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j - 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    break;
-                    
-                // the first and third pieces diagonally upward to the left of the players piece are also the players
-                // piece and the second space diagonally upward to the left is available for a piece to be played in
-                } else if ((gameBoard[j - 2][i + 2] == 'O') && (gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j - 3][i + 3] == checkChar) && (gameBoard[j - 2][i + 1] != 'O') && (j > 2) && (i < 3)) {
-                    // play winning/defending piece
-                    gameBoard[j - 2][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 2;
-                    break;
+    int iteration = 0;
+
+    memset(played, 0, sizeof(played));
+    memset(points, 0, sizeof(points));
+    for (g = 0; g < calibration->gameCount; g++) {
+        CalibrationGame* game = &calibration->games[g];
+        played[game->first][game->second] += 1;
+        played[game->second][game->first] += 1;
+        points[game->first][game->second] += game->result / 2.0;
+        points[game->second][game->first] += (2 - game->result) / 2.0;
+    }
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < count; j++) {
+            if (played[i][j] > 0) {
+                played[i][j] += 1;
+                points[i][j] += 0.5;
+            }
+        }
+        strength[i] = 1;
+    }
+    for (iteration = 0; iteration < 1000; iteration++) {
+        for (i = 0; i < count; i++) {
+            // the points of the player and the sum of its games over the strengths
+            double wins = 0;
+            double total = 0;
+            for (j = 0; j < count; j++) {
+                if (played[i][j] > 0) {
+                    wins += points[i][j];
+                    total += played[i][j] / (strength[i] + strength[j]);
                 }
             }
+            next[i] = (total > 0) ? wins / total : strength[i];
         }
-        // the playColumn is not the default value, break from the while loop
-        // because the computer has made a move.
-        if (playColumn != 8) {
-            break;
-        // the computer has not made a move so increment the row index counter
-        // by 1 and continue checking if the computer can play a move to win or
-        // prevent the other player from winning.
-        } else {
-            i++;
+        for (i = 0; i < count; i++) {
+            strength[i] = next[i] / next[0];
+        }
+    }
+    for (i = 0; i < count; i++) {
+        calibration->players[i].elo = 400 * log10(strength[i]);
+    }
+}
+
+/*
+ * Purpose:
+ *      To find the value given for a command line option such as --threads 4
+ * Parameters:
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments
+ *      name - the name of the option including the dashes
+ *      defaultValue - the value to use if the option is not given
+ * Returns:
+ *      The argument after the option name, or defaultValue
+ * Side-Effects:
+ *      NONE
+ */
+const char* findOption(int argc, char** argv, const char* name, const char* defaultValue) {
+    // the counter for the arguments
+    int i = 0;
+
+    for (i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+
+    return defaultValue;
+}
+
+/*
+ * Purpose:
+ *      To check if a command line flag such as --selfplay was given
+ * Parameters:
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments
+ *      name - the name of the flag including the dashes
+ * Returns:
+ *      1 if the flag was given, otherwise 0
+ * Side-Effects:
+ *      NONE
+ */
+int hasFlag(int argc, char** argv, const char* name) {
+    // the counter for the arguments
+    int i = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Purpose:
+ *      To print the command line modes the program can be run in
+ * Parameters:
+ *      programName - the name the program was run with
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printUsage(const char* programName) {
+    printf("Usage:\n");
+    printf("  %s\n", programName);
+    printf("      play an interactive game\n");
+    printf("  %s search <depth> [moves]\n", programName);
+    printf("      search a position to a fixed depth and print the best move\n");
+    printf("  %s solve <megabytes> [moves]\n", programName);
+    printf("      find the exact score and principal variation with a transposition table of the given size\n");
+    printf("  %s prove <megabytes> [moves]\n", programName);
+    printf("      prove or disprove a forced win for the player to move\n");
+    printf("  %s enumerate <megabytes> <ply> [threads] [moves]\n", programName);
+    printf("      count the unique positions at every ply up to ply using every core by default\n");
+    printf("  %s generate <output> <count> [--threads N] [--seed S] [--selfplay]\n", programName);
+    printf("           [--min-ply P] [--max-ply P] [--megabytes M] [--node-limit N] [--max-skipped N]\n");
+    printf("      write solved training positions as %d byte records: the bitboards of the\n", TRAINING_RECORD_SIZE);
+    printf("      player to move and of every piece, the score, best column, moves played and flags,\n");
+    printf("      stopping after max-skipped positions, 10 per record by default, are too hard to solve\n");
+    printf("  %s evaluate [moves]\n", programName);
+    printf("      print the static evaluation of a position and how long it takes\n");
+    printf("  %s network-init <output>\n", programName);
+    printf("      write an n-tuple network weight file equal to the built in line evaluation\n");
+    printf("  %s book-build <output> <maxPly> [moves] [--min-ply P] [--threads N] [--megabytes M]\n", programName);
+    printf("      solve every position from min-ply to maxPly moves into a compressed opening book\n");
+    printf("  %s book-query <book> [moves]\n", programName);
+    printf("      print the book scores of a position and of every move from it\n");
+    printf("  %s analyze <log|-> [--output F] [--threads N] [--megabytes M] [--node-limit N]\n", programName);
+    printf("      solve every position of each game in a log, one game of moves per line, and\n");
+    printf("      report the blunders that lose a won or tied game and the missed wins\n");
+    printf("  %s engine [--megabytes M]\n", programName);
+    printf("      run the line based engine protocol on stdin and stdout for GUIs and tournament\n");
+    printf("      managers: isready, newgame, position [startpos] [moves M], go [depth D]\n");
+    printf("      [movetime T] [wtime T btime T winc T binc T] [solve [nodes N]], stop, quit\n");
+    printf("  %s multipv [moves] [--best K] [--depth D] [--megabytes M]\n", programName);
+    printf("      rank every legal column with the exact score and principal variation of the\n");
+    printf("      best K, or with searched scores if a depth is given\n");
+    printf("  %s calibrate [--budgets N,N,...] [--games G] [--threads T] [--seed S] [--opening-plies P]\n", programName);
+    printf("      rate the search at each node budget against random moves, the pattern based\n");
+    printf("      computer and fixed depth searches, and print the cheapest budget for each strength\n");
+    printf("  %s sessions <count> [--moves M] [--seed S]\n", programName);
+    printf("      hold count games as 16 byte packed sessions, play random moves in them and\n");
+    printf("      print the memory used and the time to unpack and pack a session\n");
+    printf("  %s db-add <database> <log|->\n", programName);
+    printf("      add the games of a game log to a game database, creating it if needed, and\n");
+    printf("      index the positions of their first 16 plies\n");
+    printf("  %s db-query <database> [moves] [--limit N]\n", programName);
+    printf("      print how the stored games that reached a position ended and list N of them\n");
+    printf("  %s openings [--player P] [--games G] [--random-plies R] [--depth D] [--min-games M] [--threads T] [--seed S]\n", programName);
+    printf("      play a player against itself from R random moves and print the results and cost\n");
+    printf("      of every opening up to D plies. P is heuristic (the default), random, depth:N or nodes:N\n");
+    printf("  %s multiplex [--games N]\n", programName);
+    printf("      play up to N games on one thread, driven by lines on standard input:\n");
+    printf("      new <id> [computer|human], move <id> <column> and quit. Waiting games are\n");
+    printf("      held packed in %d bytes each\n", (int)sizeof(HostedGame));
+    printf("  %s wide-games <columns> <rows> <connect> <depth>\n", programName);
+    printf("      count and time the games of depth moves on a board of any size up to 16x15.\n");
+    printf("      A board that fits in one word is timed again spread over two words, and the\n");
+    printf("      standard board against the fixed size bitboards. Boards of other sizes only\n");
+    printf("      support move generation, win detection and game counts, not play or search\n");
+    printf("Options:\n");
+    printf("  --network <file>  evaluate with an n-tuple network weight file instead of the line counts\n");
+    printf("  --book <file>     take the exact scores of early positions from an opening book\n");
+    printf("  --time <seconds>  give each player a clock in an interactive game, the computer\n");
+    printf("                    searches for as long as its clock allows\n");
+    printf("  --increment <seconds>  the time added to a players clock after each move\n");
+    printf("  --log <file>      append the moves of every interactive game to a game log\n");
+    printf("  --board <style>   show the board after each move as a grid (the default), as the\n");
+    printf("                    moves played or as a one line FEN like string: grid, moves or fen\n");
+    printf("  --quiet           do not show the board, clocks or search progress\n");
+    printf("  --profile         time each stage of the computers move choice and print the counts\n");
+    printf("                    and latency histograms on exit, or after a move when sent SIGUSR1\n");
+    printf("  --seed <number>   seed the computers random moves so a game can be repeated\n");
+    printf("  --checkpoint <file>  save the progress of solve and book-build to a file and carry\n");
+    printf("                    on from it when run again, SIGTERM or SIGINT save it and stop\n");
+    printf("  --checkpoint-interval <seconds>  the time between checkpoints, 300 by default\n");
+    printf("  --memory <megabytes>  the most memory the caches and tables may use together: the\n");
+    printf("                    transposition tables, proof trees, enumeration hash sets, books\n");
+    printf("                    being built, database indexing, opening trees and the games held\n");
+    printf("                    by calibrate, sessions and multiplex. Tables are shrunk to fit\n");
+    printf("                    where they can and refused where they can not\n");
+    printf("  --memory-stats    print the memory used now and at its peak by each table on exit\n");
+    printf("Moves are given as a string of columns from 1-7, e.g. 4453\n");
+}
+
+/*
+ * Purpose:
+ *      To search a position given as a move string to a fixed depth and print the result
+ * Parameters:
+ *      depth - the number of moves to search
+ *      moves - the columns played to reach the position
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the moves are invalid
+ * Side-Effects:
+ *      NONE
+ */
+int runSearchCommand(const int depth, const char* moves) {
+    // the position being searched
+    Position position;
+    // the number of positions searched
+    long long nodes = 0;
+    // the score of the best move
+    int score = 0;
+    // the best column index found
+    int column = 0;
+
+    initPosition(&position);
+    if (playMoveString(&position, moves) < 0) {
+        printf("Invalid move string '%s'\n", moves);
+        return EXIT_FAILURE;
+    }
+    column = searchBestMove(&position, depth, &score, &nodes);
+    if (column < 0) {
+        printf("The board is full\n");
+        return EXIT_FAILURE;
+    }
+    printf("bestmove %d score %d nodes %lld\n", column + 1, score, nodes);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To prove or disprove a forced win for the player to move in a position
+ *      given as a move string and print the result
+ * Parameters:
+ *      megabytes - the most memory the proof tree may use
+ *      moves - the columns played to reach the position
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the moves are invalid
+ * Side-Effects:
+ *      NONE
+ */
+int runProveCommand(const int megabytes, const char* moves) {
+    // the position being searched
+    Position position;
+    // the number of tree nodes created
+    long long nodes = 0;
+    // the column that wins if a win is proven
+    int column = -1;
+    // the result of the search
+    int result = 0;
+    // the time the search started
+    double start = monotonicSeconds();
+
+    initPosition(&position);
+    if ((playMoveString(&position, moves) < 0) || (megabytes <= 0)) {
+        printf("Invalid arguments '%d' '%s'\n", megabytes, moves);
+        return EXIT_FAILURE;
+    }
+    result = proveWin(&position, (size_t)megabytes << 20, &column, &nodes);
+    if (result == 1) {
+        printf("win bestmove %d", column + 1);
+    } else if (result == 0) {
+        printf("nowin");
+    } else {
+        printf("unknown (memory limit reached)");
+    }
+    printf(" nodes %lld time %.3f\n", nodes, monotonicSeconds() - start);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To print a line of moves as columns from 1-7
+ * Parameters:
+ *      variation - the column indexes of the line, ending with -1
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      NONE
+ */
+void printVariation(const int* variation) {
+    // the counter for the moves in the line
+    int i = 0;
+
+    for (i = 0; variation[i] >= 0; i++) {
+        printf("%d", variation[i] + 1);
+    }
+}
+
+/*
+ * Purpose:
+ *      To find the exact score of a position given as a move string and print
+ *      the score, the distance to the end of the game and the principal variation
+ * Parameters:
+ *      megabytes - the size of the transposition table
+ *      moves - the columns played to reach the position
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the moves are invalid or the game is over
+ * Side-Effects:
+ *      NONE
+ */
+int runSolveCommand(const int megabytes, const char* moves) {
+    // the position being solved
+    Position position;
+    // the position in the form the solver uses
+    SolverBoard board;
+    // the exact solver
+    Solver solver;
+    // the principal variation
+    int variation[NUM_CELLS + 1];
+    // the exact score
+    int score = 0;
+    // the time the solve started
+    double start = 0;
+    // set to 1 if the solve was resumed from a checkpoint, -1 if the checkpoint is for another solve
+    int resumed = 0;
+
+    initPosition(&position);
+    if ((playMoveString(&position, moves) < 0) || (position.moveCount == NUM_CELLS) || (checkPositionWon(&position))) {
+        printf("Invalid or finished position '%s'\n", moves);
+        return EXIT_FAILURE;
+    }
+    if ((megabytes <= 0) || (!initSolver(&solver, megabytes))) {
+        printf("Could not allocate a %d MB transposition table\n", megabytes);
+        return EXIT_FAILURE;
+    }
+    loadSolverBoard(&board, &position);
+    // save the table every checkpointInterval seconds and carry on from the
+    // last table saved
+    if (checkpointName != NULL) {
+        solver.checkpointing = 1;
+        solver.rootKey = solverKey(&board);
+        solver.rootLowest = -NUM_CELLS;
+        solver.rootHighest = NUM_CELLS;
+        solver.nextCheckpoint = monotonicSeconds() + checkpointInterval;
+        resumed = readSolverCheckpoint(&solver);
+        if (resumed < 0) {
+            printf("The checkpoint '%s' is not for this position and table size\n", checkpointName);
+            freeSolver(&solver);
+            return EXIT_FAILURE;
+        }
+        if (resumed > 0) {
+            fprintf(stderr, "resumed from '%s' after %lld nodes\n", checkpointName, solver.nodes);
+        }
+    }
+    start = monotonicSeconds();
+    catchCheckpointSignals(1);
+    score = solveBoard(&solver, &board);
+    catchCheckpointSignals(0);
+    if (solver.aborted) {
+        printf("Stopped, the checkpoint was saved to '%s'\n", checkpointName);
+        freeSolver(&solver);
+        return EXIT_FAILURE;
+    }
+    // the solved position replaces the checkpoint
+    if (checkpointName != NULL) {
+        remove(checkpointName);
+    }
+    solver.checkpointing = 0;
+    solvePrincipalVariation(&solver, &board, score, variation, NUM_CELLS + 1);
+    printf("score %d distance %d pv ", score, scoreToDistance(score, board.moveCount));
+    printVariation(variation);
+    printf(" nodes %lld time %.3f\n", solver.nodes, monotonicSeconds() - start);
+    freeSolver(&solver);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To count the unique positions at every ply reachable from a position given
+ *      as a move string and print the counts
+ * Parameters:
+ *      megabytes - the size of the hash set used to remove transpositions
+ *      targetPly - the last ply to count
+ *      threadCount - the number of worker threads, or 0 to use every core
+ *      moves - the columns played to reach the starting position
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid or the hash set is too small
+ * Side-Effects:
+ *      NONE
+ */
+int runEnumerateCommand(const int megabytes, const int targetPly, int threadCount, const char* moves) {
+    // the starting position
+    Position position;
+    // the starting position in the form the enumeration uses
+    SolverBoard board;
+    // the number of unique positions at each ply
+    long long counts[NUM_CELLS + 1];
+    // the total number of unique positions
+    long long total = 0;
+    // the megabytes the memory budget gave the hash set, which may be less than asked for
+    int reserved = 0;
+    // the counter for the plies
+    int ply = 0;
+    // the time the enumeration started and how long it took
+    double start = 0;
+    double seconds = 0;
+
+    initPosition(&position);
+    if ((playMoveString(&position, moves) < 0) || (megabytes <= 0) || (targetPly < position.moveCount) || (targetPly > NUM_CELLS)) {
+        printf("Invalid arguments\n");
+        return EXIT_FAILURE;
+    }
+    if (threadCount <= 0) {
+        threadCount = countCores();
+    }
+    loadSolverBoard(&board, &position);
+    start = monotonicSeconds();
+    if (!enumeratePositions(&board, targetPly, megabytes, &reserved, threadCount, counts, NULL, NULL)) {
+        printf("The %d MB hash set is too small for ply %d\n", reserved, targetPly);
+        return EXIT_FAILURE;
+    }
+    seconds = monotonicSeconds() - start;
+    for (ply = position.moveCount; ply <= targetPly; ply++) {
+        printf("ply %d positions %lld\n", ply, counts[ply]);
+        total += counts[ply];
+    }
+    printf("total %lld threads %d time %.3f rate %.0f positions/s\n", total, threadCount, seconds, total / ((seconds > 0) ? seconds : 1e-9));
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To generate labelled training positions on every core and write them to a
+ *      binary file of fixed width records, reporting the rate as it goes
+ * Parameters:
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: generate <output> <count> followed by options
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid, the file cannot be
+ *      opened or too many positions were too hard to solve
+ * Side-Effects:
+ *      The output file is written
+ */
+int runGenerateCommand(int argc, char** argv) {
+    // the shared generator state
+    TrainingGenerator generator;
+    // the generator threads
+    TrainingWorker* workers = NULL;
+    // the number of threads
+    int threadCount = atoi(findOption(argc, argv, "--threads", "0"));
+    // the counter for the threads
+    int i = 0;
+    // the time generation started and the time taken so far
+    double start = 0;
+    double seconds = 0;
+    // the number of records written
+    long long written = 0;
+
+    memset(&generator, 0, sizeof(generator));
+    generator.target = atoll(argv[3]);
+    generator.selfPlay = hasFlag(argc, argv, "--selfplay");
+    generator.minPly = atoi(findOption(argc, argv, "--min-ply", "12"));
+    generator.maxPly = atoi(findOption(argc, argv, "--max-ply", "36"));
+    generator.megabytes = atoi(findOption(argc, argv, "--megabytes", "16"));
+    generator.nodeLimit = atoll(findOption(argc, argv, "--node-limit", "2000000"));
+    generator.seed = strtoull(findOption(argc, argv, "--seed", "1"), NULL, 10);
+    generator.skipLimit = atoll(findOption(argc, argv, "--max-skipped", "0"));
+    if (generator.skipLimit <= 0) {
+        generator.skipLimit = 10 * generator.target + 1000;
+    }
+    if ((generator.target <= 0) || (generator.minPly < 0) || (generator.maxPly < generator.minPly) || (generator.maxPly >= NUM_CELLS) || (generator.megabytes <= 0)) {
+        printf("Invalid arguments\n");
+        return EXIT_FAILURE;
+    }
+    generator.output = fopen(argv[2], "wb");
+    if (generator.output == NULL) {
+        printf("Could not open '%s'\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    if (threadCount <= 0) {
+        threadCount = countCores();
+    }
+    workers = calloc(threadCount, sizeof(TrainingWorker));
+    if (workers == NULL) {
+        printf("Could not allocate %d generator threads\n", threadCount);
+        fclose(generator.output);
+        return EXIT_FAILURE;
+    }
+    pthread_mutex_init(&generator.outputLock, NULL);
+    start = monotonicSeconds();
+    for (i = 0; i < threadCount; i++) {
+        workers[i].generator = &generator;
+        workers[i].id = i;
+        pthread_create(&workers[i].thread, NULL, runTrainingWorker, &workers[i]);
+    }
+    // report progress every second until every thread has finished
+    while (atomic_load(&generator.finishedThreads) < threadCount) {
+        sleep(1);
+        // the number of positions labelled so far, some may still be waiting in a batch
+        long long labelled = atomic_load(&generator.results[0]) + atomic_load(&generator.results[1]) + atomic_load(&generator.results[2]);
+        seconds = monotonicSeconds() - start;
+        fprintf(stderr, "labelled %lld skipped %lld rate %.1f positions/s\n", labelled, (long long)atomic_load(&generator.skipped), labelled / seconds);
+    }
+    for (i = 0; i < threadCount; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    seconds = monotonicSeconds() - start;
+    fclose(generator.output);
+    pthread_mutex_destroy(&generator.outputLock);
+    free(workers);
+
+    written = atomic_load(&generator.written);
+    printf("positions %lld bytes %lld threads %d time %.3f rate %.1f positions/s\n", written, written * TRAINING_RECORD_SIZE, threadCount, seconds, written / seconds);
+    // every written label is an exact solve, the skipped positions show how
+    // often the node limit was too small for the chosen plies
+    printf("exact labels %lld skipped %lld (%.1f%%) nodes per label %.0f\n", written, (long long)atomic_load(&generator.skipped), 100.0 * atomic_load(&generator.skipped) / (written + atomic_load(&generator.skipped)), (double)atomic_load(&generator.nodes) / ((written > 0) ? written : 1));
+    printf("wins %lld ties %lld losses %lld for the player to move\n", (long long)atomic_load(&generator.results[2]), (long long)atomic_load(&generator.results[1]), (long long)atomic_load(&generator.results[0]));
+    if (written < generator.target) {
+        printf("Stopped after %lld positions were skipped, use a larger --node-limit or later plies\n", (long long)atomic_load(&generator.skipped));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To print the static evaluations of a position given as a move string and
+ *      time how long the evaluation the search uses takes
+ * Parameters:
+ *      moves - the columns played to reach the position
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the moves are invalid
+ * Side-Effects:
+ *      NONE
+ */
+int runEvaluateCommand(const char* moves) {
+    // the position being evaluated
+    Position position;
+    // the number of times the evaluation is timed
+    const int repeats = 10000000;
+    // the sum of the evaluations, printed so the timing loop is not optimized away
+    long long sum = 0;
+    // the counter for the timing loop
+    int i = 0;
+    // the move count of the position, restored after the timing loop
+    int moveCount = 0;
+    // the time the timing loop started and how long it took
+    double start = 0;
+    double seconds = 0;
+
+    initPosition(&position);
+    if (playMoveString(&position, moves) < 0) {
+        printf("Invalid move string '%s'\n", moves);
+        return EXIT_FAILURE;
+    }
+    printf("lines %d", evaluatePosition(&position));
+    if (activeNetwork != NULL) {
+        printf(" network %d", evaluateNetwork(&position));
+    }
+    moveCount = position.moveCount;
+    start = monotonicSeconds();
+    for (i = 0; i < repeats; i++) {
+        // flip the side to move each time, which both evaluations read, so the
+        // compiler cannot reuse the result of the previous call, and weight the
+        // two sides differently so their evaluations do not cancel in the checksum
+        position.moveCount ^= 1;
+        sum += staticEvaluation(&position) * ((i & 1) + 1);
+    }
+    seconds = monotonicSeconds() - start;
+    position.moveCount = moveCount;
+    printf(" time %.1f ns per evaluation (checksum %lld)\n", seconds * 1e9 / repeats, sum);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To build an opening book of every position reachable from a starting
+ *      position with between min-ply and maxPly moves played
+ * Parameters:
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: book-build <output> <maxPly> [moves] and options
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid or the book could not be built
+ * Side-Effects:
+ *      The book file is written and progress is printed to stderr
+ */
+int runBookBuildCommand(int argc, char** argv) {
+    // the book being built, held in memory
+    OpeningBook book;
+    // the starting position
+    Position position;
+    SolverBoard board;
+    // the moves to the starting position
+    const char* moves = ((argc >= 5) && (argv[4][0] != '-')) ? argv[4] : "";
+    // the number of threads and the memory for each solver and the enumeration
+    int threadCount = atoi(findOption(argc, argv, "--threads", "0"));
+    int megabytes = atoi(findOption(argc, argv, "--megabytes", "64"));
+    // the number of solver nodes and the size of the book file
+    long long nodes = 0;
+    long long bytes = 0;
+    // set to 1 if the build was resumed from a checkpoint, -1 if the checkpoint is for another book
+    int resumed = 0;
+    // the number of positions already solved and the counter for the positions
+    size_t solved = 0;
+    size_t i = 0;
+    // the time the build started
+    double start = monotonicSeconds();
+
+    memset(&book, 0, sizeof(book));
+    book.file = -1;
+    book.maxPly = atoi(argv[3]);
+    initPosition(&position);
+    if (playMoveString(&position, moves) < 0) {
+        printf("Invalid move string '%s'\n", moves);
+        return EXIT_FAILURE;
+    }
+    book.minPly = atoi(findOption(argc, argv, "--min-ply", "0"));
+    if (book.minPly < position.moveCount) {
+        book.minPly = position.moveCount;
+    }
+    if ((book.maxPly < book.minPly) || (book.maxPly >= NUM_CELLS) || (megabytes <= 0)) {
+        printf("Invalid arguments\n");
+        return EXIT_FAILURE;
+    }
+    if (threadCount <= 0) {
+        threadCount = countCores();
+    }
+    // the solver must not read the book file being replaced
+    activeBook = NULL;
+    loadSolverBoard(&board, &position);
+    // a checkpoint of this build holds its positions, so they are only
+    // collected when there is none
+    if (checkpointName != NULL) {
+        resumed = readBookCheckpoint(&book, solverKey(&board));
+    }
+    if (resumed < 0) {
+        printf("The checkpoint '%s' is not for this book\n", checkpointName);
+        return EXIT_FAILURE;
+    }
+    if ((resumed == 0) && (!collectBookPositions(&board, &book, threadCount, megabytes * threadCount))) {
+        printf("The hash set is too small to enumerate ply %d, use more --megabytes\n", book.maxPly);
+        free(book.keys);
+        free(book.scores);
+        releaseMemory(MEMORY_BOOK, book.memoryBytes);
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < book.count; i++) {
+        solved += (book.scores[i] != BOOK_UNSOLVED);
+    }
+    fprintf(stderr, "%zu positions to solve from ply %d to %d, %zu already solved\n", book.count, book.minPly, book.maxPly, solved);
+    catchCheckpointSignals(1);
+    nodes = solveBookPositions(&book, solverKey(&board), threadCount, megabytes);
+    catchCheckpointSignals(0);
+    if (nodes == BOOK_BUILD_FAILED) {
+        printf("Could not solve every position, the book was not written\n");
+    } else if (nodes < 0) {
+        printf("Stopped, the checkpoint was saved to '%s'\n", checkpointName);
+    }
+    if (nodes < 0) {
+        free(book.keys);
+        free(book.scores);
+        releaseMemory(MEMORY_BOOK, book.memoryBytes);
+        return EXIT_FAILURE;
+    }
+    // a book with holes would be read as if the holes were scores
+    for (i = 0; (i < book.count) && (nodes >= 0); i++) {
+        if (book.scores[i] == BOOK_UNSOLVED) {
+            printf("Position %zu of the book was not solved, the book was not written\n", i);
+            nodes = BOOK_BUILD_FAILED;
+        }
+    }
+    bytes = (nodes >= 0) ? writeBookFile(&book, argv[2]) : 0;
+    free(book.keys);
+    free(book.scores);
+    releaseMemory(MEMORY_BOOK, book.memoryBytes);
+    if (nodes < 0) {
+        return EXIT_FAILURE;
+    }
+    if (bytes == 0) {
+        printf("Could not write '%s'\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    // the finished book replaces the checkpoint
+    if (checkpointName != NULL) {
+        remove(checkpointName);
+    }
+    printf("positions %zu bytes %lld (%.2f bytes/position) nodes %lld time %.1f\n", book.count, bytes, (double)bytes / ((book.count > 0) ? book.count : 1), nodes, monotonicSeconds() - start);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Purpose:
+ *      To print the book scores of a position and of every move from it
+ * Parameters:
+ *      fileName - the name of the book file
+ *      moves - the columns played to reach the position
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the book or moves are invalid
+ * Side-Effects:
+ *      NONE
+ */
+int runBookQueryCommand(const char* fileName, const char* moves) {
+    // the book being queried
+    OpeningBook* book = loadBook(fileName);
+    // the position being looked up
+    Position position;
+    SolverBoard board;
+    // the score of the position and of a move
+    int score = 0;
+    // the counter for the columns
+    int column = 0;
+    // the time taken by the lookup
+    double start = 0;
+    double seconds = 0;
+
+    if (book == NULL) {
+        printf("Could not load the book '%s'\n", fileName);
+        return EXIT_FAILURE;
+    }
+    initPosition(&position);
+    if (playMoveString(&position, moves) < 0) {
+        printf("Invalid move string '%s'\n", moves);
+        freeBook(book);
+        return EXIT_FAILURE;
+    }
+    loadSolverBoard(&board, &position);
+    printf("book plies %d-%d positions %zu\n", book->minPly, book->maxPly, book->count);
+    start = monotonicSeconds();
+    if (lookupBook(book, &board, &score)) {
+        seconds = monotonicSeconds() - start;
+        printf("score %d lookup %.1f us\n", score, seconds * 1e6);
+    } else {
+        printf("score unknown\n");
+    }
+    // the score of each move is the negated book score of the position after it
+    for (column = 0; column < BOARD_COLUMNS; column++) {
+        if (canPlay(&position, column)) {
+            SolverBoard child = board;
+            playSolverMove(&child, (board.mask + bottomMask) & columnMask(column));
+            if (hasFourInARow(child.current ^ child.mask)) {
+                printf("column %d wins\n", column + 1);
+            } else if (lookupBook(book, &child, &score)) {
+                printf("column %d score %d\n", column + 1, -score);
+            }
         }
     }
-    return playColumn;
+    freeBook(book);
+
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      To check if the computers move will give the player a winning move and undo
- *      it if it does
+ *      To analyse every game in a game log with a solver on each core and report
+ *      the moves that threw away a win or a tie
  * Parameters:
- *      gameBoard - the array to be modified to check if the player will win if the
- *      computers plays a move and to be modified to undo it to prevent the computer
- *      from losing on that turn
- *      opponentChar - the character representing the pieces of the computers opponent
- *      playColumn - the column the computer played its piece. If the move the computer 
- *      made gives the opponent the win it will be changed back to its default value so
- *      the computer can make a new move.
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: analyze <log> and options
  * Returns:
- *      The column the computer plays its piece in
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid
  * Side-Effects:
- *      The gameboard array is modified first to check if the computer has given 
- *      the user a winning move and then to undo that move by resetting the values
- *      to the default ('O').
+ *      The report is written to the output file or stdout, progress is printed to stderr
  */
-int dontGiveWin(char gameBoard[numColumns][numRows], const char opponentChar, int playColumn) {
-    // initiate the variable to store the index of the row above the computers last move
-    int rowSlot = 0;
-    
-    // starting from the bottom row in the column the computer played in, increment
-    // the rowSlot up by 1 until a row is found that equals O (the default value)
-    // this is the first row value above the computers last move. This loop will only
-    // run if the playColumn was modified in another function finding the computers
-    // move because there is no need to check if the player can win if the computer
-    // has not gone yet.
-    while ((gameBoard[playColumn][rowSlot] != 'O') && (rowSlot < 6) && (playColumn != 8)) {
-        // increment rowSlot by 1
-        rowSlot++;
+int runAnalyzeCommand(int argc, char** argv) {
+    // the shared analysis state
+    GameAnalysis analysis;
+    // the analysis threads
+    AnalysisWorker* workers = NULL;
+    // the number of threads
+    int threadCount = atoi(findOption(argc, argv, "--threads", "0"));
+    // the name of the report file, NULL for stdout
+    const char* outputName = findOption(argc, argv, "--output", NULL);
+    // the counter for the threads
+    int i = 0;
+    // the time the analysis started and the time taken so far
+    double start = monotonicSeconds();
+    double seconds = 0;
+
+    memset(&analysis, 0, sizeof(analysis));
+    analysis.nextGame = 1;
+    analysis.megabytes = atoi(findOption(argc, argv, "--megabytes", "64"));
+    analysis.nodeLimit = atoll(findOption(argc, argv, "--node-limit", "5000000"));
+    if (analysis.megabytes <= 0) {
+        printf("Invalid arguments\n");
+        return EXIT_FAILURE;
     }
-    // if the rowSlot is within the gameBoard and the playColumn has modified in 
-    // a past function, check if by changing the index above the computers last to the
-    // other users piece it will let the player win
-    if ((rowSlot < 6) && (playColumn != 8)) {
-        // change value at the index above the computers last move to the opponents character
-        gameBoard[playColumn][rowSlot] = opponentChar;
-        // check if the opponent will win with its piece in the index above the computer piece
-        // from the previous line of code
-        if (checkWinGame(gameBoard, opponentChar)) {
-            // if the opponent will win with the last computer move, set the 
-            // index that was changed back to the default
-            gameBoard[playColumn][rowSlot] = 'O';
-            // change the last computers move index back to the default so it can 
-            // make a new move
-            gameBoard[playColumn][rowSlot - 1] = 'O';
-            // set play column back to 8 so the computer can move to the next
-            // function in its logic to make a move.
-            playColumn = 8;
-        } else {
-            // the computers move will not give the player a winning move so 
-            // change the value at the index that was changed to the opponents piece back
-            // to the default
-            gameBoard[playColumn][rowSlot] = 'O';
+    analysis.input = (strcmp(argv[2], "-") == 0) ? stdin : fopen(argv[2], "r");
+    if (analysis.input == NULL) {
+        printf("Could not open '%s'\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    analysis.output = (outputName == NULL) ? stdout : fopen(outputName, "w");
+    if (analysis.output == NULL) {
+        printf("Could not open '%s'\n", outputName);
+        return EXIT_FAILURE;
+    }
+    if (threadCount <= 0) {
+        threadCount = countCores();
+    }
+    pthread_mutex_init(&analysis.inputLock, NULL);
+    pthread_mutex_init(&analysis.outputLock, NULL);
+    workers = calloc(threadCount, sizeof(AnalysisWorker));
+    for (i = 0; i < threadCount; i++) {
+        workers[i].analysis = &analysis;
+        pthread_create(&workers[i].thread, NULL, runAnalysisWorker, &workers[i]);
+    }
+    // report progress every second until every thread has finished
+    while (atomic_load(&analysis.finishedThreads) < threadCount) {
+        sleep(1);
+        seconds = monotonicSeconds() - start;
+        fprintf(stderr, "games %lld moves %lld rate %.1f games/s\n", (long long)atomic_load(&analysis.games), (long long)atomic_load(&analysis.moves), atomic_load(&analysis.games) / seconds);
+    }
+    for (i = 0; i < threadCount; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    seconds = monotonicSeconds() - start;
+    fprintf(stderr, "games %lld moves %lld invalid %lld blunders %lld missed wins %lld unknown %lld nodes %lld threads %d time %.1f rate %.1f games/s\n", (long long)atomic_load(&analysis.games), (long long)atomic_load(&analysis.moves), (long long)atomic_load(&analysis.invalid), (long long)atomic_load(&analysis.blunders), (long long)atomic_load(&analysis.missedWins), (long long)atomic_load(&analysis.unknown), (long long)atomic_load(&analysis.nodes), threadCount, seconds, atomic_load(&analysis.games) / seconds);
+    if (analysis.input != stdin) {
+        fclose(analysis.input);
+    }
+    if (analysis.output != stdout) {
+        fclose(analysis.output);
+    }
+    pthread_mutex_destroy(&analysis.inputLock);
+    pthread_mutex_destroy(&analysis.outputLock);
+    free(workers);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * The state of the engine protocol. The position is set up by the controlling
+ * program and each go runs a search on its own thread so that stop and the
+ * other commands are still read while it thinks.
+ */
+typedef struct {
+    // the position the next search starts from
+    Position position;
+    // the exact solver kept between searches so its table carries over, and
+    // whether its table has been allocated
+    Solver solver;
+    int solverReady;
+    // the transposition table size of the solver
+    int megabytes;
+    // the thread running the search and whether it has not been joined yet
+    pthread_t thread;
+    int searching;
+    // the limits of the search being run: the depth, the time wanted and the
+    // time it is stopped at (0 for no limit), and whether to solve exactly
+    int depth;
+    double seconds;
+    double maxSeconds;
+    int solve;
+    // the node limit of an exact solve, 0 for no limit
+    long long nodeLimit;
+} Engine;
+
+/*
+ * Purpose:
+ *      To run the search asked for by a go command and print its result
+ * Parameters:
+ *      argument - the Engine
+ * Returns:
+ *      NULL
+ * Side-Effects:
+ *      info lines and the bestmove line are printed to stdout
+ */
+void* runEngineSearch(void* argument) {
+    // the engine state
+    Engine* engine = argument;
+    // the position searched, so the engine can be given a new one while this runs
+    Position position = engine->position;
+    // the best column, its score and the depth reached
+    int column = -1;
+    int score = 0;
+    int depth = 0;
+    // the number of positions searched
+    long long nodes = 0;
+    // the time the search started
+    double start = monotonicSeconds();
+
+    if ((position.moveCount == NUM_CELLS) || (checkPositionWon(&position))) {
+        printf("bestmove none\n");
+        fflush(stdout);
+        return NULL;
+    }
+    if ((engine->solve) && (engine->solverReady)) {
+        // the position in the form the solver uses and the principal variation
+        SolverBoard board;
+        int variation[NUM_CELLS + 1];
+        loadSolverBoard(&board, &position);
+        engine->solver.nodes = 0;
+        engine->solver.aborted = 0;
+        engine->solver.nodeLimit = engine->nodeLimit;
+        atomic_store(&searchDeadline, (engine->maxSeconds > 0) ? start + engine->maxSeconds : 0);
+        score = solveBoard(&engine->solver, &board);
+        atomic_store(&searchDeadline, 0);
+        if (!engine->solver.aborted) {
+            solvePrincipalVariation(&engine->solver, &board, score, variation, NUM_CELLS + 1);
+            printf("info score exact %d distance %d nodes %lld time %.0f pv ", score, scoreToDistance(score, board.moveCount), engine->solver.nodes, (monotonicSeconds() - start) * 1000);
+            printVariation(variation);
+            printf("\n");
+            printf("bestmove %d\n", variation[0] + 1);
+            fflush(stdout);
+            return NULL;
         }
-    }   
-    
-    return playColumn;
+        // the solve was stopped, so a quick search picks the move instead
+        printf("info string solve stopped after %lld nodes\n", engine->solver.nodes);
+        atomic_store(&searchStop, 0);
+        column = searchTimed(&position, 0, 0, 8, stdout, NULL, &score, &depth, &nodes);
+    } else {
+        column = searchTimed(&position, engine->seconds, engine->maxSeconds, engine->depth, stdout, NULL, &score, &depth, &nodes);
+    }
+    printf("bestmove %d\n", column + 1);
+    fflush(stdout);
+
+    return NULL;
 }
 
 /*
  * Purpose:
- *      To check if the computer or player can indirectly get 3 pieces in a row 
- *      or prevent the user from playing a trap where they get 3 in a row indirectly.
- *      Overall this will reduce the risk of a user trapping the computer
- *      with two possible moves to win at the same time. While this does not address
- *      every possible trap, it takes action against many of the most common types 
- *      through this defense/offense 
-  * Parameters:
- *      gameBoard - the game board array
- *      computerChar - the character representing the computers pieces
- *      checkChar - the character for the player that the programming is checking
- *      if they can get 3 in an indirect line i.e XOOX where playing XXOX could give
- *      the player a winning move
- *      opponentChar - the character representing the pieces of the computers opponent
+ *      To stop the engine search if one is running and wait for its thread
+ * Parameters:
+ *      engine - the engine state
  * Returns:
- *      playColumn - the column the computer played its pieces in to be outputted
- *      to the other player
+ *      NONE
  * Side-Effects:
- *      The gameBoard array is modified wherever the computer plays its piece to get
- *      three in a row indirectly or block the player from getting it
+ *      The search prints its bestmove line before this returns
  */
-int threeTrap(char gameBoard[numColumns][numRows], const char computerChar, const char checkChar, const char opponentChar) {
-    // the counter for the row index
-    int i = 0;
-    // the counter for the column index
-    int j = 0;
-    // a default value for the play column that is not a valid column so if 
-    // this function does not find a way for the computer to win, the computer turn
-    // function will move on to the next function to try to find a good move for the 
-    // computer to play
-    int playColumn = 8;
-    
-    // this loop will iterate through the entire array, column by column, row by row,
-    // to check if the computer can get 3 in a line indirectly, or if it can prevent the 
-    // player from getting 3 in a line indirectly.
-    while (i < numRows){
-        // iterate across each column to find the player/computer pieces (the character representing them)
-        for (j = 0; j < numColumns; j++) {
-            // if the loop gets to a character that is the users/opponent, check if
-            // it can win vertically, horizontally, or diagonally
-            if (gameBoard[j][i] == checkChar) {
-            // for the following a space is defined as available if the slot
-            // below it is the bottom of the board or either the player or opponents piece
-                
-            // for each of the following, constraints are put on the j and i counter
-            // to make sure the computer or player can get 4 in a row in the future 
-            // as there is no point playing three in a line to trap/defend if that cannot be expanded
-            // to four in the future. The constraints also make sure pieces will be played
-            // within the game board
-                    
-                // the third piece to the right of the players piece is 
-                // also the players piece and the two pieces to the right
-                // of the players piece are available so play a piece in either slot
-                // that will not give the opponent (only if checking computer pieces)
-                // the win
-                if ((gameBoard[j + 3][i] == checkChar) && (gameBoard[j + 1][i] == 'O') && (gameBoard[j + 2][i] == 'O') && (((gameBoard[j + 1][i - 1] != 'O') && (gameBoard[j + 2][i - 1] != 'O')) || (i == 0)) && (j < 4)) {
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j + 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break;
-                    // play a piece in the second possible space to block/set a trap
-                    } else {
-                        // play piece to block or make 3 in a line indirectly
-                        gameBoard[j + 2][i] = computerChar;
-                        // update play column to the column the computer played in
-                        playColumn = j + 2;
-                    }
-                
-                /// the first piece to the right of the players piece is 
-                // also the players piece and the first space to the left and the
-                // second space to the right of the player are available so play a piece in either slot
-                // that will not give the opponent (only if checking computer pieces)
-                // the win
-                } else if ( (gameBoard[j + 1][i] == checkChar) && (gameBoard[j - 1][i] == 'O') && (gameBoard[j + 2][i] == 'O') && (((gameBoard[j - 1][i - 1] != 'O') && (gameBoard[j + 2][i - 1] != 'O')) || (i == 0)) && (j < 5) && (j > 0)){
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j - 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break;
-                    // play a piece in the second possible space to block/set a trap
-                    } else {
-                        // play piece to block or make 3 in a line indirectly
-                        gameBoard[j + 3][i] = computerChar;
-                        // update play column to the column the computer played in
-                        playColumn = j + 3;
-                    }  
-                
-                // the third piece diagonally upward to the right of the players piece is 
-                // also the players piece and the two spaces diagonally upward to the right
-                // of the players piece are available so play a piece in either slot
-                // that will not give the opponent (only if checking computer pieces)
-                // the win
-                } else if ( (gameBoard[j + 3][i + 3] == checkChar) && (gameBoard[j + 1][i + 1] == 'O') && (gameBoard[j + 2][i + 2] == 'O') && (gameBoard[j + 1][i] != 'O') && (gameBoard[j + 2][i + 1] != 'O') && (j < 4) && (i < 3)){
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j + 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break;
-                    // play a piece in the second possible space to block/set a trap
-                    } else {
-                        // play piece to block or make 3 in a line indirectly
-                        gameBoard[j + 2][i + 2] = computerChar;
-                        // update play column to the column the computer played in
-                        playColumn = j + 2;         
-                    }        
-                
-                // the first piece diagonally upward to the right of the players piece
-                // is also the players piece and the first space to diagonally downward
-                // to the left and the second space upward diagonally to the right are available
-                // so play a piece in either slot that will not give the opponent 
-                // (only if checking computer pieces) the win
-                } else if ( (gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j - 1][i - 1] == 'O') && (gameBoard[j + 2][i + 2] == 'O') && ((gameBoard[j - 1][i - 2] != 'O') || (i == 1)) && (gameBoard[j + 2][i + 1] != 'O') && (j < 5) && (i < 4) && (j > 0) && (i > 0)) {
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j + 2][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 2;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break;
-                   // place a piece to block a more direct trap in the second space diagonally
-                   // upwards to the right of the players piece
-                    } else {
-                        // play piece to block or make 3 in a line indirectly
-                        gameBoard[j - 1][i - 1] = computerChar;
-                        // update play column to the column the computer played in
-                        playColumn = j - 1;
-                    }             
-                
-                // the third piece diagonally upward to the left of the players piece is 
-                // also the players piece and the two spaces diagonally upward to the left
-                // of the players piece are available so play a piece in either slot
-                // that will not give the opponent (only if checking computer pieces)
-                // the win
-                } else if ( (gameBoard[j - 3][i + 3] == checkChar) && (gameBoard[j - 1][i + 1] == 'O') && (gameBoard[j - 2][i + 2] == 'O') && (gameBoard[j - 1][i] != 'O') && (gameBoard[j - 2][i + 1] != 'O') && (j > 2) && (i < 3)){
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j - 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break;
-                    // play a piece in the second possible space to block/set a trap
-                    } else {
-                        // play piece to block or make 3 in a line indirectly
-                        gameBoard[j - 2][i + 2] = computerChar;
-                        // update play column to the column the computer played in
-                        playColumn = j - 2;
-                    }               
-                
-                // the first piece diagonally upward to the left of the players piece
-                // is also the players piece and the first space to diagonally downward
-                // to the right and the second space upward diagonally to the left are available
-                // so play a piece in either slot that will not give the opponent 
-                // (only if checking computer pieces) the win
-                } else if ( (gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j + 1][i - 1] == 'O') && (gameBoard[j - 2][i + 2] == 'O') && ((gameBoard[j + 1][i - 2] != 'O') || (i == 1)) && (gameBoard[j - 2][i + 1] != 'O') && (j > 1) && (i < 4) && (j < 6) && (i > 0)){
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j - 2][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 2;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break; 
-                    // the second space diagonally downwards to the left is available
-                    // for a piece to be played so play a piece to make/block a trap
-                    } else {
-                        // play piece to block or make 3 in a line indirectly
-                        gameBoard[j + 1][i - 1] = computerChar;
-                        // update play column to the column the computer played in
-                        playColumn = j + 1;
-                    } 
-                    
-                // the first piece diagonally upward to the right of the players piece
-                // is also the players piece and the second space diagonally downward
-                // to the left and the first space downward diagonally to the left are available
-                // so play a piece that will not give the opponent 
-                // (only if checking computer pieces) the win
-                } else if ( (gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j - 1][i - 1] == 'O') && (gameBoard[j - 2][i - 2] == 'O') && ((gameBoard[j - 2][i - 3] != 'O') || (i == 2)) && (j < 6) && (j > 0) && (i < 5) && (i > 1)){
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j - 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break; 
-                    }
+void stopEngineSearch(Engine* engine) {
+    if (engine->searching) {
+        atomic_store(&searchStop, 1);
+        pthread_join(engine->thread, NULL);
+        engine->searching = 0;
+    }
+    atomic_store(&searchStop, 0);
+}
 
-                // the first piece diagonally upward to the left of the players piece
-                // is also the players piece and the second space diagonally downward
-                // to the right and the first space downward diagonally to the right are available
-                // so play a piece that will not give the opponent 
-                // (only if checking computer pieces) the win
-                } else if ( (gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j + 1][i - 1] == 'O') && (gameBoard[j + 2][i - 2] == 'O') && ((gameBoard[j + 2][i - 3] != 'O') || (i == 2)) && (j > 0) && (j < 6) && (i < 5) && (i > 1)){
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j + 2][i - 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 2;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break; 
-                    }
-                    
-                // the first piece diagonally upward to the right of the players piece
-                // is also the players piece and the third space diagonally upward
-                // to the right and the second space upward diagonally to the right are available
-                // so play a piece that will not give the opponent 
-                // (only if checking computer pieces) the win
-                } else if ( (gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j + 3][i + 3] == 'O') && (gameBoard[j + 2][i + 2] == 'O') && (gameBoard[j + 3][i + 2] != 'O') && (j < 4) && (i < 3)) {
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j + 3][i + 3] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 3;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break; 
-                    }
+/*
+ * Purpose:
+ *      To read the limits of a go command, the words strtok has left on the
+ *      current line, and start the search
+ * Parameters:
+ *      engine - the engine state
+ * Returns:
+ *      NONE
+ * Side-Effects:
+ *      A search thread is started
+ */
+void startEngineSearch(Engine* engine) {
+    // the name and value of each limit
+    char* name = NULL;
+    char* value = NULL;
+    // the clock and increment of the player to move in milliseconds, -1 if not given
+    double clock = -1;
+    double increment = 0;
+    // set if the player to move moved first
+    int firstToMove = (engine->position.moveCount & 1) == 0;
 
-                // the first piece diagonally upward to the left of the players piece
-                // is also the players piece and the third space diagonally upward
-                // to the left and the second space upward diagonally to the left are available
-                // so play a piece that will not give the opponent 
-                // (only if checking computer pieces) the win
-                } else if ( (gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j - 2][i + 2] == 'O') && (gameBoard[j - 3][i + 3] == 'O') && (gameBoard[j - 3][i + 2] != 'O') && (j > 1) && (i < 4)) {
-                    // play piece to block or make 3 in a line indirectly
-                    gameBoard[j - 3][i + 3] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 3;
-                    // if the computers move gives the user a winning move, undo the 
-                    // move and reset the play column to 8 (this can be seen in the function called here)
-                    // so the computer will continue to look for good moves
-                    // if the computer move does not give the user a winning move, break the
-                    // loop and continue the game
-                    playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-                    if (playColumn != 8) {
-                        break; 
-                    }
-                }
-                
-            }
-            // if the computers move gives the user a winning move, undo the 
-            // move and reset the play column to 8 (this can be seen in the function called here)
-            // so the computer will continue to look for good moves
-            // if the computer move does not give the user a winning move, break the
-            // loop and continue the game
-            playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-            if (playColumn != 8) {
-                break;
-            }
-          
-        } 
-        // the playColumn is not the default value, break from the while loop
-        // because the computer has made a move.
-        if (playColumn != 8) {
+    engine->depth = 0;
+    engine->seconds = 0;
+    engine->maxSeconds = 0;
+    engine->solve = 0;
+    engine->nodeLimit = 0;
+    while ((name = strtok(NULL, " \t\r\n")) != NULL) {
+        if (strcmp(name, "solve") == 0) {
+            engine->solve = 1;
+            continue;
+        }
+        if (strcmp(name, "infinite") == 0) {
+            continue;
+        }
+        value = strtok(NULL, " \t\r\n");
+        if (value == NULL) {
             break;
-        // the computer has not made a move so increment the row index counter
-        // by 1 and continue checking if the computer can play a move to win or
-        // prevent the other player from winning.
-        } else {
-            i++;
+        }
+        if (strcmp(name, "depth") == 0) {
+            engine->depth = atoi(value);
+        } else if (strcmp(name, "movetime") == 0) {
+            engine->seconds = atof(value) / 1000;
+            engine->maxSeconds = engine->seconds;
+        } else if (strcmp(name, "nodes") == 0) {
+            engine->nodeLimit = atoll(value);
+        } else if (strcmp(name, (firstToMove) ? "wtime" : "btime") == 0) {
+            clock = atof(value);
+        } else if (strcmp(name, (firstToMove) ? "winc" : "binc") == 0) {
+            increment = atof(value);
         }
     }
-    return playColumn;
+    // on a clock the engine shares its time out the same way as in a timed game
+    if ((clock >= 0) && (engine->seconds == 0)) {
+        engine->seconds = allocateMoveTime(&engine->position, clock / 1000, increment / 1000);
+        engine->maxSeconds = 2 * engine->seconds;
+    }
+    if ((engine->solve) && (!engine->solverReady)) {
+        engine->solverReady = initSolver(&engine->solver, engine->megabytes);
+        if (!engine->solverReady) {
+            printf("info string could not allocate a %d MB transposition table\n", engine->megabytes);
+        }
+    }
+    engine->searching = pthread_create(&engine->thread, NULL, runEngineSearch, engine) == 0;
 }
 
-
 /*
  * Purpose:
- *      For the computer to play a piece to get three in a row or to prevent 
- *      the user from getting three in a row.
+ *      To run the engine protocol, a line based protocol for controlling programs
+ *      that keeps one engine process running for many games. The commands are:
+ *          isready                         - answered with readyok
+ *          newgame                         - go back to the empty board
+ *          position [startpos] [moves M]   - set up the position after the moves M, e.g. 4453
+ *          go [depth D] [movetime T] [wtime T btime T winc T binc T] [solve [nodes N]] [infinite]
+ *                                          - search and print info lines then bestmove
+ *          stop                            - stop the search and print its bestmove now
+ *          memory                          - print the memory used by each table
+ *          quit                            - stop and exit
+ *      Times are in milliseconds.
  * Parameters:
- *      gameBoard - the game board array
- *      computerChar - the character for the computer representing its pieces
- *      checkChar - the character for the player that the programming is checking
- *      if they have 2 in a row
- *      opponentChar - the character representing the opponent to check
- *      if the computers move gives it the win
+ *      megabytes - the transposition table size of the exact solver
  * Returns:
- *      playColumn - the column the computer played its pieces in to be outputted
- *      to the player
+ *      EXIT_SUCCESS
  * Side-Effects:
- *      The gameBoard array is modified wherever the computer plays its piece to get
- *      three in a row or to prevent the user from getting three in a row. 
+ *      Commands are read from stdin and answered on stdout
  */
-int twoInARow(char gameBoard[numColumns][numRows], const char computerChar, const char checkChar, const char opponentChar) {
-    // the counter for the row index
-    int i = 0;
-    // the counter for the column index
-    int j = 0;
-    // a default value for the play column that is not a valid column so if 
-    // this function does not find a way for the computer to win, the computer turn
-    // function will move on to the next function to try to find a good move for the 
-    // computer to play
-    int playColumn = 8;
+int runEngineCommand(const int megabytes) {
+    // the engine state
+    Engine engine;
+    // the command line being read
+    char line[1024];
 
-    // this loop will iterate through the entire array, column by column, row by row,
-    // to check if the computer can get 3 in a row, or if it can prevent the 
-    // player from getting 3 in a row.
-    while (i < numRows) {
-        // iterate across each column to find the player/computer pieces (the character representing them)
-        for (j = 0; j < numColumns; j++) {
-        // for the following a space is defined as available if the slot
-        // below it is the bottom of the board or either the player or opponents piece
-            
-        // the constraints (j >, j <, i >, i <) are used to ensure the computer
-        // does not play three in a row if that 3 in a row can not be added on to
-        // make 4 in a row in the future. The constraints also make sure pieces will be played
-        // within the game board
-            
-            // if the loop gets to a character that is the users/opponent, check if
-            // it can get/block 3 in a row vertically, horizontally, or diagonally
-            if (gameBoard[j][i] == checkChar) {
-                
-                // the piece above the players piece is also the players piece and
-                // the space above that piece is available for a piece to be played in
-                if ((gameBoard[j][i + 1] == checkChar) && (i < 4) && (gameBoard[j][i + 2] == 'O')) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j;
-                    
-                // the first piece to the right of the players piece is also the players piece and
-                // the second space to the right is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i] == checkChar) && (gameBoard[j + 2][i] == 'O') && (i == 0 || gameBoard[j + 2][i - 1] != 'O') && (j < 4)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j + 2][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 2;
-                    
-                // the first piece to the right of the players piece is also the players piece and
-                // the first space to the left is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i] == checkChar) && (gameBoard[j - 1][i] == 'O') && ((gameBoard[j - 1][i - 1] != 'O') || (i == 0)) && (j > 1)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j - 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-
-                // the second piece to the right of the players piece is also the 
-                // players piece and the first space to the right of the players piece
-                // is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i] == 'O') && (gameBoard[j + 2][i] == checkChar) && ((gameBoard[j + 1][i - 1] != 'O') || (i == 0)) && (j < 4)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j + 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    
-                // the first piece diagonally upward to the right of the players piece is also 
-                // the players piece and the second space upward diagonally right of the players piece
-                // is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i + 1] == checkChar)  && (gameBoard[j + 2][i + 2] == 'O') && (gameBoard[j + 2][i + 1] != 'O') && (j < 4) && (i < 3)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j + 2][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 2;
-                    
-                // the first piece diagonally upward to the right of the players piece is also 
-                // the players piece and the first space downward diagonally left of the players piece
-                // is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i + 1] == checkChar) && (gameBoard[j - 1][i - 1] == 'O') && ((gameBoard[j - 1][i - 2] != 'O') || (i == 1)) && (j > 0) && (i > 0) && (j < 5) && (i < 4)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j - 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    
-                // the second piece diagonally upward to the right of the players piece is also 
-                // the players piece and the first space upward diagonally right of the players piece
-                // is available for a piece to be played in
-                } else if ((gameBoard[j + 1][i + 1] == 'O') && (gameBoard[j + 2][i + 2] == checkChar) && (gameBoard[j + 1][i] != 'O') && (j < 5) && (i < 4)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j + 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    
-                // the first piece diagonally upward to the left of the players piece is also 
-                // the players piece and the second space upward diagonally left of the players piece
-                // is available for a piece to be played in
-                } else if ((gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j - 2][i + 2] == 'O') && (gameBoard[j - 2][i + 1] != 'O') && (j > 2) && (i < 3)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j - 2][i + 2] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 2;
-                    
-                // the first piece diagonally upward to the left of the players piece is also 
-                // the players piece and the first space downward diagonally right of the players piece
-                // is available for a piece to be played in
-                } else if ( (gameBoard[j - 1][i + 1] == checkChar) && (gameBoard[j + 1][i - 1] == 'O') && ((gameBoard[j + 1][i - 2] != 'O') || (i == 1)) && (j > 1) && (i < 4) && (j < 6) && (i > 0)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j + 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    
-                // the second piece diagonally upward to the left of the players piece is also 
-                // the players piece and the first space upward diagonally left of the players piece
-                // is available for a piece to be played in
-                } else if ((gameBoard[j - 1][i + 1] == 'O') && (gameBoard[j - 2][i + 2] == checkChar) && (gameBoard[j - 1][i] != 'O') && (j > 1) && (i < 4)) {
-                    // play piece to get 3 in a row or prevent the user from getting
-                    // three in a row
-                    gameBoard[j - 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                }
-            }
-            // if the computers move does not give the opponent a winning move and a
-            // move to block it from winning, break the loop
-            
-            // if the computers move gives the user a winning move, undo the 
-            // move and reset the play column to 8 (this can be seen in the function called here)
-            // so the computer will continue to look for good moves
-            // if the computer move does not give the user a winning move, break the
-            // loop and continue the game
-            playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-            if (playColumn != 8) {
-                // if the computers move gives the user a move to block it from winning, undo the 
-                // move and reset the play column to 8 (this can be seen in the function called here)
-                // so the computer will continue to look for good moves
-                // if the computer move does not give the user a blocking move, break the
-                // loop and continue the game. This aims to eventually force the user
-                // to play a piece to give the computer the win late in the game, instead
-                // of the computer accidentally giving the user a way to tie by blocking it 
-                // from getting 4 in a row. This uses the dont give win function but checks
-                // for places the computer can win instead of the player
-                playColumn = dontGiveWin(gameBoard, computerChar, playColumn);
-                if (playColumn != 8) {
-                    break;
-                }
-            }  
+    memset(&engine, 0, sizeof(engine));
+    engine.megabytes = (megabytes > 0) ? megabytes : 64;
+    initPosition(&engine.position);
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        // the name of the command
+        char* command = strtok(line, " \t\r\n");
+        if (command == NULL) {
+            continue;
         }
-        // the playColumn is not the default value, break from the while loop
-        // because the computer has made a move.
-        if (playColumn != 8) {
+        if (strcmp(command, "quit") == 0) {
             break;
-        // the computer has not made a move so increment the row index counter
-        // by 1 and continue checking if the computer can play a move to win or
-        // prevent the other player from winning.
+        } else if (strcmp(command, "isready") == 0) {
+            printf("readyok\n");
+        } else if (strcmp(command, "stop") == 0) {
+            stopEngineSearch(&engine);
+        } else if (strcmp(command, "newgame") == 0) {
+            stopEngineSearch(&engine);
+            initPosition(&engine.position);
+        } else if (strcmp(command, "position") == 0) {
+            // the next word of the command
+            char* word = NULL;
+            stopEngineSearch(&engine);
+            initPosition(&engine.position);
+            while ((word = strtok(NULL, " \t\r\n")) != NULL) {
+                if ((strcmp(word, "startpos") == 0) || (strcmp(word, "moves") == 0)) {
+                    continue;
+                }
+                if (playMoveString(&engine.position, word) < 0) {
+                    printf("info string invalid moves '%s'\n", word);
+                    initPosition(&engine.position);
+                }
+            }
+        } else if (strcmp(command, "go") == 0) {
+            stopEngineSearch(&engine);
+            startEngineSearch(&engine);
+        } else if (strcmp(command, "memory") == 0) {
+            printMemoryStatistics();
         } else {
-            i++;
+            printf("info string unknown command '%s'\n", command);
         }
+        fflush(stdout);
+    }
+    stopEngineSearch(&engine);
+    if (engine.solverReady) {
+        freeSolver(&engine.solver);
     }
 
-    return playColumn;
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      For the computer to place a piece to get 2 in a row
+ *      To print the best moves of a position with their scores and principal
+ *      variations, either solved exactly or searched to a fixed depth
  * Parameters:
- *      gameBoard - the gameBoard array
- *      computerChar - the character representing the computers pieces
- *      opponentChar - the character representing the opponent to check
- *      if the computers move gives it the win
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: multipv [moves] and options
  * Returns:
- *      playColumn - The column the computer played its piece in to be 
- *      outputted to the player
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid
  * Side-Effects:
- *      The gameboard array is modified when the computer makes its move
+ *      NONE
  */
-int connectTwo(char gameBoard[numColumns][numRows], char computerChar, const char opponentChar) {
-    // the counter for the row index
+int runMultiPvCommand(int argc, char** argv) {
+    // the position being ranked
+    Position position;
+    // the moves to the position
+    const char* moves = ((argc >= 3) && (argv[2][0] != '-')) ? argv[2] : "";
+    // the number of best moves to score exactly and the search depth, 0 to solve
+    int best = atoi(findOption(argc, argv, "--best", "7"));
+    int depth = atoi(findOption(argc, argv, "--depth", "0"));
+    int megabytes = atoi(findOption(argc, argv, "--megabytes", "64"));
+    // the legal moves, best first
+    RankedMove ranked[BOARD_COLUMNS];
+    int count = 0;
+    // the number of positions searched
+    long long nodes = 0;
+    // the counter for the moves
     int i = 0;
-    // the counter for the column index
-    int j = 0;
-    // a default value for the play column that is not a valid column so if 
-    // this function does not find a way for the computer to win, the computer turn
-    // function will move on to the next function to try to find a good move for the 
-    // computer to play
-    int playColumn = 8;
+    // the time the ranking started
+    double start = monotonicSeconds();
 
-    // this loop will iterate through the entire array, column by column, row by row,
-    // to check if the computer can get 2 in a row
-    while (i < numRows) {
-        // iterate across each column to find the computer pieces
-        for (j = 0; j < numColumns; j++) {
-            // if the loop gets to a character that is the users/opponent, check if
-            // it can get 2 in a row vertically, horizontally, or diagonally            
-            if (gameBoard[j][i] == computerChar) {
-            // for the following a space is defined as available if the slot
-            // below it is the bottom of the board or either the player or opponents piece  
-            
-            // constraints are put on the j and i counters for the following to make 
-            // sure the piece can be played within the bounds of the game board
-                
-                // the space directly above the players piece is available for a 
-                // piece to be played in
-                if ((gameBoard[j][i + 1] == 'O') && (i < 5)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j;
-                    
-                // the space directly right of the players piece is available
-                // for a piece to be played in
-                } else if ((gameBoard[j + 1][i] == 'O') && ((gameBoard[j + 1][i - 1] != 'O') || (i == 0)) && (j < 6)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j + 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    
-                // the space directly left of the players piece is available
-                // for a piece to be played in
-                } else if ((gameBoard[j - 1][i] == 'O') && ((gameBoard[j - 1][i - 1] != 'O') || (i == 0)) && (j > 0)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j - 1][i] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    
-                // the space upward diagonally right of the players piece is available
-                // for a piece to be played in
-                } else if ((gameBoard[j + 1][i + 1] == 'O') && (gameBoard[j + 1][i] != 'O') && (j < 6) && (i < 5)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j + 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                    
-                // the space downward diagonally left of the players piece is available
-                // for a piece to be played in
-                } else if ((gameBoard[j - 1][i - 1] == 'O') && ((gameBoard[j - 1][i - 2] != 'O') || (i == 1)) && (j > 0) && (i > 0)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j - 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    
-                // the space upward diagonally left of the players piece is available
-                // for a piece to be played in
-                } else if ((gameBoard[j - 1][i + 1] == 'O') && (gameBoard[j - 1][i] != 'O') && (j > 0) && (i < 5)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j - 1][i + 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j - 1;
-                    
-                // the space downward diagonally right of the players piece is available
-                // for a piece to be played in
-                } else if ((gameBoard[j + 1][i - 1] == 'O') && ((gameBoard[j + 1][i - 2] != 'O') || (i == 1)) && (j < 6) && (i > 0)) {
-                    // place piece for the computer to get 2 in a row
-                    gameBoard[j + 1][i - 1] = computerChar;
-                    // update play column to the column the computer played in
-                    playColumn = j + 1;
-                }
-            }
-            // if the computers move does not give the opponent a winning move and a
-            // move to block it from winning, break the loop
-            
-            // if the computers move gives the user a winning move, undo the 
-            // move and reset the play column to 8 (this can be seen in the function called here)
-            // so the computer will continue to look for good moves
-            // if the computer move does not give the user a winning move, break the
-            // loop and continue the game
-            playColumn = dontGiveWin(gameBoard, opponentChar, playColumn);
-            if (playColumn != 8) {
-                // if the computers move gives the user a move to block it from winning, undo the 
-                // move and reset the play column to 8 (this can be seen in the function called here)
-                // so the computer will continue to look for good moves
-                // if the computer move does not give the user a blocking move, break the
-                // loop and continue the game. This aims to eventually force the user
-                // to play a piece to give the computer the win late in the game, instead
-                // of the computer accidentally giving the user a way to tie by blocking it 
-                // from getting 4 in a row. This uses the dont give win function but checks
-                // for places the computer can win instead of the player
-                playColumn = dontGiveWin(gameBoard, computerChar, playColumn);
-                if (playColumn != 8) {
-                    break;
-                }
-            }              
+    initPosition(&position);
+    if ((playMoveString(&position, moves) < 0) || (position.moveCount == NUM_CELLS) || (checkPositionWon(&position)) || (best <= 0) || (megabytes <= 0)) {
+        printf("Invalid arguments or finished position\n");
+        return EXIT_FAILURE;
+    }
+    if (depth > 0) {
+        count = rankMovesSearch(&position, depth, best, ranked, &nodes);
+    } else {
+        // the exact solver and the position in the form it uses
+        Solver solver;
+        SolverBoard board;
+        if (!initSolver(&solver, megabytes)) {
+            printf("Could not allocate a %d MB transposition table\n", megabytes);
+            return EXIT_FAILURE;
         }
-        // the playColumn is not the default value, break from the while loop
-        // because the computer has made a move.
-        if (playColumn != 8) {
-            break;
-        // the computer has not made a move so increment the row index counter
-        // by 1 and continue checking if the computer can play a move to win or
-        // prevent the other player from winning.
+        loadSolverBoard(&board, &position);
+        count = rankMovesExact(&solver, &board, best, ranked);
+        nodes = solver.nodes;
+        freeSolver(&solver);
+    }
+    for (i = 0; i < count; i++) {
+        if (ranked[i].exact) {
+            printf("%d column %d score %d pv ", i + 1, ranked[i].column + 1, ranked[i].score);
+            printVariation(ranked[i].variation);
+            printf("\n");
         } else {
-            i++;
+            printf("%d column %d score <= %d\n", i + 1, ranked[i].column + 1, ranked[i].score);
         }
     }
+    printf("nodes %lld time %.3f\n", nodes, monotonicSeconds() - start);
 
-    return playColumn;
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      For the computer to play its first two moves
+ *      To measure how strong the computer is for each node budget. Every budget
+ *      plays a reference pool of random moves, the pattern based computer player
+ *      and fixed depth searches, the pool plays itself, and every player is
+ *      rated from the results. Each pair of games starts from the same random
+ *      opening with the colours swapped. The table printed at the end gives the
+ *      smallest budget that reaches each strength, for setting difficulty levels.
  * Parameters:
- *      gameBoard - the array for the gameboard
- *      computerChar - the character representing the computers pieces
- *      opponentChar - the character representing the users pieces
- *      playColumn - the column the computer plays its piece in
- *      turn - the turn the game is on
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: calibrate and options
  * Returns:
- *      playColumn - the column the computer plays its piece in
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid
  * Side-Effects:
- *      The gameboard array is modified to place the computer pieces
+ *      The ratings and the budget table are printed
  */
-int playFirstTwoMoves(char gameBoard[numColumns][numRows], const char computerChar, const char opponentChar, int playColumn, const int turn) {
-        // play first turn in the middle of the board as it is a strong strategic position
-    if (turn == 0) {
-        // changes the default value of the 3rd column and 0th row to the computers char
-        gameBoard[3][0] = computerChar;
-        // change the value of the column the computer played to be outputted to the live player
-        playColumn = 3;
+int runCalibrateCommand(int argc, char** argv) {
+    // the shared calibration state
+    Calibration* calibration = calloc(1, sizeof(Calibration));
+    // the calibration threads
+    pthread_t* threads = NULL;
+    // the number of threads and of game pairs for each pairing
+    int threadCount = atoi(findOption(argc, argv, "--threads", "0"));
+    int pairs = atoi(findOption(argc, argv, "--games", "20"));
+    // the list of node budgets and the next budget in it
+    const char* budgets = findOption(argc, argv, "--budgets", "30,100,300,1000,3000,10000,30000,100000");
+    char* next = NULL;
+    // the random seed of the openings
+    uint64_t seed = strtoull(findOption(argc, argv, "--seed", "1"), NULL, 10);
+    // the size of the games played
+    size_t gameBytes = 0;
+    // the number of players in the reference pool
+    int poolCount = 0;
+    // the strongest rating found, the tier being printed and its cheapest budget
+    double strongest = 0;
+    int tier = 0;
+    int cheapest = 0;
+    // counters for the players, pairs and games
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    int g = 0;
+    // the time the calibration started
+    double start = monotonicSeconds();
+
+    calibration->openingPlies = atoi(findOption(argc, argv, "--opening-plies", "2"));
+    if ((pairs <= 0) || (calibration->openingPlies < 0) || (calibration->openingPlies >= NUM_CELLS)) {
+        printf("Invalid arguments\n");
+        free(calibration);
+        return EXIT_FAILURE;
     }
-    // play computer second turn in a good position for the computer
-    else {
-        // based of the minimax algorithm the following moves were made every 
-        // time the second move was simulated so they have been recreated to
-        // give the computer a strong first two moves
-        
-        // NOTE the indexes here are checked as they would be in the array (from 0 - 6)
-        // however for my commenting 1 has been added to the index because that is the
-        // column value the user of the program would see
-        
-        // if the user plays their piece in column 2 or 3, the computer plays its
-        // piece in column 5
-        if ((gameBoard[1][0] == opponentChar) || (gameBoard[2][0] == opponentChar)) {
-            gameBoard[5][0] = computerChar;
-            playColumn = 5;
-        // if the user plays their piece in column 5 or 6, the computer plays its
-        // piece in column 2.
-        } else if ((gameBoard[4][0] == opponentChar) || (gameBoard[5][0] == opponentChar)) {
-            gameBoard[1][0] = computerChar;
-            playColumn = 1;
-        // if the user plays their piece in column 1 or 7, the computer plays its
-        // piece in column 4 above its first piece
-        } else if ((gameBoard[0][0] == opponentChar) || (gameBoard[6][0] == opponentChar)) {
-            gameBoard[3][1] = computerChar;
-            playColumn = 3;
-        // if the user plays their piece in column 4 above the computers first piece
-        // the computer plays its piece above the user piece in column 4
-        } else if (gameBoard[3][1] == opponentChar) {
-            gameBoard[3][2] = computerChar;
-            playColumn = 3;
+    // the reference pool, the random player is rated 0
+    calibration->players[0].type = PLAYER_RANDOM;
+    strcpy(calibration->players[0].name, "random");
+    calibration->players[1].type = PLAYER_HEURISTIC;
+    strcpy(calibration->players[1].name, "heuristic");
+    for (i = 0; i < 3; i++) {
+        calibration->players[2 + i].type = PLAYER_DEPTH;
+        calibration->players[2 + i].budget = 2 + 2 * i;
+        snprintf(calibration->players[2 + i].name, sizeof(calibration->players[2 + i].name), "depth %d", 2 + 2 * i);
+    }
+    poolCount = 5;
+    calibration->playerCount = poolCount;
+    while ((*budgets != '\0') && (calibration->playerCount < MAX_CALIBRATION_PLAYERS)) {
+        CalibrationPlayer* player = &calibration->players[calibration->playerCount++];
+        player->type = PLAYER_NODES;
+        player->budget = strtoll(budgets, &next, 10);
+        snprintf(player->name, sizeof(player->name), "nodes %lld", player->budget);
+        if ((next == budgets) || (player->budget <= 0)) {
+            printf("Invalid budget list\n");
+            free(calibration);
+            return EXIT_FAILURE;
+        }
+        budgets = (*next == ',') ? next + 1 : next;
+    }
+    // each budget plays every pool player and the pool plays itself
+    gameBytes = (size_t)calibration->playerCount * poolCount * pairs * 2 * sizeof(CalibrationGame);
+    calibration->games = allocateTable(MEMORY_GAMES, gameBytes);
+    if (calibration->games == NULL) {
+        printf("Could not allocate %.1f MB of games\n", gameBytes / 1048576.0);
+        free(calibration);
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < calibration->playerCount; i++) {
+        for (j = 0; (j < poolCount) && (j < i); j++) {
+            for (k = 0; k < pairs; k++) {
+                // both games of the pair start from the same opening
+                uint64_t gameSeed = seed * 0x9E3779B97F4A7C15ull + (uint64_t)calibration->gameCount;
+                calibration->games[calibration->gameCount].first = i;
+                calibration->games[calibration->gameCount].second = j;
+                calibration->games[calibration->gameCount++].seed = gameSeed;
+                calibration->games[calibration->gameCount].first = j;
+                calibration->games[calibration->gameCount].second = i;
+                calibration->games[calibration->gameCount++].seed = gameSeed;
+            }
         }
     }
-    
-    return playColumn;
-}
+    if (threadCount <= 0) {
+        threadCount = countCores();
+    }
+    threads = calloc(threadCount, sizeof(pthread_t));
+    atomic_init(&calibration->nextGame, 0);
+    for (i = 0; i < threadCount; i++) {
+        pthread_create(&threads[i], NULL, runCalibrationWorker, calibration);
+    }
+    for (i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (g = 0; g < calibration->gameCount; g++) {
+        CalibrationGame* game = &calibration->games[g];
+        for (k = 0; k < 2; k++) {
+            CalibrationPlayer* player = &calibration->players[(k == 0) ? game->first : game->second];
+            player->nanoseconds += game->nanoseconds[k];
+            player->nodes += game->nodes[k];
+            player->moves += game->moves[k];
+        }
+    }
+    ratePlayers(calibration);
+    printf("%-14s %8s %12s %12s\n", "player", "elo", "ms/move", "nodes/move");
+    for (i = 0; i < calibration->playerCount; i++) {
+        CalibrationPlayer* player = &calibration->players[i];
+        long long moves = (player->moves > 0) ? player->moves : 1;
+        printf("%-14s %8.0f %12.4f %12.0f\n", player->name, player->elo, player->nanoseconds / 1e6 / moves, (double)player->nodes / moves);
+        if (player->elo > strongest) {
+            strongest = player->elo;
+        }
+    }
+    // the cheapest node budget that reaches each level of strength
+    printf("\n%-12s %12s %12s %8s\n", "target elo", "nodes", "ms/move", "elo");
+    for (tier = 100; tier <= strongest; tier += 100) {
+        cheapest = -1;
+        for (i = poolCount; i < calibration->playerCount; i++) {
+            if ((calibration->players[i].elo >= tier) && ((cheapest < 0) || (calibration->players[i].budget < calibration->players[cheapest].budget))) {
+                cheapest = i;
+            }
+        }
+        if (cheapest >= 0) {
+            CalibrationPlayer* player = &calibration->players[cheapest];
+            printf("%-12d %12lld %12.4f %8.0f\n", tier, player->budget, player->nanoseconds / 1e6 / ((player->moves > 0) ? player->moves : 1), player->elo);
+        }
+    }
+    printf("\ngames %d threads %d time %.1f\n", calibration->gameCount, threadCount, monotonicSeconds() - start);
+    free(threads);
+    freeTable(MEMORY_GAMES, calibration->games, gameBytes);
+    free(calibration);
 
+    return EXIT_SUCCESS;
+}
 
 /*
  * Purpose:
- *      To play the best move for the computer by calling functions
- *      for the computer to play pieces. It first checks if the computer can get 3
- *      in a row or prevent the opponent from getting 3 and then it checks if the
- *      computer can get two in a row and if none of these are met it will play a random
- *      piece.
+ *      To measure how many idle games fit in memory as packed sessions and how
+ *      long they take to unpack and pack. Every session in turn is unpacked,
+ *      given a random move and packed again, and a finished game is replaced
+ *      by a new one.
  * Parameters:
- *      gameBoard - the gameboard that is modified to make the computers move
- *      computerChar - the character chosen for the computer
- *      opponentChar - the live players chosen character
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: sessions count and options
  * Returns:
- *      playColumn - the column the computer plays its piece in
- * Side-Effects: 
- *      The gameboard array is modified in functions called by this one
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid
+ * Side-Effects:
+ *      The memory used and the times are printed
  */
-int playBestMove(char gameBoard[numColumns][numRows], const char computerChar, const char opponentChar) {
-    // initiate the variable for the column the computer plays its piece in
-    // as a column number outside the array so the gameboard is not modified unless
-    // the computer finds a move to play within the gameboard where this will be reassigned
-    int playColumn = 8;
-    // the row the computer plays its piece in which is needed if the computer
-    // picks a random column to play in
-    int rowSlot = 0;
-    
-    // the column the computer plays has not been modified from 
-    // the function calls in computer turn function that come before this function call
-    if (playColumn == 8) {
-        // check if the computer can get a set of three in a row in an indirect
-        // line to try to trap the user player. Eg something like this XOXX where 
-        // x is the computer piece
-        playColumn = threeTrap(gameBoard, computerChar, computerChar, opponentChar);
+int runSessionsCommand(int argc, char** argv) {
+    // the number of sessions and of moves to play
+    long long count = atoll(argv[2]);
+    long long moveTotal = atoll(findOption(argc, argv, "--moves", "0"));
+    // the sessions
+    PackedSession* sessions = NULL;
+    // the random moves
+    RandomState random;
+    // the bitboards a session is unpacked into and the clocks of the session
+    uint64_t first = 0;
+    uint64_t occupied = 0;
+    double clocks[2] = {0, 0};
+    // the time spent unpacking and packing
+    uint64_t unpackNanoseconds = 0;
+    uint64_t packNanoseconds = 0;
+    // the time reading the clock twice takes, which is more than an unpack or
+    // pack and is taken off their times
+    double clockNanoseconds = 0;
+    // the number of games finished
+    long long finished = 0;
+    // the counters for the moves and the session
+    long long move = 0;
+    long long i = 0;
+
+    if (count <= 0) {
+        printf("Invalid session count\n");
+        return EXIT_FAILURE;
     }
-    if (playColumn == 8) {
-        // check if the computer has 2 in a row (or 2 with an empty 
-        // space in the middle), play a piece to get 3 in a row
-        playColumn = twoInARow(gameBoard, computerChar, computerChar, opponentChar);
+    if (moveTotal <= 0) {
+        moveTotal = count * 4;
     }
-    if (playColumn == 8) {
-        // check if the player can get a set of three in a row in an indirect
-        // line to try to trap the computer and play a move to block it. Eg something like this X_OX where 
-        // O is the computer piece that has blocked the player from a indirect 3 in a line trap
-        playColumn = threeTrap(gameBoard, computerChar, opponentChar, opponentChar);
+    sessions = allocateTable(MEMORY_GAMES, count * sizeof(PackedSession));
+    if (sessions == NULL) {
+        printf("Could not allocate %lld sessions\n", count);
+        return EXIT_FAILURE;
     }
-    // the playColumn was not modified by the previous function call
-    if (playColumn == 8) {
-        // check if the user has 2 in a row (or 2 with an empty 
-        // space in the middle), play a piece to prevent them from getting 3 in a row
-        playColumn = twoInARow(gameBoard, computerChar, opponentChar, opponentChar);
+    seedRandom(&random, strtoull(findOption(argc, argv, "--seed", "1"), NULL, 10));
+    for (i = 0; i < count; i++) {
+        packSession(&sessions[i], 0, 0, 'X', 'Y', NULL, 0);
     }
-    // the playColumn was not modified by the previous function call
-    if (playColumn == 8) {
-        // place a piece to give the computer two in a row.
-        playColumn = connectTwo(gameBoard, computerChar, opponentChar);
+    for (move = 0; move < moveTotal; move++) {
+        uint64_t start = profileClock();
+        clockNanoseconds += profileClock() - start;
     }
+    clockNanoseconds /= moveTotal;
+    for (move = 0; move < moveTotal; move++) {
+        // the session being played
+        PackedSession* session = &sessions[move % count];
+        // the time the unpack or pack started
+        uint64_t start = profileClock();
+        // the cell of the random move and the pieces of the player making it
+        uint64_t cell = 0;
+        uint64_t pieces = 0;
 
-    return playColumn;
+        unpackSession(session, &first, &occupied, clocks);
+        unpackNanoseconds += profileClock() - start;
+        cell = (occupied + bottomMask) & columnMask(randomColumn(&random, occupied));
+        pieces = ((session->moveCount & 1) ? (occupied ^ first) : first) | cell;
+        first |= (session->moveCount & 1) ? 0 : cell;
+        occupied |= cell;
+        if (hasFourInARow(pieces) || (session->moveCount + 1 == NUM_CELLS)) {
+            // start a new game in place of the finished one
+            first = 0;
+            occupied = 0;
+            finished++;
+        }
+        start = profileClock();
+        packSession(session, first, occupied, session->playerChars[0], session->playerChars[1], clocks, session->flags);
+        packNanoseconds += profileClock() - start;
+    }
+    printf("sessions %lld bytes/session %d memory %.1f MB\n", count, (int)sizeof(PackedSession), count * sizeof(PackedSession) / 1048576.0);
+    printf("moves %lld games finished %lld unpack %.1f ns pack %.1f ns (less %.1f ns to read the clock)\n", moveTotal, finished, (double)unpackNanoseconds / moveTotal - clockNanoseconds, (double)packNanoseconds / moveTotal - clockNanoseconds, clockNanoseconds);
+    freeTable(MEMORY_GAMES, sessions, count * sizeof(PackedSession));
+
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      For the computer to play a random move
+ *      To add the games of a game log to a game database, creating it if it
+ *      does not exist, and index them. Lines that are not valid games are skipped.
  * Parameters:
- *      gameBoard - the gameboard that is modified for the computer to play a random move
- *      computerChar - the character chosen for the computer
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: db-add database log
  * Returns:
- *      playColumn - the column the computer plays its piece in
- * Side-Effects: 
- *      The gameboard array is modified to play the computer piece
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the files could not be read or written
+ * Side-Effects:
+ *      The games are appended to the database and a segment is added to its index
  */
-int playRandomMove(char gameBoard[numColumns][numRows], const char computerChar) {
-    // initiate play column variable to make a random move
-    int playColumn = 0; 
-    
-    // pick a random number from 1 - 7. The range is from 1-7 and not 0-6 because
-    // the place piece function takes a integer that the user enters and subtracts one to 
-    // get the actual column index
-    playColumn = ((rand() % (7 - 1 + 1)) + 1);
-    // if the column is not full, place the computers piece
-    if (gameBoard[playColumn][5] == 'O') {
-        // place the computers piece in the column it randomly chose
-        placepiece(gameBoard, computerChar, playColumn);     
-    } else {
-        // while the column that is randomly chosen is full, choose a new column
-        while (gameBoard[playColumn][5] != 'O') {
-            // uses random function algorithm (upper limit - lower limit + 1) + lower limit
-            // to pick a column. This will repeat until the column chosen is not full so
-            // a piece can be played
-            playColumn = (rand() % (7 - 1 + 1)) + 1;
+int runDatabaseAddCommand(int argc, char** argv) {
+    // the database
+    GameDatabase* database = openDatabase(argv[2], 1);
+    // the game log
+    FILE* input = (strcmp(argv[3], "-") == 0) ? stdin : fopen(argv[3], "r");
+    // the line read from the log and the record of its game
+    char line[GAME_LOG_LINE];
+    unsigned char record[DATABASE_GAME_SIZE];
+    // the number of games added and of lines skipped
+    long long added = 0;
+    long long skipped = 0;
+    // set while everything has worked
+    int valid = 1;
+    // the time the command started
+    double start = monotonicSeconds();
+
+    (void)argc;
+    if ((database == NULL) || (input == NULL)) {
+        printf("Could not open '%s'\n", (database == NULL) ? argv[2] : argv[3]);
+        closeDatabase(database);
+        return EXIT_FAILURE;
+    }
+    // new games go after the last whole game, over any part of a game left by a crash
+    fseeko(database->games, DATABASE_HEADER_SIZE + (off_t)database->gameCount * DATABASE_GAME_SIZE, SEEK_SET);
+    while ((valid) && (fgets(line, sizeof(line), input) != NULL)) {
+        // a line too long to read at once is skipped whole, so its rest is not read as a game
+        if ((strchr(line, '\n') == NULL) && (!feof(input))) {
+            int c = 0;
+            while (((c = fgetc(input)) != EOF) && (c != '\n')) {
+            }
+            skipped++;
+            continue;
+        }
+        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r') || (encodeGame(line, record) < 0)) {
+            skipped++;
+            continue;
         }
-        // place the computers piece in the column it randomly chose
-        placepiece(gameBoard, computerChar, playColumn); 
+        valid = fwrite(record, 1, DATABASE_GAME_SIZE, database->games) == DATABASE_GAME_SIZE;
+        added++;
+    }
+    if (input != stdin) {
+        fclose(input);
+    }
+    // the games must be on disk before the index points at them
+    valid = (valid) && (fflush(database->games) == 0) && (fsync(fileno(database->games)) == 0);
+    if (valid) {
+        database->gameCount += added;
+        valid = indexNewGames(database);
+    }
+    if ((valid) && (database->segmentCount > DATABASE_MAX_SEGMENTS)) {
+        valid = compactDatabase(database);
+    }
+    if (!valid) {
+        printf("Could not write to '%s'\n", argv[2]);
+        closeDatabase(database);
+        return EXIT_FAILURE;
     }
+    printf("added %lld skipped %lld games %llu segments %d time %.1f\n", added, skipped, (unsigned long long)database->gameCount, database->segmentCount, monotonicSeconds() - start);
+    closeDatabase(database);
 
-    return playColumn;
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      For the computer to play a move
+ *      To print how the stored games that reached a position ended, and the
+ *      first of those games
  * Parameters:
- *      computerChar - the character representing the computers pieces
- *      gameBoard - the array for the game board
- *      opponentChar - the character representing the live players pieces (the computers opponent)
- *      turn - the turn the game is on
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: db-query database, moves and options
  * Returns:
- *      NONE
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the database or moves are invalid
  * Side-Effects:
- *      The gameboard array is modified in functions called by this one
+ *      NONE
  */
-void computerTurn(char computerChar, char gameBoard[numColumns][numRows], char opponentChar, int turn) {
-    // set playColumn to 8 meaning computer has not played a move (1-7)
-    int playColumn = 8;
-    
-    if (turn <= 2) {
-        // play the computers first two moves to give the computer a strong start
-        playColumn = playFirstTwoMoves(gameBoard, computerChar, opponentChar, playColumn, turn);
-    // after the first two turns, resort to a pattern recognition approach
-    // instead of hardcoding every single possible move
-    } else {
-        // if the computer has 3 pieces in a row, check if the computer can play
-        // a piece to win and play it if it can
-        playColumn = threeInARow(gameBoard, computerChar, computerChar);
-        
-        // if the computer has not made a move yet, move on to next step
-        // of computer logic
-        if (playColumn == 8) {
-        // if the opponent has 3 pieces in a row, check if the computer can play
-        // a piece to defend and if it can play it
-            playColumn = threeInARow(gameBoard, computerChar, opponentChar);
-        }
-        
-        // if the computer has not made a move yet, move on to next step
-        // of computer logic
-        if (playColumn == 8) {
-            // call the play best move function to play the best move for the computer
-            playColumn = playBestMove(gameBoard, computerChar, opponentChar);
-        }
-        
-        // if the computer has not made a move yet, move on to next step
-        // of computer logic
-        if (playColumn == 8) {
-            // if the computer has not made a move yet, pick a random column to play
-            // a move. At this point it is likely the computer has no move it can make
-            // that does not let the player win
-            playColumn = playRandomMove(gameBoard, computerChar);
+int runDatabaseQueryCommand(int argc, char** argv) {
+    // the database
+    GameDatabase* database = openDatabase(argv[2], 0);
+    // the moves to the position
+    const char* moves = ((argc >= 4) && (argv[3][0] != '-')) ? argv[3] : "";
+    // the number of games to list
+    size_t limit = (size_t)atoll(findOption(argc, argv, "--limit", "10"));
+    // the position
+    Position position;
+    SolverBoard board;
+    // the number of games with each result and the games found
+    uint64_t counts[4];
+    uint64_t* games = NULL;
+    size_t gameCount = 0;
+    // the moves of a game found
+    char gameMoves[NUM_CELLS + 1];
+    // the time the query started
+    double start = monotonicSeconds();
+    // the counter for the games
+    size_t i = 0;
+
+    if (database == NULL) {
+        printf("Could not open the database '%s'\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    initPosition(&position);
+    if (playMoveString(&position, moves) < 0) {
+        printf("Invalid move string '%s'\n", moves);
+        closeDatabase(database);
+        return EXIT_FAILURE;
+    }
+    if (position.moveCount > database->indexPlies) {
+        printf("Only the first %d plies of each game are indexed\n", database->indexPlies);
+        closeDatabase(database);
+        return EXIT_FAILURE;
+    }
+    loadSolverBoard(&board, &position);
+    games = malloc(((limit > 0) ? limit : 1) * sizeof(uint64_t));
+    if ((games == NULL) || (!queryDatabase(database, canonicalKey(&board), counts, games, limit, &gameCount))) {
+        printf("Could not read the database '%s'\n", argv[2]);
+        free(games);
+        closeDatabase(database);
+        return EXIT_FAILURE;
+    }
+    printf("position %s games %llu first %llu second %llu draw %llu unfinished %llu time %.3f ms\n", moves, (unsigned long long)(counts[0] + counts[1] + counts[2] + counts[3]), (unsigned long long)counts[RESULT_FIRST_WIN], (unsigned long long)counts[RESULT_SECOND_WIN], (unsigned long long)counts[RESULT_DRAW], (unsigned long long)counts[RESULT_UNFINISHED], (monotonicSeconds() - start) * 1000);
+    // games that reached the mirror image of the position are listed as they were played
+    for (i = 0; i < gameCount; i++) {
+        int result = readDatabaseGame(database, games[i], gameMoves);
+        if (result >= 0) {
+            printf("game %llu %s %s\n", (unsigned long long)games[i], resultNames[result], gameMoves);
         }
     }
-     
-    // print a message telling the user where the computer played. 1 is added
-    // to the column because the gameboard indexes are 0 - 6 but the players
-    // play on a board with columns 1 - 7
-    printf("\nThe computer plays its piece in column %d\n", playColumn + 1);
+    free(games);
+    closeDatabase(database);
 
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      To print every value at every index in the game board array
+ *      To play games of one player against itself on every thread and print
+ *      how each opening sequence turned out. Each thread counts into its own
+ *      opening tree and the trees are added together once every game is played.
  * Parameters:
- *      gameBoard - the gameboard array
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments: openings and options
  * Returns:
- *      NONE
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the arguments are invalid
  * Side-Effects:
- *      NONE - gameboard is const as it is only printed and no indexes are modified
+ *      The opening tree is printed
  */
-void printGameboard(const char gameBoard[numColumns][numRows]) {
-    // Counter for the rows. start at the last index so the gameboard is printed
-    // the right way for the user
-    int i = numRows - 1;
-    // counter for the columns
-    int j = 0;
+int runOpeningsCommand(int argc, char** argv) {
+    // the shared run state
+    OpeningStatistics statistics;
+    // the threads and their trees
+    OpeningWorker* workers = NULL;
+    pthread_t* threads = NULL;
+    int threadCount = atoi(findOption(argc, argv, "--threads", "0"));
+    // the fewest games an opening must have to be printed
+    long long minGames = atoll(findOption(argc, argv, "--min-games", "100"));
+    // the number of nodes in a tree
+    size_t nodeCount = 0;
+    // the move sequence printed
+    char moves[MAX_OPENING_DEPTH + 2] = "";
+    // the time the run started
+    double start = monotonicSeconds();
+    // counters for the threads and nodes
+    int t = 0;
+    size_t i = 0;
 
-    // print the gameboard going across each column index incrementing by 1 and
-    // then going down row by row, incrementing the row counter down by 1 each cycle of the loop
-    printf("_____________________________\n");
-    while (i >= 0) {
-        printf("|");
-        for (j = 0; j < numColumns; j++) {
-            printf(" %c |",gameBoard[j][i]);
+    memset(&statistics, 0, sizeof(statistics));
+    statistics.depth = atoi(findOption(argc, argv, "--depth", "4"));
+    statistics.gameCount = atoll(findOption(argc, argv, "--games", "10000"));
+    statistics.seed = strtoull(findOption(argc, argv, "--seed", "1"), NULL, 10);
+    statistics.calibration.openingPlies = atoi(findOption(argc, argv, "--random-plies", "2"));
+    statistics.calibration.playerCount = 1;
+    if ((!parsePlayer(findOption(argc, argv, "--player", "heuristic"), &statistics.calibration.players[0])) || (statistics.depth < 1) || (statistics.depth > MAX_OPENING_DEPTH) || (statistics.gameCount <= 0) || (statistics.calibration.openingPlies < 0) || (statistics.calibration.openingPlies >= NUM_CELLS)) {
+        printf("Invalid arguments\n");
+        return EXIT_FAILURE;
+    }
+    if (threadCount <= 0) {
+        threadCount = countCores();
+    }
+    nodeCount = openingBase(statistics.depth + 1);
+    atomic_init(&statistics.nextGame, 0);
+    workers = calloc(threadCount, sizeof(OpeningWorker));
+    threads = calloc(threadCount, sizeof(pthread_t));
+    for (t = 0; (workers != NULL) && (t < threadCount); t++) {
+        workers[t].statistics = &statistics;
+        workers[t].nodes = allocateTable(MEMORY_OPENINGS, nodeCount * sizeof(OpeningNode));
+        if (workers[t].nodes == NULL) {
+            threadCount = t;
         }
-        printf("\n");
-        i--;
     }
-    printf("-----------------------------\n");
-    // print labels for the columns to make it easier to read
-    printf("| 1 | 2 | 3 | 4 | 5 | 6 | 7 |\n");
-
+    if ((workers == NULL) || (threads == NULL) || (threadCount == 0)) {
+        printf("Could not allocate a %.1f MB opening tree\n", nodeCount * sizeof(OpeningNode) / 1048576.0);
+        free(workers);
+        free(threads);
+        return EXIT_FAILURE;
+    }
+    for (t = 0; t < threadCount; t++) {
+        pthread_create(&threads[t], NULL, runOpeningWorker, &workers[t]);
+    }
+    for (t = 0; t < threadCount; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    // the trees of the other threads are added to the first
+    for (t = 1; t < threadCount; t++) {
+        for (i = 0; i < nodeCount; i++) {
+            workers[0].nodes[i].games += workers[t].nodes[i].games;
+            workers[0].nodes[i].results[0] += workers[t].nodes[i].results[0];
+            workers[0].nodes[i].results[1] += workers[t].nodes[i].results[1];
+            workers[0].nodes[i].results[2] += workers[t].nodes[i].results[2];
+            workers[0].nodes[i].nanoseconds += workers[t].nodes[i].nanoseconds;
+            workers[0].nodes[i].nodes += workers[t].nodes[i].nodes;
+        }
+        freeTable(MEMORY_OPENINGS, workers[t].nodes, nodeCount * sizeof(OpeningNode));
+    }
+    printOpeningTree(workers[0].nodes, statistics.depth, minGames, moves, 0);
+    printf("player %s games %lld threads %d time %.1f\n", statistics.calibration.players[0].name, statistics.gameCount, threadCount, monotonicSeconds() - start);
+    freeTable(MEMORY_OPENINGS, workers[0].nodes, nodeCount * sizeof(OpeningNode));
+    free(workers);
+    free(threads);
 
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      To print a message to the winning player
+ *      To pack a game of the multiplex command while it waits for its next line.
+ *      The bitboards are built from the moves played, one add and mask each.
  * Parameters:
- *      player - the player number
- *      gameMode - the game mode the user is playing
+ *      game - the game
+ *      hosted - the hosted game to fill
  * Returns:
  *      NONE
  * Side-Effects:
+ *      hosted is overwritten
+ */
+void hostGame(const GameState* game, HostedGame* hosted) {
+    // the pieces of the player who moved first and every piece
+    uint64_t first = 0;
+    uint64_t occupied = 0;
+    // the clocks of the player who moved first and second, the game keeps
+    // them by player number
+    double clocks[2] = {game->clocks[game->playerNumbers[0] - 1], game->clocks[game->playerNumbers[1] - 1]};
+    // the counter for the moves
+    int i = 0;
+
+    memset(hosted->moveColumns, 0, sizeof(hosted->moveColumns));
+    for (i = 0; i < game->moveCount; i++) {
+        // the column played and the cell its piece landed in
+        int column = game->moves[i] - '1';
+        uint64_t cell = (occupied + bottomMask) & columnMask(column);
+        occupied |= cell;
+        first |= (i & 1) ? 0 : cell;
+        hosted->moveColumns[i / HOSTED_MOVES_PER_WORD] |= (uint64_t)column << (3 * (i % HOSTED_MOVES_PER_WORD));
+    }
+    packSession(&hosted->session, first, occupied, game->playerChars[0], game->playerChars[1], clocks, SESSION_STARTED | (game->computer[0] ? SESSION_COMPUTER : 0) | ((game->status == GAME_FINISHED) ? SESSION_FINISHED : 0));
+    hosted->moveStart = game->moveStart;
+}
+
+/*
+ * Purpose:
+ *      To unpack a hosted game of the multiplex command so a line can be given to it
+ * Parameters:
+ *      hosted - the hosted game
+ *      game - the game to set up
+ * Returns:
  *      NONE
+ * Side-Effects:
+ *      game is overwritten
  */
-void printWinMessage(int player, char gameMode) {
-    // if the gamemode is user v computer and the player is #2 (the computer)
-    // print message saying the computer won
-    if ((gameMode == 'c') && (player == 2)){
-        printf("\nToo bad. The computer won!\n");
-    // the game was not against the computer
+void resumeGame(const HostedGame* hosted, GameState* game) {
+    // the game board of the game
+    char gameBoard[numColumns][numRows];
+    // the pieces of the player who moved first and every piece
+    uint64_t first = 0;
+    uint64_t occupied = 0;
+    // the characters of the player who moved first and second
+    char firstChar = hosted->session.playerChars[0];
+    char secondChar = hosted->session.playerChars[1];
+    // the counter for the moves
+    int i = 0;
+
+    unpackSession(&hosted->session, &first, &occupied, NULL);
+    bitboardToBoard(gameBoard, first, occupied, firstChar, secondChar);
+    // against the computer initGame puts the computer, the second character, first
+    if (hosted->session.flags & SESSION_COMPUTER) {
+        initGame(game, gameBoard, secondChar, firstChar, 'c', hosted->session.moveCount, 0);
     } else {
-        printf("\nCongratulations player %d. You won!\n", player);
-        printf("\n");
+        initGame(game, gameBoard, firstChar, secondChar, 'p', hosted->session.moveCount, 0);
+    }
+    for (i = 0; i < hosted->session.moveCount; i++) {
+        game->moves[i] = '1' + ((hosted->moveColumns[i / HOSTED_MOVES_PER_WORD] >> (3 * (i % HOSTED_MOVES_PER_WORD))) & 7);
     }
+    game->moveCount = hosted->session.moveCount;
+    game->lastColumn = (game->moveCount > 0) ? game->moves[game->moveCount - 1] - '1' : 0;
+    game->side = game->moveCount & 1;
+    game->clocks[game->playerNumbers[0] - 1] = hosted->session.clocks[0] / 10.0;
+    game->clocks[game->playerNumbers[1] - 1] = hosted->session.clocks[1] / 10.0;
+    game->moveStart = hosted->moveStart;
+    game->status = (hosted->session.flags & SESSION_FINISHED) ? GAME_FINISHED : GAME_WAITING;
 }
 
 /*
  * Purpose:
- *      To print a message if the game ends in a tie
+ *      To print what happened in a game after a line of the multiplex command:
+ *      the computer moves played since the given move and whether the game is
+ *      waiting for a move or over
  * Parameters:
- *      NONE
+ *      id - the id of the game
+ *      game - the game
+ *      fromMove - the number of moves the game had before the computer moved
  * Returns:
  *      NONE
  * Side-Effects:
  *      NONE
  */
-void printTieMessage() {
-    printf("Good Effort! You Tied.\n");
-    printf("\n");
+void printMultiplexGame(const int id, const GameState* game, int fromMove) {
+    for (; fromMove < game->moveCount; fromMove++) {
+        printf("game %d computer %c\n", id, game->moves[fromMove]);
+    }
+    if (game->status == GAME_WAITING) {
+        printf("game %d waiting player %d\n", id, game->playerNumbers[game->side]);
+    } else if (game->winner == 0) {
+        printf("game %d over tie\n", id);
+    } else {
+        printf("game %d over player %d\n", id, game->winner);
+    }
 }
 
 /*
  * Purpose:
- *      To play a game of user v user/computer connect 4
+ *      To run many games on one thread, each stepped only when a line for it
+ *      arrives on standard input. The lines are "new <id> [computer|human]",
+ *      which starts a game against the computer (moving first) or between two
+ *      people, "move <id> <column>" and "quit". Between its lines a game is
+ *      held packed, and only the game a line is for is unpacked.
  * Parameters:
- *      gameBoard - the array of the gameboard
- *      userChar - the first players character
- *      playerTwoChar - the second players/computers character
- *      gameMode - the gamemode 
- *      turn - the turn the game is on
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments
  * Returns:
- *      NONE
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the games could not be allocated
  * Side-Effects:
- *      The gameboard array is modified in functions called by this one
+ *      Finished games are appended to the game log
  */
-void playGame(char gameBoard[numColumns][numRows], const char userChar, const char playerTwoChar, const char gameMode, int turn) {
-    // variable to store which player is playing first
-    int firstPlayer = 1;
-    // variable to store which player is playing second
-    int secondPlayer = 2;
-    // variable to store the character of the player playing first
-    char firstPlayerChar = userChar;
-    // variable to store the character of the player playing second
-    char secondPlayerChar = playerTwoChar;
-    // variable to store if a player has won the game
-    int winGame = 0;
-    
-    if (gameMode == 'c') {
-        // the computer is player 2 however it always plays first so this variable
-        // is updated to reflect this
-        firstPlayer = 2;
-        // the user is always player one but it plays second in a game against the computer
-        // so this variable is updated to reflect this
-        secondPlayer = 1;
-        // the computers character is playerTwoChar however the computer is the first
-        // player in this game mode so this variable is updated to reflect this
-        firstPlayerChar = playerTwoChar;
-        // the players character is userChar however the user player is the second
-        // player so this variable is updated to reflect this
-        secondPlayerChar = userChar;
+int runMultiplexCommand(int argc, char** argv) {
+    // the number of games that can be played at once, the ids are 0 to count - 1
+    int count = atoi(findOption(argc, argv, "--games", "64"));
+    // the games, packed while they wait for their next line
+    HostedGame* games = NULL;
+    // the game a line is for, unpacked while it is played
+    GameState game;
+    // the line read, its command word and its mode or column
+    char line[GAME_LOG_LINE];
+    char word[16];
+    char argument[16];
+    // the id of the game the line is for
+    int id = 0;
+    // the number of moves the game had before the line
+    int fromMove = 0;
+    // the number of fields read from the line
+    int fields = 0;
+
+    if (count <= 0) {
+        printf("Invalid game count\n");
+        return EXIT_FAILURE;
     }
-    
-    // while the game board is not full (when the number of turns is less than the
-    // size of the board), alternate player and computer taking turns
-    while (turn < (numRows * numColumns)) {
-        // if the user is playing against the computer the first move of every set
-        // of two moves is the computer move
-        if (gameMode == 'c') {
-            computerTurn(playerTwoChar, gameBoard, userChar, turn);
-        // user is playing another user so the first user makes the first of each
-        // set of two moves (player 1 goes then player 2 and so on)
-        } else {
-            playerTurn(userChar, gameBoard, 1);
-        }
-        // print the gameBoard after each turn
-        printGameboard(gameBoard);
-        
-        // if the first player has won, print a message to them and break the game
-        // loop to end the current game
-        winGame = checkWinGame(gameBoard, firstPlayerChar);
-        if (winGame) {
-            printWinMessage(firstPlayer, gameMode);
-            break;
-        }
-        // it is the second players turn. No matter the gamemode a player will
-        // be making a move here but depending on the mode this player will either
-        // be player 1 as the live user against the computer or player two as a live
-        // player against a live user who is player one
-        playerTurn(secondPlayerChar, gameBoard, secondPlayer);
-        // print gameBoard after each move
-        printGameboard(gameBoard);
-        
-        // if the second player has won, print a message to them and break the game
-        // loop to end the current game
-        winGame = checkWinGame(gameBoard, secondPlayerChar);
-        if (winGame) {
-            printWinMessage(secondPlayer, gameMode);
+    if (clockBase * 10 > SESSION_MAX_CLOCK) {
+        printf("The clocks of hosted games hold at most %d seconds\n", SESSION_MAX_CLOCK / 10);
+        return EXIT_FAILURE;
+    }
+    games = allocateTable(MEMORY_GAMES, (size_t)count * sizeof(HostedGame));
+    if (games == NULL) {
+        printf("Could not allocate %d games\n", count);
+        return EXIT_FAILURE;
+    }
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        argument[0] = '\0';
+        fields = sscanf(line, "%15s %d %15s", word, &id, argument);
+        if ((fields >= 1) && (strcmp(word, "quit") == 0)) {
             break;
         }
-        // two turns have been played (1 each) so increment turn counter by 2
-        turn += 2;
+        if ((fields < 2) || (id < 0) || (id >= count)) {
+            printf("invalid %s", line);
+        } else if (strcmp(word, "new") == 0) {
+            // the empty board the game starts from
+            char gameBoard[numColumns][numRows];
 
-        // if the board is full, print a message telling the players they tied
-        if (turn == numRows * numColumns) {
-            printTieMessage();
+            setGameBoard(gameBoard);
+            initGame(&game, gameBoard, 'X', 'Y', (strcmp(argument, "human") == 0) ? 'p' : 'c', 0, 0);
+            stepGame(&game);
+            printMultiplexGame(id, &game, 0);
+            hostGame(&game, &games[id]);
+        } else if ((strcmp(word, "move") == 0) && (games[id].session.flags & SESSION_STARTED) && (fields == 3)) {
+            resumeGame(&games[id], &game);
+            fromMove = game.moveCount + 1;
+            if (submitMove(&game, atoi(argument)) == GAME_INVALID) {
+                printf("game %d invalid %s\n", id, argument);
+            } else {
+                printMultiplexGame(id, &game, fromMove);
+                hostGame(&game, &games[id]);
+            }
+        } else {
+            printf("invalid %s", line);
         }
+        fflush(stdout);
     }
+    freeTable(MEMORY_GAMES, games, (size_t)count * sizeof(HostedGame));
+
+    return EXIT_SUCCESS;
 }
 
 /*
  * Purpose:
- *      To print a message if the user wants to quit
+ *      To count and time the games of a number of moves on a board whose size
+ *      is picked at run time. A board that fits in one word is timed again
+ *      through the loops over words by spreading it over two words, and the
+ *      standard board is timed against the fixed size bitboards as well.
  * Parameters:
- *      NONE
+ *      columns - the number of columns
+ *      rows - the number of rows
+ *      connectLength - the number of pieces to connect to win
+ *      depth - the number of moves to play
  * Returns:
- *      NONE
+ *      EXIT_SUCCESS, or EXIT_FAILURE if the board size is not supported or
+ *      the counts do not match
  * Side-Effects:
  *      NONE
  */
-void printQuitMessage() {
-    printf("Thank you for playing connect four!\n");
-    printf("Have a nice day!!");
+int runWideGamesCommand(const int columns, const int rows, const int connectLength, const int depth) {
+    // the size of the board and the empty position on it
+    WideLayout layout;
+    WidePosition position;
+    // the same board spread over two words and the empty position on it
+    WideLayout spreadLayout;
+    WidePosition spreadPosition;
+    // the number of games on the wide, spread and fixed size boards
+    long long wideGames = 0;
+    long long spreadGames = 0;
+    long long fixedGames = 0;
+    // the time the count started and how long each count took
+    double start = 0;
+    double wideSeconds = 0;
+    double spreadSeconds = 0;
+    double fixedSeconds = 0;
+
+    if (!initWideLayout(&layout, columns, rows, connectLength) || (depth < 0)) {
+        printf("Invalid arguments\n");
+        return EXIT_FAILURE;
+    }
+    initWidePosition(&position, &layout);
+    start = monotonicSeconds();
+    wideGames = countWideGames(&position, depth);
+    wideSeconds = monotonicSeconds() - start;
+    printf("board %dx%d connect %d words %d depth %d games %lld time %.3f rate %.0f games/s\n", columns, rows, connectLength, layout.wordCount, depth, wideGames, wideSeconds, wideGames / ((wideSeconds > 0) ? wideSeconds : 1e-9));
+
+    // the words above the board are empty, so a one word board can be counted
+    // as a two word board to time the loops over words on the same games
+    if (layout.wordCount == 1) {
+        spreadLayout = layout;
+        spreadLayout.wordCount = 2;
+        initWidePosition(&spreadPosition, &spreadLayout);
+        start = monotonicSeconds();
+        spreadGames = countWideGames(&spreadPosition, depth);
+        spreadSeconds = monotonicSeconds() - start;
+        printf("two word games %lld time %.3f two word/one word %.2f\n", spreadGames, spreadSeconds, spreadSeconds / ((wideSeconds > 0) ? wideSeconds : 1e-9));
+        if (spreadGames != wideGames) {
+            printf("The game counts do not match\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((columns == BOARD_COLUMNS) && (rows == BOARD_ROWS) && (connectLength == CONNECT_LENGTH)) {
+        start = monotonicSeconds();
+        fixedGames = countFixedGames(0, 0, depth);
+        fixedSeconds = monotonicSeconds() - start;
+        printf("fixed size games %lld time %.3f wide/fixed %.2f\n", fixedGames, fixedSeconds, wideSeconds / ((fixedSeconds > 0) ? fixedSeconds : 1e-9));
+        if (fixedGames != wideGames) {
+            printf("The game counts do not match\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
 }
 
+/*
+ * Purpose:
+ *      To run one of the command line modes instead of an interactive game
+ * Parameters:
+ *      argc - the number of command line arguments
+ *      argv - the command line arguments
+ * Returns:
+ *      The exit status of the mode
+ * Side-Effects:
+ *      NONE
+ */
+int runCommand(int argc, char** argv) {
+    // the mode to run
+    const char* command = argv[1];
+
+    if ((strcmp(command, "search") == 0) && (argc >= 3)) {
+        return runSearchCommand(atoi(argv[2]), (argc >= 4) ? argv[3] : "");
+    }
+    if ((strcmp(command, "solve") == 0) && (argc >= 3)) {
+        return runSolveCommand(atoi(argv[2]), (argc >= 4) ? argv[3] : "");
+    }
+    if ((strcmp(command, "enumerate") == 0) && (argc >= 4)) {
+        return runEnumerateCommand(atoi(argv[2]), atoi(argv[3]), (argc >= 5) ? atoi(argv[4]) : 0, (argc >= 6) ? argv[5] : "");
+    }
+    if ((strcmp(command, "generate") == 0) && (argc >= 4)) {
+        return runGenerateCommand(argc, argv);
+    }
+    if (strcmp(command, "evaluate") == 0) {
+        return runEvaluateCommand(((argc >= 3) && (argv[2][0] != '-')) ? argv[2] : "");
+    }
+    if ((strcmp(command, "network-init") == 0) && (argc >= 3)) {
+        if (!writeLineNetwork(argv[2])) {
+            printf("Could not write '%s'\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    if ((strcmp(command, "book-build") == 0) && (argc >= 4)) {
+        return runBookBuildCommand(argc, argv);
+    }
+    if ((strcmp(command, "book-query") == 0) && (argc >= 3)) {
+        return runBookQueryCommand(argv[2], ((argc >= 4) && (argv[3][0] != '-')) ? argv[3] : "");
+    }
+    if ((strcmp(command, "analyze") == 0) && (argc >= 3)) {
+        return runAnalyzeCommand(argc, argv);
+    }
+    if (strcmp(command, "engine") == 0) {
+        return runEngineCommand(atoi(findOption(argc, argv, "--megabytes", "64")));
+    }
+    if (strcmp(command, "multipv") == 0) {
+        return runMultiPvCommand(argc, argv);
+    }
+    if (strcmp(command, "calibrate") == 0) {
+        return runCalibrateCommand(argc, argv);
+    }
+    if ((strcmp(command, "sessions") == 0) && (argc >= 3)) {
+        return runSessionsCommand(argc, argv);
+    }
+    if ((strcmp(command, "db-add") == 0) && (argc >= 4)) {
+        return runDatabaseAddCommand(argc, argv);
+    }
+    if ((strcmp(command, "db-query") == 0) && (argc >= 3)) {
+        return runDatabaseQueryCommand(argc, argv);
+    }
+    if (strcmp(command, "openings") == 0) {
+        return runOpeningsCommand(argc, argv);
+    }
+    if (strcmp(command, "multiplex") == 0) {
+        return runMultiplexCommand(argc, argv);
+    }
+    if ((strcmp(command, "wide-games") == 0) && (argc >= 6)) {
+        return runWideGamesCommand(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), atoi(argv[5]));
+    }
+    if ((strcmp(command, "prove") == 0) && (argc >= 3)) {
+        return runProveCommand(atoi(argv[2]), (argc >= 4) ? argv[3] : "");
+    }
+    printUsage(argv[0]);
+
+    return EXIT_FAILURE;
+}
 
 int main(int argc, char** argv) {
     // array for the game board
@@ -1607,8 +10487,71 @@ int main(int argc, char** argv) {
     // // initiate variable to store the character to represent the second players pieces
     char playerTwoChar = 'x';
     
-    // seed random number generator
-    srand(time(NULL));
+    // seed the random moves of the game, a seed given with --seed repeats a game
+    if (findOption(argc, argv, "--seed", NULL) != NULL) {
+        seedRandom(&gameRandom, strtoull(findOption(argc, argv, "--seed", NULL), NULL, 10));
+    } else {
+        seedRandom(&gameRandom, (uint64_t)time(NULL));
+    }
+    // bound the memory of the caches and tables, they are shrunk or refused
+    // rather than grow past the budget
+    memoryBudget.budget = (size_t)(atof(findOption(argc, argv, "--memory", "0")) * 1048576);
+    if (hasFlag(argc, argv, "--memory-stats")) {
+        atexit(printMemoryStatistics);
+    }
+    // build the winning line tables used by the win checks
+    initLineTables();
+    // place the patterns of the rule based computer on the winning lines
+    initLinePatterns();
+    // build the line values used by the computer search
+    initLineValues();
+
+    // use an n-tuple network for the search evaluation if one was given
+    if (findOption(argc, argv, "--network", NULL) != NULL) {
+        activeNetwork = loadNetwork(findOption(argc, argv, "--network", NULL));
+        if (activeNetwork == NULL) {
+            printf("Could not load the network '%s'\n", findOption(argc, argv, "--network", NULL));
+            return EXIT_FAILURE;
+        }
+    }
+
+    // let the solver take early scores from an opening book if one was given
+    if (findOption(argc, argv, "--book", NULL) != NULL) {
+        activeBook = loadBook(findOption(argc, argv, "--book", NULL));
+        if (activeBook == NULL) {
+            printf("Could not load the book '%s'\n", findOption(argc, argv, "--book", NULL));
+            return EXIT_FAILURE;
+        }
+    }
+
+    // the clocks used by the interactive game, if any
+    clockBase = atof(findOption(argc, argv, "--time", "0"));
+    clockIncrement = atof(findOption(argc, argv, "--increment", "0"));
+    gameLogName = findOption(argc, argv, "--log", NULL);
+    if (strcmp(findOption(argc, argv, "--board", "grid"), "moves") == 0) {
+        boardStyle = BOARD_STYLE_MOVES;
+    } else if (strcmp(findOption(argc, argv, "--board", "grid"), "fen") == 0) {
+        boardStyle = BOARD_STYLE_FEN;
+    }
+    // time the stages of the computers moves and print them on exit or on SIGUSR1
+    if (hasFlag(argc, argv, "--profile")) {
+        profilingEnabled = 1;
+        signal(SIGUSR1, requestProfileDump);
+        atexit(printStageProfile);
+    }
+    // save the progress of long solves and book builds, which catch SIGTERM and
+    // SIGINT to save it before stopping while they run
+    checkpointName = findOption(argc, argv, "--checkpoint", NULL);
+    checkpointInterval = atof(findOption(argc, argv, "--checkpoint-interval", "300"));
+    if (hasFlag(argc, argv, "--quiet")) {
+        quietMode = 1;
+        boardStyle = BOARD_STYLE_NONE;
+    }
+
+    // a command line mode was given so run it instead of an interactive game
+    if ((argc > 1) && (argv[1][0] != '-')) {
+        return runCommand(argc, argv);
+    }
     
     // play game until user wants to quit
     while (1) {